@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: BSD-3-Clause 
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved. 
+
+/*
+    Compares the per-call cost of Expr::evaluate, which validates its arguments on each call, with
+    the typed handle returned by Expr::bind
+*/
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t NUM_CALLS = 10000000;
+
+double elapsed_ns_per_call(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(NUM_CALLS);
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Error);
+
+    mathexpr::Expr expr("a * b + c");
+
+    if(!expr.compile())
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    auto func = expr.bind<3>();
+
+    if(!func)
+    {
+        mathexpr::log_error("Error while binding expression");
+        return 1;
+    }
+
+    double sum = 0.0;
+
+    const auto evaluate_start = Clock::now();
+
+    for(size_t i = 0; i < NUM_CALLS; i++)
+    {
+        auto [success, res] = expr.evaluate(static_cast<double>(i), 0.5, 1.0);
+        sum += res;
+    }
+
+    const auto bind_start = Clock::now();
+
+    for(size_t i = 0; i < NUM_CALLS; i++)
+        sum += func(static_cast<double>(i), 0.5, 1.0);
+
+    const auto bind_end = Clock::now();
+
+    std::cout << std::format("{:<10} {:>10.2f} ns/call\n", "evaluate", elapsed_ns_per_call(evaluate_start, bind_start));
+    std::cout << std::format("{:<10} {:>10.2f} ns/call\n", "bind", elapsed_ns_per_call(bind_start, bind_end));
+
+    /* Keeps the loops from being optimized out */
+    std::cout << std::format("checksum: {}\n", sum);
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: BSD-3-Clause 
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved. 
+
+/*
+    Measures how the compilation stages scale with the size of the expression. The register
+    allocator is expected to grow linearly with the number of SSA statements
+*/
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/lexer.hpp"
+#include "mathexpr/ast.hpp"
+#include "mathexpr/symtable.hpp"
+#include "mathexpr/ssa.hpp"
+#include "mathexpr/regalloc.hpp"
+#include "mathexpr/codegen.hpp"
+#include "mathexpr/platform.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t NUM_REPETITIONS = 10;
+
+/* Variables offsets are encoded on 8 bits, stay in the range */
+static constexpr const char* VARIABLES[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+static constexpr const char* OPERATORS[] = { " + ", " * ", " - ", " / " };
+
+struct Timings
+{
+    double frontend = std::numeric_limits<double>::max();
+    double regalloc = std::numeric_limits<double>::max();
+    double codegen = std::numeric_limits<double>::max();
+    size_t num_statements = 0;
+};
+
+/* a + b * c - d / e + ... */
+std::string generate_chain(size_t num_terms, bool with_calls)
+{
+    std::string expression;
+
+    for(size_t i = 0; i < num_terms; i++)
+    {
+        if(i > 0)
+            expression.append(OPERATORS[i % 4]);
+
+        if(with_calls && (i % 4) == 3)
+            std::format_to(std::back_inserter(expression), "sqrt({})", VARIABLES[i % 8]);
+        else
+            expression.append(VARIABLES[i % 8]);
+    }
+
+    return expression;
+}
+
+/* ((a + b) * (c - d)) + ((e / f) + (g * h)) ... */
+std::string generate_balanced(size_t depth, size_t index = 0)
+{
+    if(depth == 0)
+        return VARIABLES[index % 8];
+
+    return std::format("({}{}{})",
+                       generate_balanced(depth - 1, index * 2),
+                       OPERATORS[depth % 4],
+                       generate_balanced(depth - 1, index * 2 + 1));
+}
+
+double elapsed_us(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+bool time_compilation(const std::string& expression, mathexpr::PlatformABIPtr platform_abi, Timings& timings)
+{
+    for(size_t i = 0; i < NUM_REPETITIONS; i++)
+    {
+        const auto frontend_start = Clock::now();
+
+        auto [lex_success, tokens] = mathexpr::lexer_lex_expression(expression);
+
+        mathexpr::AST ast;
+
+        if(!lex_success || !ast.build_from_tokens(tokens))
+            return false;
+
+        mathexpr::SymbolTable symtable;
+        symtable.collect(ast);
+
+        mathexpr::SSA ssa;
+
+        if(!ssa.build_from_ast(ast))
+            return false;
+
+        const auto regalloc_start = Clock::now();
+
+        timings.num_statements = ssa.get_statements().size();
+
+        mathexpr::RegisterAllocator reg_allocator(platform_abi);
+
+        if(!reg_allocator.allocate(ssa, symtable))
+            return false;
+
+        const auto codegen_start = Clock::now();
+
+        mathexpr::CodeGenerator generator(mathexpr::get_current_isa(), platform_abi);
+
+        if(!generator.build(ssa, reg_allocator, symtable))
+            return false;
+
+        mathexpr::Relocations relocs;
+
+        auto [gen_success, bytecode] = generator.as_bytecode(relocs);
+
+        if(!gen_success)
+            return false;
+
+        const auto codegen_end = Clock::now();
+
+        timings.frontend = std::min(timings.frontend, elapsed_us(frontend_start, regalloc_start));
+        timings.regalloc = std::min(timings.regalloc, elapsed_us(regalloc_start, codegen_start));
+        timings.codegen = std::min(timings.codegen, elapsed_us(codegen_start, codegen_end));
+    }
+
+    return true;
+}
+
+bool run_benchmark(std::string_view name, const std::string& expression, mathexpr::PlatformABIPtr platform_abi)
+{
+    Timings timings;
+
+    if(!time_compilation(expression, platform_abi, timings))
+    {
+        mathexpr::log_error("Error while compiling {} expression", name);
+        return false;
+    }
+
+    std::cout << std::format("{:<10} {:>10} {:>14.1f} {:>14.1f} {:>14.1f} {:>18.1f}\n",
+                             name,
+                             timings.num_statements,
+                             timings.frontend,
+                             timings.regalloc,
+                             timings.codegen,
+                             timings.regalloc * 1000.0 / static_cast<double>(timings.num_statements));
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Error);
+
+    mathexpr::PlatformABIPtr platform_abi = mathexpr::get_current_platform_abi(mathexpr::get_current_isa(),
+                                                                     mathexpr::get_current_platform());
+
+    if(platform_abi == nullptr)
+    {
+        mathexpr::log_error("Current ABI is not supported");
+        return 1;
+    }
+
+    std::cout << std::format("{:<10} {:>10} {:>14} {:>14} {:>14} {:>18}\n",
+                             "shape",
+                             "ssa stmts",
+                             "frontend (us)",
+                             "regalloc (us)",
+                             "codegen (us)",
+                             "regalloc (ns/stmt)");
+
+    for(size_t num_terms = 16; num_terms <= 4096; num_terms *= 4)
+    {
+        if(!run_benchmark("chain", generate_chain(num_terms, false), platform_abi))
+            return 1;
+
+        if(!run_benchmark("calls", generate_chain(num_terms, true), platform_abi))
+            return 1;
+    }
+
+    /* Register pressure grows with the depth, spills are needed past the number of fp registers */
+    for(size_t depth = 4; depth <= 12; depth += 2)
+    {
+        if(!run_benchmark("balanced", generate_balanced(depth), platform_abi))
+            return 1;
+    }
+
+    return 0;
+}
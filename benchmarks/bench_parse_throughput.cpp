@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+/*
+    Measures the parsing throughput on large generated polynomial fits, from the source to the SSA,
+    through the tokens and the AST and through the single pass parser
+*/
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/lexer.hpp"
+#include "mathexpr/ast.hpp"
+#include "mathexpr/symtable.hpp"
+#include "mathexpr/ssa.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t NUM_REPETITIONS = 5;
+
+static constexpr size_t MAX_DEGREE = 6;
+
+/*
+    Sum of c * x ^ i * y ^ j terms with random coefficients. Terms are summed pairwise so the nesting
+    of the expression grows with the log of its size
+*/
+std::string generate_polynomial(size_t num_terms)
+{
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> coefficients(-10.0, 10.0);
+
+    std::vector<std::string> terms;
+    terms.reserve(num_terms);
+
+    for(size_t i = 0; i < num_terms; i++)
+    {
+        terms.push_back(std::format("{:.9f} * x ^ {} * y ^ {}",
+                                    std::abs(coefficients(generator)),
+                                    1 + i % MAX_DEGREE,
+                                    1 + (i / MAX_DEGREE) % MAX_DEGREE));
+    }
+
+    while(terms.size() > 1)
+    {
+        std::vector<std::string> sums;
+        sums.reserve(terms.size() / 2 + 1);
+
+        for(size_t i = 0; i + 1 < terms.size(); i += 2)
+            sums.push_back(std::format("({} + {})", terms[i], terms[i + 1]));
+
+        if(terms.size() % 2 == 1)
+            sums.push_back(std::move(terms.back()));
+
+        terms = std::move(sums);
+    }
+
+    return terms.front();
+}
+
+/* Returns the best throughput over the repetitions, in MB/s, 0 on error */
+double measure_throughput(const std::string& expression, const std::function<bool()>& parse)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for(size_t i = 0; i < NUM_REPETITIONS; i++)
+    {
+        const auto start = Clock::now();
+
+        if(!parse())
+            return 0.0;
+
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    return static_cast<double>(expression.size()) / (1024.0 * 1024.0) / best;
+}
+
+bool run_benchmark(size_t num_terms)
+{
+    const std::string expression = generate_polynomial(num_terms);
+
+    const double lexer = measure_throughput(expression, [&]() {
+        auto [success, tokens] = mathexpr::lexer_lex_expression(expression);
+        return success;
+    });
+
+    const double ast = measure_throughput(expression, [&]() {
+        auto [success, tokens] = mathexpr::lexer_lex_expression(expression);
+
+        mathexpr::AST ast;
+
+        if(!success || !ast.build_from_tokens(tokens))
+            return false;
+
+        mathexpr::SymbolTable symtable;
+        symtable.collect(ast);
+
+        mathexpr::SSA ssa;
+
+        return ssa.build_from_ast(ast);
+    });
+
+    const double source = measure_throughput(expression, [&]() {
+        mathexpr::SymbolTable symtable;
+        mathexpr::SSA ssa;
+
+        return ssa.build_from_source(expression, symtable);
+    });
+
+    if(lexer == 0.0 || ast == 0.0 || source == 0.0)
+    {
+        mathexpr::log_error("Error while parsing the expression of {} terms", num_terms);
+        return false;
+    }
+
+    std::cout << std::format("{:>10} {:>12.2f} {:>14.1f} {:>16.1f} {:>16.1f}\n",
+                             num_terms,
+                             static_cast<double>(expression.size()) / (1024.0 * 1024.0),
+                             lexer,
+                             ast,
+                             source);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Error);
+
+    std::cout << std::format("{:>10} {:>12} {:>14} {:>16} {:>16}\n",
+                             "terms",
+                             "size (MB)",
+                             "lexer (MB/s)",
+                             "tokens+AST (MB/s)",
+                             "single pass (MB/s)");
+
+    for(size_t num_terms = 1024; num_terms <= 262144; num_terms *= 4)
+    {
+        if(!run_benchmark(num_terms))
+            return 1;
+    }
+
+    return 0;
+}
@@ -6,6 +6,9 @@
 
 BUILDTYPE="Release"
 RUNTESTS=0
+BUILDBENCHMARKS=0
+BUILDTOOLS=0
+KEEPFRAMEPOINTER=0
 REMOVEOLDDIR=0
 EXPORTCOMPILECOMMANDS=0
 VERSION="0.0.0"
@@ -21,6 +24,12 @@ parse_args()
 
     [ "$1" == "--tests" ] && RUNTESTS=1
 
+    [ "$1" == "--benchmarks" ] && BUILDBENCHMARKS=1
+
+    [ "$1" == "--tools" ] && BUILDTOOLS=1
+
+    [ "$1" == "--keep-frame-pointer" ] && KEEPFRAMEPOINTER=1
+
     [ "$1" == "--clean" ] && REMOVEOLDDIR=1
 
     [ "$1" == "--install" ] && INSTALL=1
@@ -87,7 +96,7 @@ if [[ -d "install" && $REMOVEOLDDIR -eq 1 ]]; then
     rm -rf install
 fi
 
-cmake -S . -B build -DRUN_TESTS=$RUNTESTS -DCMAKE_EXPORT_COMPILE_COMMANDS=$EXPORTCOMPILECOMMANDS -DCMAKE_BUILD_TYPE=$BUILDTYPE -DVERSION=$VERSION
+cmake -S . -B build -DRUN_TESTS=$RUNTESTS -DBUILD_BENCHMARKS=$BUILDBENCHMARKS -DBUILD_TOOLS=$BUILDTOOLS -DKEEP_FRAME_POINTER=$KEEPFRAMEPOINTER -DCMAKE_EXPORT_COMPILE_COMMANDS=$EXPORTCOMPILECOMMANDS -DCMAKE_BUILD_TYPE=$BUILDTYPE -DVERSION=$VERSION
 
 if [[ $? -ne 0 ]]; then
     log_error "Error during CMake configuration"
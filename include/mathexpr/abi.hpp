@@ -42,12 +42,16 @@ public:
     /* base ptr for the variables values is passed as the first parameter */
     virtual RegisterId get_variable_base_ptr() const noexcept = 0;
 
-    /* base ptr for the variables values is passed as the second parameter */
-    virtual RegisterId get_literal_base_ptr() const noexcept = 0;
+    /* base ptr for the outputs of expression groups is passed as the second parameter */
+    virtual RegisterId get_output_base_ptr() const noexcept = 0;
 
     /* register used to pass the address of a function when doing a function call */
     virtual RegisterId get_function_call_ptr() const noexcept = 0;
 
+    /* stack and frame pointer registers, spills are addressed relative to one of them */
+    virtual RegisterId get_stack_ptr() const noexcept = 0;
+    virtual RegisterId get_frame_ptr() const noexcept = 0;
+
     /*
         Returns the maximum number of registers that can be used simultaneously, used by
         the register allocator to know how many registers we can use
@@ -91,9 +95,9 @@ public:
 
     /* RCX */
     virtual RegisterId get_variable_base_ptr() const noexcept override;
+    virtual RegisterId get_output_base_ptr() const noexcept override;
 
     /* RDX */
-    virtual RegisterId get_literal_base_ptr() const noexcept override;
 
     /* 4 */
     virtual uint64_t get_max_available_gp_registers() const noexcept override;
@@ -122,6 +126,12 @@ public:
     /* RAX */
     virtual RegisterId get_function_call_ptr() const noexcept override { return GpRegisters_x86_64_RAX; }
 
+    /* RSP */
+    virtual RegisterId get_stack_ptr() const noexcept override { return GpRegisters_x86_64_RSP; }
+
+    /* RBP */
+    virtual RegisterId get_frame_ptr() const noexcept override { return GpRegisters_x86_64_RBP; }
+
     /* Windows function calls need 32 bytes of shadow space on the stack to spill arguments */
     virtual uint64_t get_fcall_shadow_space() const noexcept override { return 32; }
 
@@ -143,9 +153,9 @@ public:
 
     /* RDI */
     virtual RegisterId get_variable_base_ptr() const noexcept override;
+    virtual RegisterId get_output_base_ptr() const noexcept override;
 
     /* RSI */
-    virtual RegisterId get_literal_base_ptr() const noexcept override;
 
     /* 6 */
     virtual uint64_t get_max_available_gp_registers() const noexcept override;
@@ -174,6 +184,12 @@ public:
     /* RAX */
     virtual RegisterId get_function_call_ptr() const noexcept override { return GpRegisters_x86_64_RAX; }
 
+    /* RSP */
+    virtual RegisterId get_stack_ptr() const noexcept override { return GpRegisters_x86_64_RSP; }
+
+    /* RBP */
+    virtual RegisterId get_frame_ptr() const noexcept override { return GpRegisters_x86_64_RBP; }
+
     /* Same as Windows, SysV abi needs 8 bytes to store rbp */
     virtual uint64_t get_stack_base_offset() const noexcept override { return 8; }
 };
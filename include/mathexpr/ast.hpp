@@ -16,6 +16,14 @@
 
 MATHEXPR_NAMESPACE_BEGIN
 
+/* Builtin lowered without a call, select(cond, a, b) evaluates both a and b and picks one without branching */
+static constexpr std::string_view SELECT_FUNCTION_NAME = "select";
+
+/* Reductions over columns of values, only valid at the root of the expression of an ExprReduction */
+static constexpr std::string_view SUM_FUNCTION_NAME = "sum";
+static constexpr std::string_view MEAN_FUNCTION_NAME = "mean";
+static constexpr std::string_view DOT_FUNCTION_NAME = "dot";
+
 enum ASTNodeTypeId : int
 {
     ASTNodeTypeId_Variable = 1,
@@ -23,6 +31,7 @@ enum ASTNodeTypeId : int
     ASTNodeTypeId_UnOp = 3,
     ASTNodeTypeId_BinOp = 4,
     ASTNodeTypeId_FuncOp = 5,
+    ASTNodeTypeId_BindingRef = 6,
 };
 
 class MATHEXPR_API ASTNode
@@ -200,6 +209,38 @@ public:
     size_t get_arguments_count() const noexcept { return this->_arguments.size(); }
 };
 
+/* Reference to a name bound earlier in the expression (t = x * x; t + 1), shares the bound node */
+class MATHEXPR_API ASTNodeBindingRef : public ASTNode
+{
+    std::shared_ptr<ASTNode> _value;
+
+    std::string_view _name;
+
+public:
+    ASTNodeBindingRef(std::string_view name, 
+                      std::shared_ptr<ASTNode> value) : ASTNode(value->get_needs_reg()),
+                                                        _value(std::move(value)),
+                                                        _name(name) {}
+
+    virtual ~ASTNodeBindingRef() override {}
+
+    virtual void print(std::ostream_iterator<char>& out, size_t indent) const noexcept override;
+
+    /* The bound node belongs to the binding, not to its references */
+    virtual std::optional<std::vector<ASTNode*>> get_children() const noexcept override 
+    { 
+        return std::nullopt;
+    }
+
+    static constexpr int static_type_id() { return ASTNodeTypeId_BindingRef; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    std::string_view get_name() const noexcept { return this->_name; }
+
+    const ASTNode* get_value() const noexcept { return this->_value.get(); }
+};
+
 template<typename T>
 const T* node_cast(const ASTNode* node) noexcept
 {
@@ -211,6 +252,12 @@ const T* node_cast(const ASTNode* node) noexcept
     return nullptr;
 }
 
+struct ASTBinding
+{
+    std::string_view name;
+    std::shared_ptr<ASTNode> value;
+};
+
 class MATHEXPR_API AST
 {
 public:
@@ -219,6 +266,9 @@ public:
 private:
     std::shared_ptr<ASTNode> _root;
 
+    /* Let-bindings preceding the root expression, in source order */
+    std::vector<ASTBinding> _bindings;
+
 public:
     AST() {}
 
@@ -226,6 +276,8 @@ public:
 
     const ASTNode* get_root() const noexcept { return this->_root.get(); }
 
+    const std::vector<ASTBinding>& get_bindings() const noexcept { return this->_bindings; }
+
     void print() const noexcept;
 
     bool build_from_tokens(const LexerTokens& tokens) noexcept;
@@ -236,6 +288,8 @@ public:
         {
             this->_root.reset();
         }
+
+        this->_bindings.clear();
     }
 };
 
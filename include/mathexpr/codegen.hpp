@@ -30,6 +30,9 @@ public:
     virtual void as_string(std::string& out) const noexcept = 0;
     virtual void as_bytecode(ByteCode& out) const noexcept = 0;
 
+    /* target specific id of the instruction */
+    virtual int type_id() const noexcept = 0;
+
     /* default estimation, useful to avoid reallocation when emitting bytecode */
     virtual size_t get_bytecode_size_estimate() const noexcept { return 4; }
 
@@ -37,16 +40,49 @@ public:
     virtual bool needs_linking() const noexcept { return false; }
 
     /* for instructions that need linking, return linking information */
-    virtual RelocInfo get_link_info(std::size_t bytecode_start) const noexcept { return RelocInfo(); }
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept { return RelocInfo(); }
 };
 
 using InstrPtr = std::shared_ptr<Instr>;
 
+template<typename T>
+const T* instr_const_cast(const Instr* instr) noexcept
+{
+    if(instr != nullptr && instr->type_id() == T::static_type_id())
+    {
+        return static_cast<const T*>(instr);
+    }
+
+    return nullptr;
+}
+
+template<typename T>
+T* instr_cast(Instr* instr) noexcept
+{
+    if(instr != nullptr && instr->type_id() == T::static_type_id())
+    {
+        return static_cast<T*>(instr);
+    }
+
+    return nullptr;
+}
+
+/* Reported by target optimizations on the instruction sequence, in machine instructions and bytes */
+struct PeepholeStats
+{
+    uint64_t removed_instructions = 0;
+    uint64_t removed_bytes = 0;
+};
+
 /* Target specific code generator, subclassed in target files (x86_64.cpp, aarch64.cpp ...) */
 class MATHEXPR_API TargetCodeGenerator
 {
     PlatformABIPtr _platform_abi;
 
+    /* Precision of the floating point instructions created by the generator */
+    uint32_t _value_type = ValueType_Float64;
+
 public:
     TargetCodeGenerator(PlatformABIPtr platform_abi) : _platform_abi(platform_abi) {}
 
@@ -55,23 +91,47 @@ public:
     virtual bool is_valid() const noexcept = 0;
 
     virtual InstrPtr create_mov(MemLocPtr& from, MemLocPtr& to) = 0;
-    virtual InstrPtr create_prologue(uint64_t stack_size) = 0;
-    virtual InstrPtr create_epilogue(uint64_t stack_size) = 0;
+    virtual InstrPtr create_prologue(uint64_t stack_size, bool frame_pointer) = 0;
+    virtual InstrPtr create_epilogue(uint64_t stack_size, bool frame_pointer) = 0;
     virtual InstrPtr create_neg(MemLocPtr& operand) = 0;
     virtual InstrPtr create_add(MemLocPtr& left, MemLocPtr& right) = 0;
     virtual InstrPtr create_sub(MemLocPtr& left, MemLocPtr& right) = 0;
     virtual InstrPtr create_mul(MemLocPtr& left, MemLocPtr& right) = 0;
     virtual InstrPtr create_div(MemLocPtr& left, MemLocPtr& right) = 0;
-    virtual InstrPtr create_call(std::string_view call_name) = 0;
+    /* Comparisons (BinaryOpType_Eq, Neq, Lt, Le) write an all-ones or all-zeros mask in left */
+    virtual InstrPtr create_cmp(MemLocPtr& left, MemLocPtr& right, uint32_t op) = 0;
+    virtual InstrPtr create_and(MemLocPtr& left, MemLocPtr& right) = 0;
+    virtual InstrPtr create_andnot(MemLocPtr& left, MemLocPtr& right) = 0;
+    virtual InstrPtr create_or(MemLocPtr& left, MemLocPtr& right) = 0;
+    virtual InstrPtr create_mask_to_bool(MemLocPtr& operand) = 0;
+    virtual InstrPtr create_sqrt(MemLocPtr& operand) = 0;
+    /* preserve_outputs keeps the outputs base pointer of expression groups across the call */
+    virtual InstrPtr create_call(std::string_view call_name, bool preserve_outputs) = 0;
     virtual InstrPtr create_ret() = 0;
 
+    /*
+        Reduction loops, see CodeGenerator::build_reduction. The reduction begin copies the column
+        pointers and the row count to the stack and clears the accumulators, a loop runs its body
+        while at least step rows remain and then moves the column pointers by step rows, the
+        reduction end sums the accumulators (and divides them by the row count for a mean) in the
+        return register
+    */
+    virtual InstrPtr create_reduction_begin(uint64_t num_columns, uint64_t num_accumulators) = 0;
+    virtual InstrPtr create_loop_begin(uint64_t num_columns, uint64_t step) = 0;
+    virtual InstrPtr create_loop_end(const InstrPtr& loop_begin) = 0;
+    virtual InstrPtr create_reduction_end(uint64_t num_columns, uint64_t num_accumulators, bool mean) = 0;
+
     /* Add more instructions */
 
     std::string_view get_target_name() const noexcept { return this->_platform_abi->get_as_string(); }
 
     PlatformABIPtr get_platform_abi() noexcept { return this->_platform_abi; }
 
-    virtual void optimize_instr_sequence(std::vector<InstrPtr>& instructions) {}
+    void set_value_type(uint32_t value_type) noexcept { this->_value_type = value_type; }
+
+    uint32_t get_value_type() const noexcept { return this->_value_type; }
+
+    virtual PeepholeStats optimize_instr_sequence(std::vector<InstrPtr>& instructions) noexcept { return {}; }
 };
 
 using TargetCodeGeneratorPtr = std::unique_ptr<TargetCodeGenerator>;
@@ -85,24 +145,60 @@ private:
 
     uint32_t _isa;
     PlatformABIPtr _platform_abi;
+    uint32_t _value_type;
+
+    PeepholeStats _peephole_stats;
+
+    /* Literals values indexed by id, emitted after the code and addressed relative to the ip */
+    std::vector<double> _constants;
 
 public:
-    CodeGenerator(uint32_t isa, PlatformABIPtr platform_abi);
+    CodeGenerator(uint32_t isa, PlatformABIPtr platform_abi, uint32_t value_type = ValueType_Float64);
 
     bool build(const SSA& ssa,
                const RegisterAllocator& regalloc,
                SymbolTable& symtable) noexcept;
 
-    std::tuple<bool, ByteCode> as_bytecode(Relocations& relocs) const noexcept;
+    /*
+        Builds a reduction over columns of values: the body (see SSA::build_reduction_from_ast)
+        processes unroll rows per iteration into as many accumulators, the remaining rows go through
+        the tail, built for a single row. Both share the stack frame, allocated once before the loops
+    */
+    bool build_reduction(const SSA& body,
+                         const RegisterAllocator& body_regalloc,
+                         const SSA& tail,
+                         const RegisterAllocator& tail_regalloc,
+                         SymbolTable& symtable,
+                         uint64_t unroll,
+                         bool mean) noexcept;
+
+    /* The constant pool ends the bytecode, it starts at a multiple of constant_pool_alignment */
+    std::tuple<bool, ByteCode> as_bytecode(Relocations& relocs,
+                                           std::size_t constant_pool_alignment = sizeof(double)) const noexcept;
     std::tuple<bool, std::string> as_string() const noexcept;
     std::tuple<bool, std::string> as_bytecode_hex_string() const noexcept;
 
     std::string_view get_target_name() const noexcept { return this->_platform_abi->get_as_string(); }
 
+    uint32_t get_value_type() const noexcept { return this->_value_type; }
+
     void add_instruction(InstrPtr instr) noexcept { this->_instructions.push_back(std::move(instr)); }
+    const std::vector<double>& get_constants() const noexcept { return this->_constants; }
     const std::vector<InstrPtr>& get_instructions() const noexcept { return this->_instructions; }
 
+    const PeepholeStats& get_peephole_stats() const noexcept { return this->_peephole_stats; }
+
 private:
+    void load_constants(const SymbolTable& symtable) noexcept;
+
+    /* Appends the instructions of the statements, the stack frame they need is set up by the caller */
+    bool build_statements(const SSA& ssa,
+                          const RegisterAllocator& regalloc,
+                          SymbolTable& symtable,
+                          std::vector<InstrPtr>& instructions,
+                          uint64_t& stack_size,
+                          bool& frame_pointer) noexcept;
+
     static TargetCodeGeneratorPtr create_target_generator(uint32_t isa,
                                                           PlatformABIPtr platform_abi) noexcept;
 };
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#pragma once
+
+#if !defined(__MATHEXPR_COLUMN_FILE)
+#define __MATHEXPR_COLUMN_FILE
+
+#include "mathexpr/expr.hpp"
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+MATHEXPR_NAMESPACE_BEGIN
+
+/* Read-only memory mapping of a whole file */
+class MATHEXPR_API MappedFile
+{
+    const std::byte* _data = nullptr;
+    size_t _size = 0;
+
+#if defined(MATHEXPR_WIN)
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif /* defined(MATHEXPR_WIN) */
+
+    void close() noexcept;
+
+public:
+    MappedFile() {}
+
+    ~MappedFile() { this->close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /* The file is expected to be read from the beginning to the end, the pages are read ahead */
+    bool open(const char* path) noexcept;
+
+    const std::byte* data() const noexcept { return this->_data; }
+
+    size_t size() const noexcept { return this->_size; }
+
+    /* Asks for the range to be backed by huge pages when the system supports it for files */
+    void advise_huge_pages(size_t begin, size_t end) noexcept;
+
+    /* Drops the pages fully contained in [begin, end) from the resident set once they have been consumed */
+    void release(size_t begin, size_t end) noexcept;
+};
+
+/*
+    Binary column file, a header followed by a raw array of doubles per named column, meant to be
+    memory-mapped and evaluated in place without any parsing nor copy. All the values are little
+    endian.
+
+    offset  size                type        content
+    0       8                   char[8]     magic, "MXCOLS\0\0"
+    8       4                   uint32_t    version, COLUMN_FILE_VERSION
+    12      4                   uint32_t    number of columns
+    16      8                   uint64_t    number of rows
+    24      8                   uint64_t    reserved, 0
+    32      16 * num_columns    entries     per column: uint64_t offset of the values from the start of
+                                            the file, uint32_t offset of the name from the start of the
+                                            file, uint32_t size of the name in bytes
+    ...                         char[]      names, not null-terminated
+    ...     8 * num_rows        double[]    values of each column, at the offset of its entry
+
+    The values of a column are aligned on COLUMN_FILE_ALIGNMENT, and on COLUMN_FILE_HUGE_PAGE_ALIGNMENT
+    when they span at least a huge page so they can be backed by huge pages
+*/
+
+static constexpr char COLUMN_FILE_MAGIC[8] = { 'M', 'X', 'C', 'O', 'L', 'S', '\0', '\0' };
+static constexpr uint32_t COLUMN_FILE_VERSION = 1;
+static constexpr size_t COLUMN_FILE_HEADER_SIZE = 32;
+static constexpr size_t COLUMN_FILE_ENTRY_SIZE = 16;
+static constexpr size_t COLUMN_FILE_ALIGNMENT = 4096;
+static constexpr size_t COLUMN_FILE_HUGE_PAGE_ALIGNMENT = 2 * 1024 * 1024;
+
+class MATHEXPR_API ColumnFile
+{
+    MappedFile _file;
+
+    uint64_t _num_rows = 0;
+
+    std::vector<std::string_view> _names;
+    std::vector<const double*> _columns;
+
+public:
+    ColumnFile() {}
+
+    /* Maps the file and validates its header, the values are only read when evaluated */
+    bool open(const char* path) noexcept;
+
+    /* Returns true if the data starts with the magic of a column file */
+    static bool has_magic(const std::byte* data, size_t size) noexcept;
+
+    uint64_t get_num_rows() const noexcept { return this->_num_rows; }
+
+    size_t get_num_columns() const noexcept { return this->_columns.size(); }
+
+    std::string_view get_column_name(size_t column) const noexcept { return this->_names[column]; }
+
+    /* Returns nullptr if the file has no column with this name */
+    const double* get_column(std::string_view name) const noexcept;
+
+    /*
+        Resolves the columns of the variables of an expression, indexed by the slots of the layout
+        and pointing into the mapping, ready to be passed to Expr::evaluate_batch. Fails if a
+        variable has no column of the same name
+    */
+    bool bind(const VariableLayout& variables, std::vector<const double*>& columns) const noexcept;
+
+    /* Drops the pages of the rows [begin, end) of all the columns once they have been evaluated */
+    void release_rows(uint64_t begin, uint64_t end) noexcept;
+};
+
+/* Writes num_rows values of each column to a column file, names and columns being matched by index */
+MATHEXPR_API bool write_column_file(const char* path,
+                                    std::span<const std::string_view> names,
+                                    std::span<const double* const> columns,
+                                    uint64_t num_rows) noexcept;
+
+MATHEXPR_NAMESPACE_END
+
+#endif /* !defined(__MATHEXPR_COLUMN_FILE) */
@@ -15,6 +15,18 @@ MATHEXPR_NAMESPACE_BEGIN
 
 static constexpr uint64_t UINT64_T_MAX = std::numeric_limits<uint64_t>::max();
 
+/* Floating point type of the values an expression is compiled for */
+enum ValueType : uint32_t
+{
+    ValueType_Float64,
+    ValueType_Float32,
+};
+
+constexpr size_t value_type_size(uint32_t value_type) noexcept
+{
+    return value_type == ValueType_Float32 ? sizeof(float) : sizeof(double);
+}
+
 MATHEXPR_NAMESPACE_END
 
 #endif /* !defined(__MATHEXPR_CONSTANTS) */
\ No newline at end of file
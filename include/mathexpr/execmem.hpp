@@ -11,6 +11,7 @@
 #include "mathexpr/log.hpp"
 
 #include <cstring>
+#include <algorithm>
 
 #if defined(MATHEXPR_WIN)
 #include <windows.h>
@@ -27,6 +28,7 @@ private:
 
     void* _memory;
     size_t _size;
+    size_t _executable_size;
     bool _locked;
 
     bool allocate() noexcept
@@ -67,11 +69,20 @@ private:
         this->_memory = nullptr;
     }
 public:
-    using FunctionType = double(*)(const double*, const double*);
+    using FunctionType = double(*)(const double*);
 
-    ExecMem() : _memory(nullptr), _size(0), _locked(false) {}
+    /* Expressions compiled with ExprCompileFlags_Float32 */
+    using FloatFunctionType = float(*)(const float*);
 
-    ExecMem(size_t size) : _memory(nullptr), _size(size), _locked(false) 
+    /* Expression groups write their results to the outputs array instead of returning a value */
+    using GroupFunctionType = void(*)(const double*, double*);
+
+    /* Reductions loop over columns of values (one pointer per variable) and return the result */
+    using ReductionFunctionType = double(*)(const double* const*, uint64_t);
+
+    ExecMem() : _memory(nullptr), _size(0), _executable_size(0), _locked(false) {}
+
+    ExecMem(size_t size) : _memory(nullptr), _size(size), _executable_size(size), _locked(false) 
     {
         this->allocate();
     }
@@ -86,10 +97,12 @@ public:
 
     ExecMem(ExecMem&& other) noexcept : _memory(other._memory), 
                                         _size(other._size), 
+                                        _executable_size(other._executable_size),
                                         _locked(other._locked) 
     {
         other._memory = nullptr;
         other._size = 0;
+        other._executable_size = 0;
         other._locked = false;
     }
 
@@ -100,9 +113,11 @@ public:
             this->deallocate();
             this->_memory = other._memory;
             this->_size = other._size;
+            this->_executable_size = other._executable_size;
             this->_locked = other._locked;
             other._memory = nullptr;
             other._size = 0;
+            other._executable_size = 0;
             other._locked = false;
         }
 
@@ -128,23 +143,52 @@ public:
         return true;
     }
 
+    static size_t get_page_size() noexcept
+    {
+#if defined(MATHEXPR_WIN)
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+
+        return static_cast<size_t>(system_info.dwPageSize);
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif /* defined(MATHEXPR_WIN) */
+    }
+
     bool lock() noexcept
+    {
+        return this->lock(this->_size);
+    }
+
+    /*
+        Makes the first executable_size bytes executable and read-only, the memory after them stays
+        writable. executable_size must be a multiple of the page size when smaller than the memory
+    */
+    bool lock(size_t executable_size) noexcept
     {
         if(this->_locked) 
         {
             return true;
         }
+
+        if(executable_size < this->_size && (executable_size % ExecMem::get_page_size()) != 0)
+        {
+            log_error("Executable memory size must be aligned on the page size");
+            return false;
+        }
+
+        this->_executable_size = std::min(executable_size, this->_size);
         
 #if defined(MATHEXPR_WIN)
         DWORD oldProtect;
 
-        if(!VirtualProtect(this->_memory, this->_size, PAGE_EXECUTE_READ, &oldProtect)) 
+        if(!VirtualProtect(this->_memory, this->_executable_size, PAGE_EXECUTE_READ, &oldProtect)) 
         {
             log_error("Failed to make memory executable");
             return false;
         }
 #else
-        if(mprotect(this->_memory, this->_size, PROT_READ | PROT_EXEC) != 0) 
+        if(mprotect(this->_memory, this->_executable_size, PROT_READ | PROT_EXEC) != 0) 
         {
             log_error("Failed to make memory executable");
             return false;
@@ -155,7 +199,8 @@ public:
         return true;
     }
 
-    FunctionType as_function() const noexcept
+    template<typename F = FunctionType>
+    F as_function() const noexcept
     {
         if(!this->_locked) 
         {
@@ -163,7 +208,18 @@ public:
             return nullptr;
         }
 
-        return reinterpret_cast<FunctionType>(_memory);
+        return reinterpret_cast<F>(_memory);
+    }
+
+    /* Returns the writable memory after the executable part, nullptr if there is none */
+    void* get_writable_data() const noexcept
+    {
+        if(!this->_locked || this->_executable_size >= this->_size)
+        {
+            return nullptr;
+        }
+
+        return static_cast<std::byte*>(this->_memory) + this->_executable_size;
     }
 
     size_t size() const { return this->_size; }
@@ -11,11 +11,12 @@
 #include "mathexpr/execmem.hpp"
 #include "mathexpr/string_hash.hpp"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
-#include <set>
 #include <vector>
 #include <array>
+#include <span>
 
 MATHEXPR_NAMESPACE_BEGIN
 
@@ -30,26 +31,213 @@ enum ExprPrintFlags : uint64_t
     ExprPrintFlags_PrintCodeGeneratorAsString = 0x40,
     ExprPrintFlags_PrintCodeGeneratorByteCodeAsHexCode = 0x80,
     ExprPrintFlags_PrintCodeGeneratorRelocations = 0x100,
+    ExprPrintFlags_PrintInterpreter = 0x200,
     ExprPrintFlags_PrintAll = UINT64_T_MAX,
 };
 
+enum ExprCompileFlags : uint64_t
+{
+    /*
+        Literals are kept in writable memory after the code and can be updated with
+        Expr::set_literal without recompiling
+    */
+    ExprCompileFlags_ParametricLiterals = 0x1,
+    /*
+        Single precision code (ss/ps instructions and float libmaths kernels), evaluated with
+        Expr::evaluate(std::span<const float>)
+    */
+    ExprCompileFlags_Float32 = 0x2,
+    /*
+        Only builds an interpreter from the SSA, the expression can be evaluated right away. Machine code
+        is generated on a background thread once it has been evaluated EXPR_TIERED_JIT_THRESHOLD times,
+        and replaces the interpreter from then on. Not available with the flags above
+    */
+    ExprCompileFlags_Tiered = 0x4,
+    /*
+        Only builds the interpreter and never generates machine code, which is what happens anyway on
+        platforms we cannot generate code for. Parametric literals are supported, single precision is not
+    */
+    ExprCompileFlags_Interpreted = 0x8,
+};
+
+static constexpr uint64_t EXPR_TIERED_JIT_THRESHOLD = 1000;
+
 using Variables = std::unordered_map<std::string, double, string_hash, std::equal_to<>>;
 
+/*
+    Column of doubles in the Apache Arrow layout: contiguous values and an optional validity bitmap,
+    bit i (least significant bit first) telling if row i is valid. The offset applies to both buffers,
+    as for sliced Arrow arrays. Values of null rows are unspecified but must be readable
+*/
+struct ArrowColumn
+{
+    const double* values = nullptr;
+    const uint8_t* validity = nullptr; /* nullptr when the column has no nulls */
+    size_t offset = 0;
+};
+
+using ArrowColumns = std::unordered_map<std::string, ArrowColumn, string_hash, std::equal_to<>>;
+
+/*
+    Column of doubles spread in memory with a constant byte stride, to read a member of an array of
+    structs without transposing it first, e.g. { &particles[0].x, sizeof(Particle) }
+*/
+struct StridedColumn
+{
+    const double* values = nullptr;
+    size_t stride = sizeof(double);
+};
+
+static constexpr size_t INVALID_VARIABLE_SLOT = std::numeric_limits<size_t>::max();
+
+/*
+    Maps the variables of a compiled expression to the slots of the values buffer, in order of
+    first appearance in the expression. Resolve the names once, then fill a caller-owned buffer
+    by slot and pass it to Expr::evaluate(std::span<const double>).
+    Also used for parametric literals, named after their text in the expression. The literals of
+    the same value share their slot, whichever way they are written
+*/
+class MATHEXPR_API VariableLayout
+{
+    std::vector<std::string> _names;
+    std::unordered_map<std::string, size_t, string_hash, std::equal_to<>> _slots;
+
+public:
+    VariableLayout() {}
+
+    void clear() noexcept
+    {
+        this->_names.clear();
+        this->_slots.clear();
+    }
+
+    void add(std::string_view name, size_t slot) noexcept
+    {
+        if(slot >= this->_names.size())
+            this->_names.resize(slot + 1);
+
+        /* Several names can share a slot (literals of the same value), the slot keeps the first one */
+        if(this->_names[slot].empty())
+            this->_names[slot] = std::string(name);
+
+        this->_slots.emplace(std::string(name), slot);
+    }
+
+    /* Returns INVALID_VARIABLE_SLOT if the expression does not use this variable */
+    size_t get_slot(std::string_view name) const noexcept
+    {
+        const auto it = this->_slots.find(name);
+
+        return it == this->_slots.end() ? INVALID_VARIABLE_SLOT : it->second;
+    }
+
+    const std::string& get_name(size_t slot) const noexcept { return this->_names[slot]; }
+
+    size_t size() const noexcept { return this->_names.size(); }
+};
+
+/*
+    Typed handle on a compiled expression taking N variables, returned by Expr::bind<N>().
+    Everything is validated once when binding, calling it is a single indirect call.
+    The handle borrows the code of the Expr, it must not outlive it nor be used after the Expr
+    has been recompiled
+*/
+template<std::size_t N>
+class CompiledFn
+{
+    ExecMem::FunctionType _func;
+
+public:
+    CompiledFn() : _func(nullptr) {}
+
+    CompiledFn(ExecMem::FunctionType func) : _func(func) {}
+
+    bool is_valid() const noexcept { return this->_func != nullptr; }
+
+    explicit operator bool() const noexcept { return this->is_valid(); }
+
+    template<typename... Args>
+        requires (sizeof...(Args) == N && (std::convertible_to<Args, double> && ...))
+    MATHEXPR_FORCE_INLINE double operator()(Args... args) const noexcept
+    {
+        MATHEXPR_ASSERT(this->_func != nullptr, "CompiledFn is not bound to an expression");
+
+        alignas(16) const double values[N > 0 ? N : 1] = { static_cast<double>(args)... };
+
+        return this->_func(values);
+    }
+};
+
+/* Interpreter and background compilation of a tiered or interpreted expression */
+struct TieredCode;
+
 class MATHEXPR_API Expr
 {
     std::string _expr;
 
+    std::shared_ptr<TieredCode> _tiered;
+
     ExecMem _exec_mem;
 
-    std::set<std::string_view> _variables;
-    std::vector<double> _literals;
+    ExecMem _gradient_exec_mem;
+
+    VariableLayout _variables;
+
+    /* Built by compile_gradient, compile builds the layout of the expression itself */
+    VariableLayout _gradient_variables;
+
+    VariableLayout _literals;
+    void* _parametric_literals = nullptr; /* constant pool, only writable with ExprCompileFlags_ParametricLiterals */
+
+    uint32_t _value_type = ValueType_Float64;
 
     std::tuple<bool, double> _evaluate_internal(const double* values) const noexcept;
 
+    std::tuple<bool, float> _evaluate_internal(const float* values) const noexcept;
+
+    bool _check_batch(size_t num_columns) const noexcept;
+
+    /* Generates the code of a tiered expression on the calling thread if it has not been promoted yet */
+    ExecMem::FunctionType _get_function() const noexcept;
+
 public:
     Expr(std::string expr) : _expr(std::move(expr)) {}
 
-    bool compile(uint64_t debug_flags = 0) noexcept;
+    bool compile(uint64_t debug_flags = 0, uint64_t compile_flags = 0) noexcept;
+
+    /*
+        Compiles a second function computing the value and all the partial derivatives of the
+        expression in a single call (reverse-mode automatic differentiation), see evaluate_gradient
+    */
+    bool compile_gradient(uint64_t debug_flags = 0) noexcept;
+
+    /*
+        Values are indexed by the slots of get_gradient_variable_layout(). The value of the
+        expression is written to outputs[0] and its derivative with respect to the variable of
+        slot i to outputs[i + 1]
+    */
+    bool evaluate_gradient(std::span<const double> values, std::span<double> outputs) const noexcept;
+
+    const VariableLayout& get_gradient_variable_layout() const noexcept { return this->_gradient_variables; }
+
+    const VariableLayout& get_literal_layout() const noexcept { return this->_literals; }
+
+    /* False while a tiered expression is interpreted, and always for interpreted expressions */
+    bool is_jit_compiled() const noexcept;
+
+    /* ValueType_Float32 if the expression has been compiled with ExprCompileFlags_Float32 */
+    uint32_t get_value_type() const noexcept { return this->_value_type; }
+
+    /*
+        Updates a literal of an expression compiled with ExprCompileFlags_ParametricLiterals. Handles
+        returned by bind() see the new value. Must not be called while the expression is evaluated
+    */
+    bool set_literal(size_t slot, double value) noexcept;
+
+    bool set_literal(std::string_view name, double value) noexcept
+    {
+        return this->set_literal(this->_literals.get_slot(name), value);
+    }
 
     template<typename... Args>
         requires (std::same_as<std::remove_cvref_t<Args>, double> && ...)
@@ -73,6 +261,97 @@ public:
         return this->_evaluate_internal(values.data());
     }
 
+    /*
+        Returns an invalid handle if the expression is not compiled or does not take N variables. Tiered
+        expressions are promoted right away, the handle always calls machine code, hence interpreted
+        expressions cannot be bound
+    */
+    template<std::size_t N>
+    CompiledFn<N> bind() const noexcept
+    {
+        if(N != this->_variables.size())
+        {
+            log_error("Cannot bind expression taking {} variables to a function taking {} arguments",
+                      this->_variables.size(),
+                      N);
+
+            return CompiledFn<N>();
+        }
+
+        if(this->_value_type != ValueType_Float64)
+        {
+            log_error("Cannot bind an expression compiled in single precision to a function taking doubles");
+            return CompiledFn<N>();
+        }
+
+        ExecMem::FunctionType func = this->_get_function();
+
+        if(func == nullptr)
+        {
+            log_error("Expression has not been compiled to machine code, it cannot be bound");
+            return CompiledFn<N>();
+        }
+
+        return CompiledFn<N>(func);
+    }
+
+    const VariableLayout& get_variable_layout() const noexcept { return this->_variables; }
+
+    /* Values are indexed by the slots of get_variable_layout() */
+    std::tuple<bool, double> evaluate(std::span<const double> values) const noexcept
+    {
+        if(values.size() != this->_variables.size())
+        {
+            log_error("You passed {} values but the expression needs {}",
+                      values.size(),
+                      this->_variables.size());
+
+            return std::make_tuple(false, 0.0);
+        }
+
+        return this->_evaluate_internal(values.data());
+    }
+
+    /*
+        Evaluates the expression over columns of values (one per variable, indexed by the slots of
+        get_variable_layout()), writing the result of row i to outputs[i]. Each column must hold at
+        least outputs.size() values
+    */
+    bool evaluate_batch(std::span<const double* const> columns, std::span<double> outputs) const noexcept;
+
+    /* Strided version, for variables read from arrays of structs */
+    bool evaluate_batch(std::span<const StridedColumn> columns, std::span<double> outputs) const noexcept;
+
+    /*
+        Evaluates the expression over Arrow columns indexed by the slots of get_variable_layout(). All
+        the rows are evaluated whether they are null or not, and the validity bitmap of the outputs,
+        (outputs.size() + 7) / 8 bytes, gets the rows where all the variables are valid
+    */
+    bool evaluate_batch(std::span<const ArrowColumn> columns,
+                        std::span<double> outputs,
+                        std::span<uint8_t> validity) const noexcept;
+
+    /* Columns are looked up by the name of the variables, other columns are ignored */
+    bool evaluate_batch(const ArrowColumns& columns,
+                        std::span<double> outputs,
+                        std::span<uint8_t> validity) const noexcept;
+
+    /* Single precision version, for expressions compiled with ExprCompileFlags_Float32 */
+    std::tuple<bool, float> evaluate(std::span<const float> values) const noexcept
+    {
+        if(values.size() != this->_variables.size())
+        {
+            log_error("You passed {} values but the expression needs {}",
+                      values.size(),
+                      this->_variables.size());
+
+            return std::make_tuple(false, 0.0f);
+        }
+
+        return this->_evaluate_internal(values.data());
+    }
+
+    /* Values are converted to the value type the expression has been compiled for */
     std::tuple<bool, double> evaluate(const Variables& variables) const noexcept
     {
         if(variables.size() != this->_variables.size())
@@ -80,25 +359,84 @@ public:
             return std::make_tuple(false, 0.0);
         }
 
-        std::vector<double> values;
-        values.reserve(this->_variables.size());
+        std::vector<double> values(this->_variables.size());
 
-        for(const std::string_view& variable : this->_variables)
+        for(size_t slot = 0; slot < this->_variables.size(); slot++)
         {
-            const auto it = variables.find(variable);
+            const auto it = variables.find(this->_variables.get_name(slot));
 
             if(it == variables.end())
             {
                 return std::make_tuple(false, 0.0);
             }
 
-            values.push_back(it->second);
+            values[slot] = it->second;
+        }
+
+        if(this->_value_type == ValueType_Float32)
+        {
+            const std::vector<float> float_values(values.begin(), values.end());
+
+            const auto [success, result] = this->_evaluate_internal(float_values.data());
+
+            return std::make_tuple(success, static_cast<double>(result));
         }
 
         return this->_evaluate_internal(values.data());
     }
 };
 
+/*
+    Several expressions over the same variables, compiled into a single function. Variables and
+    literals are loaded once and common subexpressions are computed once for the whole group.
+    The result of the i-th expression is written to outputs[i]
+*/
+class MATHEXPR_API ExprGroup
+{
+    std::vector<std::string> _exprs;
+
+    ExecMem _exec_mem;
+
+    VariableLayout _variables;
+
+public:
+    ExprGroup(std::vector<std::string> exprs) : _exprs(std::move(exprs)) {}
+
+    bool compile(uint64_t debug_flags = 0) noexcept;
+
+    size_t get_num_outputs() const noexcept { return this->_exprs.size(); }
+
+    const VariableLayout& get_variable_layout() const noexcept { return this->_variables; }
+
+    /* Values are indexed by the slots of get_variable_layout() */
+    bool evaluate(std::span<const double> values, std::span<double> outputs) const noexcept;
+};
+
+/*
+    Reduction of an expression over columns of values: sum(expr), mean(expr) or dot(a, b), the
+    expression being evaluated for each row. The loop over the rows is compiled in a single function,
+    unrolled with an accumulator per row so the additions don't wait for each other, and only the
+    result is returned
+*/
+class MATHEXPR_API ExprReduction
+{
+    std::string _expr;
+
+    ExecMem _exec_mem;
+
+    VariableLayout _variables;
+
+public:
+    ExprReduction(std::string expr) : _expr(std::move(expr)) {}
+
+    bool compile(uint64_t debug_flags = 0) noexcept;
+
+    const VariableLayout& get_variable_layout() const noexcept { return this->_variables; }
+
+    /* Columns are indexed by the slots of get_variable_layout(), each one holding num_rows values */
+    std::tuple<bool, double> evaluate(std::span<const double* const> columns, size_t num_rows) const noexcept;
+};
+
 MATHEXPR_NAMESPACE_END
 
 #endif /* !defined(__MATHEXPR_EXPR) */
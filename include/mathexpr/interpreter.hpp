@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#pragma once
+
+#if !defined(__MATHEXPR_INTERPRETER)
+#define __MATHEXPR_INTERPRETER
+
+#include "mathexpr/ssa.hpp"
+
+MATHEXPR_NAMESPACE_BEGIN
+
+enum InterpreterOp : uint32_t
+{
+    InterpreterOp_LoadVariable,
+    InterpreterOp_LoadConstant,
+    InterpreterOp_Neg,
+    InterpreterOp_MaskToBool,
+    InterpreterOp_Sqrt,
+    InterpreterOp_Add,
+    InterpreterOp_Sub,
+    InterpreterOp_Mul,
+    InterpreterOp_Div,
+    InterpreterOp_Eq,
+    InterpreterOp_Neq,
+    InterpreterOp_Lt,
+    InterpreterOp_Le,
+    InterpreterOp_Gt,
+    InterpreterOp_Ge,
+    InterpreterOp_And,
+    InterpreterOp_AndNot,
+    InterpreterOp_Or,
+    InterpreterOp_Call1,
+    InterpreterOp_Call2,
+    InterpreterOp_Call3,
+    InterpreterOp_Return,
+    InterpreterOp_Count,
+};
+
+static constexpr uint32_t INVALID_INTERPRETER_OP = std::numeric_limits<uint32_t>::max();
+
+MATHEXPR_API const char* interpreter_op_as_string(uint32_t op) noexcept;
+
+/*
+    Register-based instruction, dst and the operands are indices in the register file. Loads read
+    the values buffer or the constants at index a, calls take their function at index function and
+    the last instruction returns the register a
+*/
+struct InterpreterInstr
+{
+    uint32_t op;
+    uint32_t dst;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t function;
+};
+
+/* Register files up to this size live on the stack of the evaluating thread */
+static constexpr size_t INTERPRETER_STACK_REGISTERS = 256;
+
+/*
+    Evaluates an expression from its SSA, without register allocation nor code generation. Each
+    statement gets its own register and becomes a single instruction, comparisons produce the same
+    masks as the generated code so select and the bitwise ops behave the same way. It only relies on
+    the scalar libmaths kernels and runs on any platform, even the ones we cannot generate code for.
+
+    Instructions are dispatched with computed gotos when the compiler supports them, each handler
+    jumping straight to the next one, and with a switch otherwise
+*/
+class MATHEXPR_API Interpreter
+{
+    std::vector<InterpreterInstr> _instructions;
+
+    std::vector<double> _constants;
+
+    std::vector<void*> _functions;
+
+    uint32_t _num_registers = 0;
+
+public:
+    Interpreter() {}
+
+    /* Built right after SSA::build_from_ast, variables and literals are resolved with the symbol table */
+    bool build(const SSA& ssa, const SymbolTable& symtable) noexcept;
+
+    bool is_built() const noexcept { return !this->_instructions.empty(); }
+
+    void print() const noexcept;
+
+    /* Indexed by the ids of the literals in the symbol table, can be updated between evaluations */
+    double* get_constants() noexcept { return this->_constants.data(); }
+
+    /* Values are indexed by the ids of the variables in the symbol table */
+    double evaluate(const double* values) const noexcept;
+};
+
+MATHEXPR_NAMESPACE_END
+
+#endif /* !defined(__MATHEXPR_INTERPRETER) */
@@ -9,6 +9,7 @@
 
 #include "mathexpr/common.hpp"
 
+#include <array>
 #include <string_view>
 #include <vector>
 #include <limits>
@@ -23,6 +24,10 @@ enum LexerTokenType : uint32_t
     LParen,
     RParen,
     Comma,
+    Assign,
+    Semicolon,
+    Question,
+    Colon,
     EndOfFile,
     Empty,
 };
@@ -49,6 +54,66 @@ static const LexerToken EMPTY_TOKEN = { "", LexerTokenType::Empty };
 
 static constexpr uint32_t LEXER_ERROR = std::numeric_limits<std::uint32_t>::max();
 
+/* Character classes, looked up in a table rather than going through the locale of <cctype> */
+enum LexerCharClass : uint8_t
+{
+    LexerCharClass_Digit = 0x1,
+    LexerCharClass_Alpha = 0x2,
+    LexerCharClass_SymbolTail = 0x4,  /* letters, digits and underscore */
+    LexerCharClass_LiteralTail = 0x8, /* letters, digits, dot and underscore */
+    LexerCharClass_HexDigit = 0x10,
+};
+
+static constexpr std::array<uint8_t, 256> LEXER_CHAR_CLASSES = []() {
+    std::array<uint8_t, 256> classes = {};
+
+    for(int c = '0'; c <= '9'; c++)
+    {
+        classes[c] = LexerCharClass_Digit |
+                     LexerCharClass_SymbolTail |
+                     LexerCharClass_LiteralTail |
+                     LexerCharClass_HexDigit;
+    }
+
+    for(int c = 'a'; c <= 'z'; c++)
+    {
+        classes[c] = LexerCharClass_Alpha | LexerCharClass_SymbolTail | LexerCharClass_LiteralTail;
+        classes[c - 'a' + 'A'] = LexerCharClass_Alpha | LexerCharClass_SymbolTail | LexerCharClass_LiteralTail;
+    }
+
+    for(int c = 'a'; c <= 'f'; c++)
+    {
+        classes[c] |= LexerCharClass_HexDigit;
+        classes[c - 'a' + 'A'] |= LexerCharClass_HexDigit;
+    }
+
+    classes['_'] = LexerCharClass_SymbolTail | LexerCharClass_LiteralTail;
+    classes['.'] = LexerCharClass_LiteralTail;
+
+    return classes;
+}();
+
+MATHEXPR_FORCE_INLINE bool lexer_char_is(char c, uint8_t char_class) noexcept
+{
+    return (LEXER_CHAR_CLASSES[static_cast<unsigned char>(c)] & char_class) != 0;
+}
+
+/* Digits of a literal can be separated, as in 1_000_000 */
+static constexpr char LEXER_DIGIT_SEPARATOR = '_';
+
+/* Literals with separators are copied without them on the stack before being parsed */
+static constexpr size_t LEXER_MAX_SEPARATED_LITERAL_SIZE = 128;
+
+/*
+    Returns the size of the literal at the start of s, which starts with a digit. Literals are
+    decimal (2, 0.5, 1e-9, 6.02E+23) or hexadecimal (0xff, 0x1.8p-3). The literal spans every
+    character that can follow it, well_formed is false when they do not follow this syntax
+*/
+MATHEXPR_API uint32_t lexer_consume_literal(std::string_view s, bool& well_formed) noexcept;
+
+/* Parses a literal consumed by lexer_consume_literal without allocating, false if it is out of range */
+MATHEXPR_API bool lexer_parse_literal(std::string_view literal, double& value) noexcept;
+
 MATHEXPR_API std::tuple<bool, LexerTokens> lexer_lex_expression(std::string_view expression) noexcept;
 
 MATHEXPR_API uint32_t lexer_get_operator_precedence(char op) noexcept;
@@ -8,6 +8,7 @@
 #define __MATHEXPR_LINK
 
 #include "mathexpr/bytecode.hpp"
+#include "mathexpr/constants.hpp"
 
 #include <string_view>
 #include <vector>
@@ -18,6 +19,8 @@ enum RelocType : std::uint8_t
 {
     RelocType_Rel32,
     RelocType_Abs64,
+    RelocType_Constant32, /* ip-relative displacement to a constant pool entry, resolved by the code generator */
+    RelocType_SignMask32, /* ip-relative displacement to the sign mask placed before the constant pool */
 };
 
 /* Information for instructions that need linking */
@@ -26,11 +29,16 @@ struct RelocInfo
     std::string_view symbol_name = "";      /* name of the symbol to link */
     std::size_t bytecode_offset = 0;        /* where to apply reloc in the bytecode */
     RelocType reloc_type = RelocType_Abs64; /* type of reloc */
+    std::size_t constant_offset = 0;        /* offset in the constant pool for RelocType_Constant32 */
+    std::size_t instruction_end = 0;        /* the RelocType_Constant32 displacement is relative to it */
 };
 
 using Relocations = std::vector<RelocInfo>;
 
-MATHEXPR_API bool relocate(ByteCode& bytecode, const Relocations& relocations) noexcept;
+/* Function calls are linked to the libmaths kernels matching the value type of the code */
+MATHEXPR_API bool relocate(ByteCode& bytecode,
+                           const Relocations& relocations,
+                           uint32_t value_type = ValueType_Float64) noexcept;
 
 MATHEXPR_NAMESPACE_END
 
@@ -17,6 +17,8 @@ enum UnaryOpType : uint32_t
 {
     UnaryOpType_Unknown,
     UnaryOpType_Neg,
+    UnaryOpType_MaskToBool, /* Internal, turns a comparison mask into 1.0 or 0.0 */
+    UnaryOpType_Sqrt,       /* Internal, used to specialize half-integer powers */
 };
 
 MATHEXPR_API const char* op_unary_to_string(const uint32_t type) noexcept;
@@ -30,6 +32,17 @@ enum BinaryOpType : uint32_t
     BinaryOpType_Sub,
     BinaryOpType_Mul,
     BinaryOpType_Div,
+    BinaryOpType_Pow,
+    BinaryOpType_Eq,
+    BinaryOpType_Neq,
+    BinaryOpType_Lt,
+    BinaryOpType_Le,
+    BinaryOpType_Gt,
+    BinaryOpType_Ge,
+    /* Internal bitwise ops on comparison masks, used to lower select */
+    BinaryOpType_And,
+    BinaryOpType_AndNot, /* ~left & right */
+    BinaryOpType_Or,
 };
 
 MATHEXPR_API const char* op_binary_to_string(const uint32_t type) noexcept;
@@ -38,6 +51,11 @@ MATHEXPR_API uint32_t op_binary_from_string(const std::string_view& data) noexce
 
 MATHEXPR_API bool op_binary_is_commutative(const uint32_t type) noexcept;
 
+MATHEXPR_API bool op_binary_is_comparison(const uint32_t type) noexcept;
+
+/* Bitwise ops work on full registers, their operands can't be read from memory */
+MATHEXPR_API bool op_binary_is_bitwise(const uint32_t type) noexcept;
+
 MATHEXPR_NAMESPACE_END
 
 #endif /* !defined(__MATHEXPR_OP) */
\ No newline at end of file
@@ -21,6 +21,8 @@ enum MemLocTypeId : uint32_t
     MemLocTypeId_Register,
     MemLocTypeId_Stack,
     MemLocTypeId_Memory,
+    MemLocTypeId_Constant,
+    MemLocTypeId_Column,
 };
 
 enum MemLocRegister : uint32_t
@@ -69,10 +71,11 @@ public:
 
 class MATHEXPR_API Stack : public MemLoc 
 {
-    uint64_t _offset;
+    RegisterId _base_ptr; /* RegisterId value of the frame pointer or the stack pointer */
+    int64_t _offset;
 
 public:
-    Stack(uint64_t offset) : _offset(offset) {}
+    Stack(RegisterId base_ptr, int64_t offset) : _base_ptr(base_ptr), _offset(offset) {}
 
     virtual void print() const noexcept override {}
 
@@ -80,9 +83,10 @@ public:
 
     virtual int type_id() const noexcept override { return this->static_type_id(); }
 
-    uint64_t get_offset() const noexcept { return this->_offset; }
+    RegisterId get_base_ptr_register() const noexcept { return this->_base_ptr; }
 
-    int64_t get_signed_offset() const noexcept { return -static_cast<int64_t>(this->_offset); }
+    /* Negative below the frame pointer, positive above the stack pointer */
+    int64_t get_offset() const noexcept { return this->_offset; }
 };
 
 class MATHEXPR_API Memory : public MemLoc
@@ -104,6 +108,55 @@ public:
     uint64_t get_offset() const noexcept { return this->_offset; }
 };
 
+/* Read-only value stored in the constant pool emitted after the code, addressed relative to the ip */
+class MATHEXPR_API Constant : public MemLoc
+{
+    uint64_t _offset;
+
+public:
+    Constant(uint64_t offset) : _offset(offset) {}
+
+    virtual void print() const noexcept override {}
+
+    static constexpr int static_type_id() noexcept { return MemLocTypeId_Constant; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    /* Offset of the value from the start of the constant pool */
+    uint64_t get_offset() const noexcept { return this->_offset; }
+};
+
+/*
+    Element of a column of values, read by reduction loops. The pointer to the current row of the
+    column is stored at [base + pointer offset], the element is at element offset from it. Can't be
+    used as a memory operand, the pointer has to be loaded first
+*/
+class MATHEXPR_API Column : public MemLoc
+{
+    RegisterId _base_ptr;
+    uint64_t _pointer_offset;
+    uint64_t _element_offset;
+
+public:
+    Column(RegisterId base_ptr,
+           uint64_t pointer_offset,
+           uint64_t element_offset) : _base_ptr(base_ptr),
+                                      _pointer_offset(pointer_offset),
+                                      _element_offset(element_offset) {}
+
+    virtual void print() const noexcept override {}
+
+    static constexpr int static_type_id() noexcept { return MemLocTypeId_Column; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    RegisterId get_base_ptr_register() const noexcept { return this->_base_ptr; }
+
+    uint64_t get_pointer_offset() const noexcept { return this->_pointer_offset; }
+
+    uint64_t get_element_offset() const noexcept { return this->_element_offset; }
+};
+
 template<typename T>
 const T* memloc_const_cast(const MemLoc* loc) noexcept
 {
@@ -126,27 +179,32 @@ T* memloc_cast(MemLoc* loc) noexcept
     return nullptr;
 }
 
+/* Returns true if both memory locations designate the same register or memory slot */
+MATHEXPR_API bool memloc_equals(const MemLoc* a, const MemLoc* b) noexcept;
+
 class MATHEXPR_API RegisterAllocator
 {
-    std::unordered_map<SSAStmtPtr, MemLocPtr> _mapping;
+    /* Memory location of each statement, indexed like the statements of the allocated SSA */
+    std::vector<MemLocPtr> _mapping;
     PlatformABIPtr _platform_abi;
 
     static bool prepass_commutative_operand_swap(SSA& ssa) noexcept;
 
-    const MemLocPtr get_reusable_register(const SSAStmtPtr& statement) const noexcept;
-
 public:
     RegisterAllocator(PlatformABIPtr platform_abi) : _platform_abi(platform_abi) {}
 
     bool allocate(SSA& ssa, const SymbolTable& symtable) noexcept;
 
-    MemLocPtr get_memloc(SSAStmtPtr& stmt) const noexcept
+    MemLocPtr get_memloc(uint32_t stmt) const noexcept
     {
         static MemLocPtr invalid = std::make_shared<MemLocInvalid>();
 
-        auto it = this->_mapping.find(stmt);
+        if(stmt >= this->_mapping.size() || this->_mapping[stmt] == nullptr)
+        {
+            return invalid;
+        }
 
-        return it != this->_mapping.end() ? it->second : invalid;
+        return this->_mapping[stmt];
     }
 };
 
@@ -8,26 +8,34 @@
 #define __MATHEXPR_SSA
 
 #include "mathexpr/ast.hpp"
+#include "mathexpr/symtable.hpp"
 #include "mathexpr/platform.hpp"
 
+#include <unordered_map>
+
 MATHEXPR_NAMESPACE_BEGIN
 
-enum SSAStmtTypeId : int
+enum SSAStmtTypeId : uint32_t
 {
     SSAStmtTypeId_Variable = 1,
     SSAStmtTypeId_Literal = 2,
     SSAStmtTypeId_UnOp = 3,
     SSAStmtTypeId_BinOp = 4,
     SSAStmtTypeId_FuncOp = 5,
-    SSAStmtTypeId_AllocateStackOp = 6,
-    SSAStmtTypeId_SpillOp = 7,
-    SSAStmtTypeId_LoadOp = 8,
+    SSAStmtTypeId_SpillOp = 6,
+    SSAStmtTypeId_LoadOp = 7,
+    SSAStmtTypeId_StoreOp = 8,
 };
 
 static constexpr char VERSION_CHAR = 't';
 
-static constexpr uint64_t INVALID_STMT_VERSION = std::numeric_limits<uint64_t>::max();
-static constexpr uint64_t INVALID_STMT_REGISTER = std::numeric_limits<uint64_t>::max();
+static constexpr uint32_t INVALID_STMT_INDEX = std::numeric_limits<uint32_t>::max();
+
+/* Variables of scalar expressions, reduction loops read theirs from columns of values */
+static constexpr uint32_t INVALID_STMT_ROW = std::numeric_limits<uint32_t>::max();
+
+/* Functions are called with their arguments in the operands of the statement */
+static constexpr size_t SSA_MAX_FUNCTION_ARGUMENTS = 3;
 
 struct LiveRange {
     uint64_t start;
@@ -46,317 +54,142 @@ struct LiveRange {
     }
 };
 
-class MATHEXPR_API SSAStmt
-{
-    uint64_t _version;
-    uint64_t _register;
-
-    LiveRange _range;
-
-    uint64_t _frequency;
-
-public:
-    SSAStmt(uint64_t version = INVALID_STMT_VERSION, 
-            uint64_t live_range_start = 0) : _version(version), 
-                                             _range(live_range_start, 
-                                                    live_range_start),
-                                             _register(INVALID_STMT_REGISTER),
-                                             _frequency(0) {}
-
-    virtual ~SSAStmt() = default;
-
-    virtual void print(std::ostream_iterator<char>& out) const noexcept = 0;
-
-    virtual uint64_t canonicalize() const noexcept = 0;
-
-    virtual int type_id() const noexcept = 0;
-
-    uint64_t get_version() const noexcept { return this->_version; }
-
-    void set_version(uint64_t version) noexcept { this->_version = version; }
-
-    uint64_t get_register() const noexcept { return this->_register; }
-
-    void set_register(uint64_t reg) noexcept { this->_register = reg; }
-
-    LiveRange& get_live_range() noexcept { return this->_range; }
-
-    const LiveRange& get_live_range() const noexcept { return this->_range; }
-
-    void increment_frequency() noexcept { this->_frequency++; }
-
-    uint64_t get_frequency() const noexcept { return this->_frequency; }
-};
-
-using SSAStmtPtr = std::shared_ptr<SSAStmt>;
-
-class MATHEXPR_API SSAStmtVariable : public SSAStmt
-{
-    std::string_view _name;
-
-public:
-    SSAStmtVariable(std::string_view name, 
-                    uint64_t version = INVALID_STMT_VERSION,
-                    uint64_t live_range_start = 0) : SSAStmt(version, live_range_start), 
-                                                     _name(name) {}
-
-    virtual ~SSAStmtVariable() override {}
-
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
-
-    virtual uint64_t canonicalize() const noexcept override;
-
-    static constexpr int static_type_id() { return 1; }
-
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
-
-    std::string_view get_name() const noexcept { return this->_name; }
-};
-
-class MATHEXPR_API SSAStmtLiteral : public SSAStmt
+/*
+    Statements are stored by value, contiguously, and identified by their index in the SSA, which is
+    also their version. Operands are the indices of the statements defining them, names are indices
+    in the names of the SSA. The fields depend on the type:
+
+    type        op              a               b               c
+    Variable    name            row
+    Literal     name
+    UnOp        UnaryOpType     operand
+    BinOp       BinaryOpType    left            right
+    FuncOp      name            argument 0      argument 1      argument 2
+    SpillOp                     operand
+    LoadOp                      source
+    StoreOp                     operand         output index    accumulate
+
+    Unused arguments of function calls are INVALID_STMT_INDEX
+*/
+struct SSAStmt
 {
-    std::string_view _name;
-
-public:
-    SSAStmtLiteral(std::string_view name,
-                   uint64_t version = INVALID_STMT_VERSION,
-                   uint64_t live_range_start = 0) : SSAStmt(version, live_range_start), 
-                                                    _name(name) {}
-
-    virtual ~SSAStmtLiteral() override {}
+    uint32_t type;
+    uint32_t op;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
 
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
+    uint32_t type_id() const noexcept { return this->type; }
 
-    virtual uint64_t canonicalize() const noexcept override;
+    /* Returns true if the statement is a variable read from a column, in reduction loops */
+    bool is_column_element() const noexcept { return this->type == SSAStmtTypeId_Variable && this->a != INVALID_STMT_ROW; }
 
-    static constexpr int static_type_id() { return 2; }
+    bool is_accumulate() const noexcept { return this->type == SSAStmtTypeId_StoreOp && this->c != 0; }
 
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
-
-    std::string_view get_name() const noexcept { return this->_name; }
-};
-
-class MATHEXPR_API SSAStmtUnOp : public SSAStmt
-{
-    SSAStmtPtr _operand;
-
-    uint32_t _op;
-
-public:
-    SSAStmtUnOp(SSAStmtPtr operand,
-                uint32_t op,
-                uint64_t version = INVALID_STMT_VERSION,
-                uint64_t live_range_start = 0) : SSAStmt(version, live_range_start), 
-                                                 _operand(operand),
-                                                 _op(op) {}
-
-    virtual ~SSAStmtUnOp() override {}
-
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
-
-    virtual uint64_t canonicalize() const noexcept override;
-
-    static constexpr int static_type_id() { return 3; }
-
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
-
-    SSAStmtPtr& get_operand() noexcept { return this->_operand; }
-
-    const SSAStmtPtr& get_operand() const noexcept { return this->_operand; }
-
-    void set_operand(SSAStmtPtr& operand) noexcept { this->_operand = operand; }
-};
-
-class MATHEXPR_API SSAStmtBinOp : public SSAStmt
-{
-    SSAStmtPtr _left;
-    SSAStmtPtr _right;
-
-    uint32_t _op;
-
-public:
-    SSAStmtBinOp(SSAStmtPtr left,
-                 SSAStmtPtr right,
-                 uint32_t op,
-                 uint64_t version = INVALID_STMT_VERSION,
-                 uint64_t live_range_start = 0) : SSAStmt(version, live_range_start),
-                                                  _left(left),
-                                                  _right(right),
-                                                  _op(op) {}
-
-    virtual ~SSAStmtBinOp() override {}
-
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
-
-    virtual uint64_t canonicalize() const noexcept override;
-
-    static constexpr int static_type_id() { return 4; }
-
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
-
-    SSAStmtPtr& get_left() noexcept { return this->_left; }
-
-    const SSAStmtPtr& get_left() const noexcept { return this->_left; }
-
-    void set_left(SSAStmtPtr& left) noexcept { this->_left = left; }
-
-    SSAStmtPtr& get_right() noexcept { return this->_right; }
-
-    const SSAStmtPtr& get_right() const noexcept { return this->_right; }
+    size_t get_num_arguments() const noexcept
+    {
+        return (this->a != INVALID_STMT_INDEX) + (this->b != INVALID_STMT_INDEX) + (this->c != INVALID_STMT_INDEX);
+    }
 
-    void set_right(SSAStmtPtr& right) noexcept { this->_right = right; }
+    uint32_t* get_arguments() noexcept { return &this->a; }
 
-    void swap_operands() noexcept { std::swap(this->_left, this->_right); }
+    const uint32_t* get_arguments() const noexcept { return &this->a; }
 
-    uint32_t get_op() const noexcept { return this->_op; }
+    bool operator==(const SSAStmt& other) const noexcept = default;
 };
 
-class MATHEXPR_API SSAStmtFunctionOp : public SSAStmt
-{
-    std::vector<SSAStmtPtr> _arguments;
-
-    std::string_view _name;
+static_assert(sizeof(SSAStmt) == 20);
 
-public:
-    SSAStmtFunctionOp(std::string_view name,
-                      std::vector<SSAStmtPtr> arguments,
-                      uint64_t version = INVALID_STMT_VERSION,
-                      uint64_t live_range_start = 0) : SSAStmt(version, live_range_start),
-                                                       _name(name),
-                                                       _arguments(std::move(arguments)) {}
+/* x ^ y calls pow, unless y is a literal that can be specialized (see can_specialize_power) */
+static constexpr std::string_view POW_FUNCTION_NAME = "pow";
 
-    virtual ~SSAStmtFunctionOp() override {}
+MATHEXPR_API bool can_specialize_power(double exponent) noexcept;
 
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
+/* Statements already built, by canonical hash, to reuse common subexpressions */
+using SSAValueTable = std::unordered_multimap<uint64_t, uint32_t>;
 
-    virtual uint64_t canonicalize() const noexcept override;
-
-    static constexpr int static_type_id() { return 5; }
-
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
-
-    std::string_view get_name() const noexcept { return this->_name; }
-
-    std::vector<SSAStmtPtr>& get_arguments() noexcept { return this->_arguments; }
-    
-    const std::vector<SSAStmtPtr>& get_arguments() const noexcept { return this->_arguments; }
-};
-
-class MATHEXPR_API SSAStmtAllocateStackOp : public SSAStmt
+class MATHEXPR_API SSA
 {
-    uint64_t _size;
+    std::vector<SSAStmt> _statements;
 
-public:
-    SSAStmtAllocateStackOp(uint64_t stack_size,
-                           uint64_t version = INVALID_STMT_VERSION,
-                           uint64_t live_range_start = 0) : SSAStmt(version),
-                                                            _size(stack_size) {}
-
-    virtual ~SSAStmtAllocateStackOp() override {}
+    /* Names of the variables, literals and functions, each name is stored once */
+    std::vector<std::string_view> _names;
+    std::unordered_map<std::string_view, uint32_t> _name_ids;
 
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
+    /* Indexed like the statements, see calculate_live_ranges */
+    std::vector<LiveRange> _live_ranges;
 
-    virtual uint64_t canonicalize() const noexcept override;
+    /* Stack space needed by the spills, set by the register allocator */
+    uint64_t _stack_size = 0;
+    bool _frame_pointer = false;
 
-    static constexpr int static_type_id() { return 6; }
+    void clear() noexcept;
 
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
+    /* Variables are read at row of their columns when row is not INVALID_STMT_ROW */
+    uint32_t build_expression(const ASTNode* root,
+                              SSAValueTable& values,
+                              uint32_t row = INVALID_STMT_ROW) noexcept;
 
-    uint64_t get_stack_size() const noexcept { return this->_size; }
-};
+    /* Appends the statement, or returns the index of the equivalent one already built */
+    uint32_t add_statement(const SSAStmt& stmt, SSAValueTable& values) noexcept;
 
-class MATHEXPR_API SSAStmtSpillOp : public SSAStmt
-{
-    SSAStmtPtr _operand;
+    /* base ^ exponent as multiplications, exponent must satisfy can_specialize_power */
+    uint32_t add_power(uint32_t base, double exponent, SSAValueTable& values) noexcept;
 
 public:
-    SSAStmtSpillOp(SSAStmtPtr operand,
-                   uint64_t version = INVALID_STMT_VERSION,
-                   uint64_t live_range_start = 0) : SSAStmt(version),
-                                                    _operand(operand) {}
-
-    virtual ~SSAStmtSpillOp() override {}
-
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
-
-    virtual uint64_t canonicalize() const noexcept override;
-
-    static constexpr int static_type_id() { return 7; }
-
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
+    SSA() {}
 
-    SSAStmtPtr& get_operand() noexcept { return this->_operand; }
+    void calculate_live_ranges() noexcept;
 
-    const SSAStmtPtr& get_operand() const noexcept { return this->_operand; }
-};
-
-class MATHEXPR_API SSAStmtLoadOp : public SSAStmt
-{
-    SSAStmtPtr _spill;
+    void print() const noexcept;
 
-public:
-    SSAStmtLoadOp(SSAStmtPtr spill,
-                  uint64_t version = INVALID_STMT_VERSION,
-                  uint64_t live_range_start = 0) : SSAStmt(version),
-                                                   _spill(spill) {}
+    bool build_from_ast(const AST& ast) noexcept;
 
-    virtual ~SSAStmtLoadOp() override {}
+    /*
+        Parses the expression straight to SSA in a single pass, without tokens nor AST (see
+        parser.cpp). Computes the same value as the SSA built by build_from_ast, the symbols are
+        added to the symbol table as they are parsed instead of being collected
+    */
+    bool build_from_source(std::string_view expression, SymbolTable& symtable) noexcept;
 
-    virtual void print(std::ostream_iterator<char>& out) const noexcept override;
+    /* Builds the expressions in a single SSA, each result being stored to its slot of the outputs */
+    bool build_from_asts(const std::vector<AST>& asts) noexcept;
 
-    virtual uint64_t canonicalize() const noexcept override;
+    /*
+        Builds the expression followed by its reverse-mode derivatives (see autodiff.cpp). The value
+        is stored to the output 0 and the partial derivative of the variable of id i to the output
+        i + 1. The literals needed by the derivatives are added to the symbol table
+    */
+    bool build_gradient_from_ast(const AST& ast, SymbolTable& symtable) noexcept;
 
-    static constexpr int static_type_id() { return 8; }
+    /*
+        Builds the body of a reduction loop (see ExprReduction) over unroll consecutive rows. The
+        expression of row k reads the variables at row k of their columns and is accumulated to the
+        output k, so each row has its own accumulator and the additions don't depend on each other
+    */
+    bool build_reduction_from_ast(const AST& ast, uint32_t unroll) noexcept;
 
-    virtual int type_id() const noexcept override { return this->static_type_id(); }
+    /* Returns the id of the name, adding it if it is not stored yet */
+    uint32_t add_name(std::string_view name) noexcept;
 
-    SSAStmtPtr& get_spill() noexcept { return this->_spill; }
+    std::string_view get_name(uint32_t id) const noexcept { return this->_names[id]; }
 
-    const SSAStmtPtr& get_spill() const noexcept { return this->_spill; }
-};
+    const std::vector<SSAStmt>& get_statements() const noexcept { return this->_statements; }
 
-template<typename T>
-const T* statement_const_cast(const SSAStmt* stmt) noexcept
-{
-    if(stmt != nullptr && stmt->type_id() == T::static_type_id())
-    {
-        return static_cast<const T*>(stmt);
-    }
+    std::vector<SSAStmt>& get_statements() noexcept { return this->_statements; }
 
-    return nullptr;
-}
+    const std::vector<LiveRange>& get_live_ranges() const noexcept { return this->_live_ranges; }
 
-template<typename T>
-T* statement_cast(SSAStmt* stmt) noexcept
-{
-    if(stmt != nullptr && stmt->type_id() == T::static_type_id())
+    void set_stack_allocation(uint64_t stack_size, bool frame_pointer) noexcept
     {
-        return static_cast<T*>(stmt);
+        this->_stack_size = stack_size;
+        this->_frame_pointer = frame_pointer;
     }
 
-    return nullptr;
-}
-
-MATHEXPR_API bool ssa_statement_needs_register(const SSAStmt* stmt) noexcept;
-
-class MATHEXPR_API SSA
-{
-    std::vector<SSAStmtPtr> _statements;
-
-    uint64_t get_statement_number() const noexcept { return this->_statements.size(); }
-
-public:
-    SSA() {}
-
-    bool calculate_live_ranges() noexcept;
-
-    void print() const noexcept;
-
-    bool build_from_ast(const AST& ast) noexcept;
-
-    const std::vector<SSAStmtPtr>& get_statements() const noexcept { return this->_statements; }
+    uint64_t get_stack_size() const noexcept { return this->_stack_size; }
 
-    std::vector<SSAStmtPtr>& get_statements() noexcept { return this->_statements; }
+    /* Spills are addressed from rbp when true, from rsp otherwise */
+    bool has_frame_pointer() const noexcept { return this->_frame_pointer; }
 };
 
 MATHEXPR_NAMESPACE_END
@@ -8,9 +8,12 @@
 #define __MATHEXPR_SYMTABLE
 
 #include "mathexpr/ast.hpp"
+#include "mathexpr/constants.hpp"
 
 #include <string_view>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <format>
 
 MATHEXPR_NAMESPACE_BEGIN
@@ -21,6 +24,12 @@ static constexpr size_t VALUE_OFFSET = sizeof(double);
 
 static constexpr size_t INVALID_OFFSET = std::numeric_limits<size_t>::max();
 
+/*
+    Constants added while compiling (x ^ 0 is 1, conditions are compared against 0, derivatives...) are
+    named with this prefix, which cannot start an expression literal
+*/
+static constexpr char INTERNAL_LITERAL_PREFIX = '$';
+
 class MATHEXPR_API Symbol 
 {
     std::string_view _name;
@@ -35,14 +44,14 @@ public:
 
     size_t get_id() const noexcept { return this->_id; }
 
-    size_t get_offset() const noexcept 
+    size_t get_offset(size_t value_size = VALUE_OFFSET) const noexcept 
     { 
         if(!this->valid())
         {
             return INVALID_OFFSET;
         }
 
-        return this->_id * VALUE_OFFSET;
+        return this->_id * value_size;
     }
 
     bool valid() const noexcept { return this->_id != INVALID_SYMBOL_ID; }
@@ -66,18 +75,31 @@ public:
     SymbolLiteral(double value, std::string_view name, size_t id) : Symbol(name, id), _value(value) {}
 
     double get_value() const noexcept { return this->_value; }
+
+    bool is_internal() const noexcept { return this->get_name().starts_with(INTERNAL_LITERAL_PREFIX); }
 };
 
 class MATHEXPR_API SymbolTable
 {
-    std::map<std::string_view, SymbolVariable> _variables;
+    /* Looked up on each reference to a symbol, ordered by id when printed */
+    std::unordered_map<std::string_view, SymbolVariable> _variables;
+
+    std::unordered_map<std::string_view, SymbolLiteral> _literals;
 
-    std::map<std::string_view, SymbolLiteral> _literals;
+    /* Literals share their slot with the ones of the same value (1, 1.0 and 0x1p0), keyed by their bits */
+    std::unordered_map<uint64_t, size_t> _literal_ids;
 
-    std::map<std::string_view, std::vector<const ASTNodeFunctionOp*>> _functions;
+    /* Internal literals don't share the slots of the expression literals, which can be updated. They come after them */
+    std::unordered_map<uint64_t, size_t> _internal_literal_ids;
+
+    /* Number of calls per function */
+    std::map<std::string_view, size_t> _functions;
+
+    /* Size of a variable or literal in the values buffer and the constant pool */
+    size_t _value_size;
 
 public:
-    SymbolTable() {}
+    SymbolTable(size_t value_size = VALUE_OFFSET) : _value_size(value_size) {}
 
     ~SymbolTable() {}
 
@@ -87,16 +109,34 @@ public:
 
     void collect(const AST& ast) noexcept;
 
+    /*
+        Symbols are added if they are not stored yet, their ids follow the order of addition. A
+        literal gets the id of the literals of the same value already added
+    */
+    void add_variable(std::string_view name) noexcept;
+
+    void add_literal(std::string_view name, double value) noexcept;
+
+    void add_function_call(std::string_view name) noexcept { this->_functions[name]++; }
+
+    /* Removes the variables and literals whose name is not used, the others are renumbered in the same order */
+    void remove_unused_symbols(const std::unordered_set<std::string_view>& used_names) noexcept;
+
     size_t get_variable_offset(std::string_view variable_name) const noexcept;
 
     size_t get_literal_offset(std::string_view literal_name) const noexcept;
 
-    const std::map<std::string_view, SymbolVariable>& get_variables() const noexcept
+    size_t get_value_size() const noexcept { return this->_value_size; }
+
+    /* Number of slots of the constant pool, several literals can share one */
+    size_t get_num_literals() const noexcept { return this->_literal_ids.size() + this->_internal_literal_ids.size(); }
+
+    const std::unordered_map<std::string_view, SymbolVariable>& get_variables() const noexcept
     {
         return this->_variables;
     }
 
-    const std::map<std::string_view, SymbolLiteral>& get_literals() const noexcept
+    const std::unordered_map<std::string_view, SymbolLiteral>& get_literals() const noexcept
     {
         return this->_literals;
     }
@@ -69,9 +69,31 @@ static constexpr std::byte REX_B    = BYTE(0x01);  // Extension of R/M field or
     SUBSD       0xF2, 0x0F, 0x5C
     MULSD       0xF2, 0x0F, 0x59
     DIVSD       0xF2, 0x0F, 0x5E
+    CMPSD       0xF2, 0x0F, 0xC2   xmm, xmm/mem, imm8 (predicate)
+
+    bitwise ops (full register)
+    ANDPD       0x66, 0x0F, 0x54   xmm, xmm
+    ANDNPD      0x66, 0x0F, 0x55
+    ORPD        0x66, 0x0F, 0x56
+    PSRLQ       0x66, 0x0F, 0x73 /2   xmm, imm8
+    PSLLQ       0x66, 0x0F, 0x73 /6   xmm, imm8
 
     unops
-    SQRTSD      0xF2, 0x0F, 0x51
+    SQRTSD      0xF2, 0x0F, 0x51   xmm, xmm/mem
+
+    single precision (ExprCompileFlags_Float32) uses the same opcodes, with the F3 prefix for
+    scalar ops (movss, addss ...) and no prefix for packed ops (andps ...)
+    PSRLD       0x66, 0x0F, 0x72 /2   xmm, imm8
+    PSLLD       0x66, 0x0F, 0x72 /6   xmm, imm8
+
+    reduction loops (general purpose, REX.W)
+    MOV         0x8B /r            r64, [mem]
+    MOV         0x89 /r            [mem], r64
+    LEA         0x8D /r            r64, [mem]
+    ADD/SUB/CMP 0x83 /0 /5 /7 ib   [mem], imm8 (0x81 with imm32)
+    JB          0x0F, 0x82         rel32
+    JMP         0xE9               rel32
+    CVTSI2SD    0xF2, REX.W, 0x0F, 0x2A   xmm, [mem]
 
     terminators
     RET         0xC3               return
@@ -98,114 +120,436 @@ static constexpr std::byte MOD_DIRECT          = BYTE(0xC0);  // Register to reg
 // Prefixes for pretty-printing of bytecode
 static const std::unordered_set<std::byte> prefixes = {
     BYTE(0xF2), /* fp64 ops */
+    BYTE(0xF3), /* fp32 ops */
+    BYTE(0x66), /* packed fp64 and integer ops */
     BYTE(0xC3), /* ret */
     BYTE(0xC9), /* leave */
     BYTE(0x55), /* push rbp */
     BYTE(0x48), /* mov */
 };
 
+/* Instruction ids, used by the peephole optimizer to inspect the instruction stream */
+enum InstrTypeId : int
+{
+    InstrTypeId_Mov = 1,
+    InstrTypeId_Prologue = 2,
+    InstrTypeId_Epilogue = 3,
+    InstrTypeId_Neg = 4,
+    InstrTypeId_Add = 5,
+    InstrTypeId_Sub = 6,
+    InstrTypeId_Mul = 7,
+    InstrTypeId_Div = 8,
+    InstrTypeId_Call = 9,
+    InstrTypeId_Ret = 10,
+    InstrTypeId_Cmp = 11,
+    InstrTypeId_And = 12,
+    InstrTypeId_AndNot = 13,
+    InstrTypeId_Or = 14,
+    InstrTypeId_MaskToBool = 15,
+    InstrTypeId_Sqrt = 16,
+    InstrTypeId_ReductionBegin = 17,
+    InstrTypeId_LoopBegin = 18,
+    InstrTypeId_LoopEnd = 19,
+    InstrTypeId_ReductionEnd = 20,
+};
+
+/*
+    Base of the floating point instructions, encoded in double (sd/pd) or single (ss/ps) precision
+    depending on the value type the expression is compiled for
+*/
+class MATHEXPR_API InstrFP : public Instr
+{
+    uint32_t _value_type;
+
+public:
+    InstrFP(uint32_t value_type) : _value_type(value_type) {}
+
+    uint32_t get_value_type() const noexcept { return this->_value_type; }
+
+    /* Mandatory prefix of scalar instructions, F2 for sd and F3 for ss */
+    std::byte get_scalar_prefix() const noexcept
+    {
+        return this->_value_type == ValueType_Float32 ? BYTE(0xF3) : BYTE(0xF2);
+    }
+
+    /* Packed instructions use the 66 prefix for pd and none for ps */
+    void encode_packed_prefix(ByteCode& out) const noexcept
+    {
+        if(this->_value_type != ValueType_Float32)
+            out.push_back(BYTE(0x66));
+    }
+
+    const char* get_scalar_suffix() const noexcept { return this->_value_type == ValueType_Float32 ? "ss" : "sd"; }
+
+    const char* get_packed_suffix() const noexcept { return this->_value_type == ValueType_Float32 ? "ps" : "pd"; }
+};
+
 /* Mem related-instructions */
 
-class MATHEXPR_API InstrMov : public Instr
+class MATHEXPR_API InstrMov : public InstrFP
 {
     MemLocPtr _mem_loc_from;
     MemLocPtr _mem_loc_to;
 
 public:
-    InstrMov(MemLocPtr& from, MemLocPtr& to) : _mem_loc_from(from),
-                                               _mem_loc_to(to) {}
+    InstrMov(MemLocPtr& from,
+             MemLocPtr& to,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _mem_loc_from(from),
+                                                        _mem_loc_to(to) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Mov; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_from() const noexcept { return this->_mem_loc_from; }
+
+    const MemLocPtr& get_to() const noexcept { return this->_mem_loc_to; }
+
+    /* Constant operands are addressed relative to the ip and patched once the constant pool is placed */
+    virtual bool needs_linking() const noexcept override { return this->_mem_loc_from->type_id() == MemLocTypeId_Constant; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
 };
 
+/*
+    With a frame pointer: push rbp; mov rbp, rsp; sub rsp, size + 8 / leave
+    Without: sub rsp, size / add rsp, size
+    In both cases the body runs with rsp = 8 (mod 16), as on function entry
+*/
 class MATHEXPR_API InstrPrologue : public Instr
 {
     uint64_t _stack_size;
+    bool _frame_pointer;
 
 public:
-    InstrPrologue(uint64_t stack_size) : _stack_size(stack_size) {}
+    InstrPrologue(uint64_t stack_size, bool frame_pointer) : _stack_size(stack_size),
+                                                             _frame_pointer(frame_pointer) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Prologue; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
 };
 
 class MATHEXPR_API InstrEpilogue : public Instr
 {
     uint64_t _stack_size;
+    bool _frame_pointer;
 
 public:
-    InstrEpilogue(uint64_t stack_size) : _stack_size(stack_size) {}
+    InstrEpilogue(uint64_t stack_size, bool frame_pointer) : _stack_size(stack_size),
+                                                             _frame_pointer(frame_pointer) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Epilogue; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
 };
 
 /* Unary ops instructions */
 
-class MATHEXPR_API InstrNeg : public Instr
+/* xorpd with the sign mask, which the code generator places 16 bytes aligned before the constant pool */
+class MATHEXPR_API InstrNeg : public InstrFP
 {
     MemLocPtr _operand;
 
 public:
-    InstrNeg(MemLocPtr& operand) : _operand(operand) {}
+    InstrNeg(MemLocPtr& operand,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _operand(operand) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Neg; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_operand() const noexcept { return this->_operand; }
+
+    virtual bool needs_linking() const noexcept override { return true; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
+};
+
+/*
+    Shifts an all-ones mask to the bit pattern of 1.0 (psrlq 54, psllq 52, or psrld 25, pslld 23 in
+    single precision), zero stays zero
+*/
+class MATHEXPR_API InstrMaskToBool : public InstrFP
+{
+    MemLocPtr _operand;
+
+public:
+    InstrMaskToBool(MemLocPtr& operand,
+                    uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                               _operand(operand) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_MaskToBool; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_operand() const noexcept { return this->_operand; }
+};
+
+class MATHEXPR_API InstrSqrt : public InstrFP
+{
+    MemLocPtr _operand;
+
+public:
+    InstrSqrt(MemLocPtr& operand,
+              uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                         _operand(operand) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Sqrt; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_operand() const noexcept { return this->_operand; }
 };
 
 /* Binary ops instructions */
 
-class MATHEXPR_API InstrAdd : public Instr
+class MATHEXPR_API InstrAdd : public InstrFP
+{
+    MemLocPtr _left;
+    MemLocPtr _right;
+
+public:
+    InstrAdd(MemLocPtr& left,
+             MemLocPtr& right,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _left(left),
+                                                        _right(right) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Add; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
+
+    virtual bool needs_linking() const noexcept override { return this->_right->type_id() == MemLocTypeId_Constant; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
+};
+
+class MATHEXPR_API InstrSub : public InstrFP
+{
+    MemLocPtr _left;
+    MemLocPtr _right;
+
+public:
+    InstrSub(MemLocPtr& left,
+             MemLocPtr& right,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _left(left),
+                                                        _right(right) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Sub; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
+
+    virtual bool needs_linking() const noexcept override { return this->_right->type_id() == MemLocTypeId_Constant; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
+};
+
+class MATHEXPR_API InstrMul : public InstrFP
+{
+    MemLocPtr _left;
+    MemLocPtr _right;
+
+public:
+    InstrMul(MemLocPtr& left,
+             MemLocPtr& right,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _left(left),
+                                                        _right(right) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Mul; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
+
+    virtual bool needs_linking() const noexcept override { return this->_right->type_id() == MemLocTypeId_Constant; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
+};
+
+class MATHEXPR_API InstrDiv : public InstrFP
 {
     MemLocPtr _left;
     MemLocPtr _right;
 
 public:
-    InstrAdd(MemLocPtr& left, MemLocPtr& right) : _left(left),
-                                                  _right(right) {}
+    InstrDiv(MemLocPtr& left,
+             MemLocPtr& right,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _left(left),
+                                                        _right(right) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Div; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
+
+    virtual bool needs_linking() const noexcept override { return this->_right->type_id() == MemLocTypeId_Constant; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
 };
 
-class MATHEXPR_API InstrSub : public Instr
+/* cmpsd, the predicate is the comparison op (BinaryOpType_Eq, Neq, Lt or Le) */
+class MATHEXPR_API InstrCmp : public InstrFP
 {
     MemLocPtr _left;
     MemLocPtr _right;
 
+    uint32_t _op;
+
 public:
-    InstrSub(MemLocPtr& left, MemLocPtr& right) : _left(left),
-                                                  _right(right) {}
+    InstrCmp(MemLocPtr& left,
+             MemLocPtr& right,
+             uint32_t op,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _left(left),
+                                                        _right(right),
+                                                        _op(op) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Cmp; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
+
+    uint32_t get_op() const noexcept { return this->_op; }
+
+    virtual bool needs_linking() const noexcept override { return this->_right->type_id() == MemLocTypeId_Constant; }
+
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
 };
 
-class MATHEXPR_API InstrMul : public Instr
+/* Bitwise ops on comparison masks, their right operand is a register (memory operands must be 16 bytes aligned) */
+
+class MATHEXPR_API InstrAnd : public InstrFP
 {
     MemLocPtr _left;
     MemLocPtr _right;
 
 public:
-    InstrMul(MemLocPtr& left, MemLocPtr& right) : _left(left),
-                                                  _right(right) {}
+    InstrAnd(MemLocPtr& left,
+             MemLocPtr& right,
+             uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                        _left(left),
+                                                        _right(right) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_And; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
 };
 
-class MATHEXPR_API InstrDiv : public Instr
+class MATHEXPR_API InstrAndNot : public InstrFP
 {
     MemLocPtr _left;
     MemLocPtr _right;
 
 public:
-    InstrDiv(MemLocPtr& left, MemLocPtr& right) : _left(left),
-                                                  _right(right) {}
+    InstrAndNot(MemLocPtr& left,
+                MemLocPtr& right,
+                uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                           _left(left),
+                                                           _right(right) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_AndNot; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
+};
+
+class MATHEXPR_API InstrOr : public InstrFP
+{
+    MemLocPtr _left;
+    MemLocPtr _right;
+
+public:
+    InstrOr(MemLocPtr& left,
+            MemLocPtr& right,
+            uint32_t value_type = ValueType_Float64) : InstrFP(value_type),
+                                                       _left(left),
+                                                       _right(right) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Or; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    const MemLocPtr& get_left() const noexcept { return this->_left; }
+
+    const MemLocPtr& get_right() const noexcept { return this->_right; }
 };
 
 /* Func ops instructions */
@@ -214,15 +558,142 @@ class MATHEXPR_API InstrCall : public Instr
 {
     std::string_view _call_name;
 
+    /* Caller-saved gp registers we need after the call (base pointers), pushed around it */
+    std::vector<RegisterId> _preserved_registers;
+
+    /* Shadow space and padding to keep the stack aligned to 16 bytes at the call */
+    uint64_t _stack_adjust;
+
+    /* Consecutive calls can share the save/restore sequence, see the peephole optimizer */
+    bool _save = true;
+    bool _restore = true;
+
+    std::size_t get_preserved_registers_size() const noexcept;
+
 public:
-    InstrCall(std::string_view call_name) : _call_name(call_name) {}
+    InstrCall(std::string_view call_name,
+              std::vector<RegisterId> preserved_registers = {},
+              uint64_t stack_adjust = 0) : _call_name(call_name),
+                                           _preserved_registers(std::move(preserved_registers)),
+                                           _stack_adjust(stack_adjust) {}
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
 
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Call; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+
+    void set_save(bool save) noexcept { this->_save = save; }
+
+    void set_restore(bool restore) noexcept { this->_restore = restore; }
+
     virtual bool needs_linking() const noexcept override { return true; }
 
-    virtual RelocInfo get_link_info(std::size_t bytecode_start) const noexcept override;
+    virtual RelocInfo get_link_info(std::size_t bytecode_start,
+                                    std::size_t bytecode_end) const noexcept override;
+};
+
+/*
+    Reduction loops, see CodeGenerator::build_reduction. The reduction begin allocates a block on the
+    stack and points the base pointers to it:
+    variables base -> [column pointers (8 bytes each)][remaining rows][row count]
+    outputs base   -> [accumulators]
+    The column pointers are moved to the next rows at the end of each iteration, so the variables
+    of the body are read at a constant offset from them
+*/
+class MATHEXPR_API InstrReductionBegin : public Instr
+{
+    RegisterId _variable_base_ptr;
+    RegisterId _output_base_ptr;
+
+    uint64_t _num_columns;
+    uint64_t _num_accumulators;
+
+public:
+    InstrReductionBegin(RegisterId variable_base_ptr,
+                        RegisterId output_base_ptr,
+                        uint64_t num_columns,
+                        uint64_t num_accumulators) : _variable_base_ptr(variable_base_ptr),
+                                                     _output_base_ptr(output_base_ptr),
+                                                     _num_columns(num_columns),
+                                                     _num_accumulators(num_accumulators) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_ReductionBegin; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+};
+
+/* cmp qword [remaining rows], step; jb end of the loop, the jump is patched by the loop end */
+class MATHEXPR_API InstrLoopBegin : public Instr
+{
+    RegisterId _variable_base_ptr;
+
+    uint64_t _num_columns;
+    uint64_t _step;
+
+    /* Positions in the bytecode being emitted, read by the loop end to encode its jumps */
+    mutable const ByteCode* _bytecode = nullptr;
+    mutable std::size_t _head_offset = 0;
+    mutable std::size_t _exit_displacement_offset = 0;
+
+    friend class InstrLoopEnd;
+
+public:
+    InstrLoopBegin(RegisterId variable_base_ptr,
+                   uint64_t num_columns,
+                   uint64_t step) : _variable_base_ptr(variable_base_ptr),
+                                    _num_columns(num_columns),
+                                    _step(step) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_LoopBegin; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+};
+
+/* Moves the column pointers by step rows, decrements the remaining rows and jumps back to the loop begin */
+class MATHEXPR_API InstrLoopEnd : public Instr
+{
+    std::shared_ptr<const InstrLoopBegin> _begin;
+
+public:
+    InstrLoopEnd(std::shared_ptr<const InstrLoopBegin> begin) : _begin(std::move(begin)) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_LoopEnd; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
+};
+
+/* Sums the accumulators pairwise in xmm0, divides by the row count for a mean and frees the block */
+class MATHEXPR_API InstrReductionEnd : public Instr
+{
+    uint64_t _num_columns;
+    uint64_t _num_accumulators;
+
+    bool _mean;
+
+public:
+    InstrReductionEnd(uint64_t num_columns,
+                      uint64_t num_accumulators,
+                      bool mean) : _num_columns(num_columns),
+                                   _num_accumulators(num_accumulators),
+                                   _mean(mean) {}
+
+    virtual void as_string(std::string& out) const noexcept override;
+    virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_ReductionEnd; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
 };
 
 /* Terminator instructions */
@@ -233,6 +704,10 @@ public:
 
     virtual void as_string(std::string& out) const noexcept override;
     virtual void as_bytecode(ByteCode& out) const noexcept override;
+
+    static constexpr int static_type_id() noexcept { return InstrTypeId_Ret; }
+
+    virtual int type_id() const noexcept override { return this->static_type_id(); }
 };
 
 X86_64_NAMESPACE_END
@@ -247,17 +722,27 @@ public:
     virtual bool is_valid() const noexcept override { return get_current_isa() == ISA_x86_64; }
 
     virtual InstrPtr create_mov(MemLocPtr& from, MemLocPtr& to) override;
-    virtual InstrPtr create_prologue(uint64_t stack_size) override;
-    virtual InstrPtr create_epilogue(uint64_t stack_size) override;
+    virtual InstrPtr create_prologue(uint64_t stack_size, bool frame_pointer) override;
+    virtual InstrPtr create_epilogue(uint64_t stack_size, bool frame_pointer) override;
     virtual InstrPtr create_neg(MemLocPtr& operand) override;
     virtual InstrPtr create_add(MemLocPtr& left, MemLocPtr& right) override;
     virtual InstrPtr create_sub(MemLocPtr& left, MemLocPtr& right) override;
     virtual InstrPtr create_mul(MemLocPtr& left, MemLocPtr& right) override;
     virtual InstrPtr create_div(MemLocPtr& left, MemLocPtr& right) override;
-    virtual InstrPtr create_call(std::string_view call_name) override;
+    virtual InstrPtr create_cmp(MemLocPtr& left, MemLocPtr& right, uint32_t op) override;
+    virtual InstrPtr create_and(MemLocPtr& left, MemLocPtr& right) override;
+    virtual InstrPtr create_andnot(MemLocPtr& left, MemLocPtr& right) override;
+    virtual InstrPtr create_or(MemLocPtr& left, MemLocPtr& right) override;
+    virtual InstrPtr create_mask_to_bool(MemLocPtr& operand) override;
+    virtual InstrPtr create_sqrt(MemLocPtr& operand) override;
+    virtual InstrPtr create_call(std::string_view call_name, bool preserve_outputs) override;
     virtual InstrPtr create_ret() override;
+    virtual InstrPtr create_reduction_begin(uint64_t num_columns, uint64_t num_accumulators) override;
+    virtual InstrPtr create_loop_begin(uint64_t num_columns, uint64_t step) override;
+    virtual InstrPtr create_loop_end(const InstrPtr& loop_begin) override;
+    virtual InstrPtr create_reduction_end(uint64_t num_columns, uint64_t num_accumulators, bool mean) override;
 
-    virtual void optimize_instr_sequence(std::vector<InstrPtr>& instructions) noexcept override;
+    virtual PeepholeStats optimize_instr_sequence(std::vector<InstrPtr>& instructions) noexcept override;
 };
 
 MATHEXPR_NAMESPACE_END
@@ -33,7 +33,7 @@ RegisterId WindowsX64ABI::get_variable_base_ptr() const noexcept
     return GpRegisters_x86_64_RCX;
 }
 
-RegisterId WindowsX64ABI::get_literal_base_ptr() const noexcept
+RegisterId WindowsX64ABI::get_output_base_ptr() const noexcept
 {
     return GpRegisters_x86_64_RDX;
 }
@@ -97,7 +97,7 @@ RegisterId LinuxX64ABI::get_variable_base_ptr() const noexcept
     return GpRegisters_x86_64_RDI;
 }
 
-RegisterId LinuxX64ABI::get_literal_base_ptr() const noexcept
+RegisterId LinuxX64ABI::get_output_base_ptr() const noexcept
 {
     return GpRegisters_x86_64_RSI;
 }
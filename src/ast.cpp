@@ -6,6 +6,7 @@
 #include "mathexpr/log.hpp"
 #include "mathexpr/op.hpp"
 
+#include <algorithm>
 #include <format>
 
 MATHEXPR_NAMESPACE_BEGIN
@@ -61,6 +62,14 @@ void ASTNodeBinaryOp::print(std::ostream_iterator<char>& out, size_t indent) con
     this->_right->print(out, indent + 1);
 }
 
+void ASTNodeBindingRef::print(std::ostream_iterator<char>& out, size_t indent) const noexcept
+{
+    std::format_to(out,
+                   "{}BINDING REF: {}\n",
+                   std::string(AST::PRINT_INDENT_SIZE * indent, ' '),
+                   this->_name);
+}
+
 void AST::print() const noexcept
 {
     static std::ostream_iterator<char> out(std::cout);
@@ -68,6 +77,13 @@ void AST::print() const noexcept
     if(this->_root)
     {
         std::format_to(out, "AST\n");
+
+        for(const auto& binding : this->_bindings)
+        {
+            std::format_to(out, "BINDING: {}\n", binding.name);
+            binding.value->print(out, 1);
+        }
+
         this->_root->print(out, 0);
         std::format_to(out, "\n");
     }
@@ -76,21 +92,64 @@ void AST::print() const noexcept
 /* Parsing */
 
 /*
-    expression = term { ("+" | "-" , term };
-    term = factor { ("*" | "/" | "%" , factor };
-    factor = literal | symbol | function "(" expression ")" | "(" expression ")" | "-" factor;
+    program = { symbol "=" expression ";" } expression [ ";" ];
+    expression = comparison [ "?" expression ":" expression ];
+    comparison = sum { ("<" | "<=" | ">" | ">=" | "==" | "!=") sum };
+    sum = term { ("+" | "-" , term };
+    term = power { ("*" | "/" | "%" , power };
+    power = factor [ "^" power ];
+    factor = literal | symbol | function "(" expression ")" | "(" expression ")" | "-" power;
+    literal = digits [ "." [ digits ] ] [ ("e" | "E") [ "+" | "-" ] digits ]
+            | ("0x" | "0X") hexdigits [ "." [ hexdigits ] ] [ ("p" | "P") [ "+" | "-" ] digits ];
+
+    cond ? a : b and select(cond, a, b) both build a select function op whose condition is a comparison
+    x ^ -n is rewritten 1 / x ^ n and x ^ 0 is 1, the SSA only specializes positive exponents
+    digits can be separated with underscores (1_000_000), literals are parsed in lexer_parse_literal
 */
 
 class Parser
 {
     const LexerTokens& _tokens;
 
+    std::vector<ASTBinding>& _bindings;
+
     std::string _error;
 
     size_t _index;
 
 public:
-    Parser(const LexerTokens& tokens) : _tokens(tokens), _index(0) {}
+    Parser(const LexerTokens& tokens, 
+           std::vector<ASTBinding>& bindings) : _tokens(tokens),
+                                                _bindings(bindings),
+                                                _index(0) {}
+
+    const std::string& get_error() const noexcept { return this->_error; }
+
+    /* Conditions that are not comparisons are compared against zero, as in C */
+    std::shared_ptr<ASTNode> make_select(std::vector<std::shared_ptr<ASTNode>> arguments) noexcept
+    {
+        if(arguments.size() != 3)
+        {
+            std::format_to(std::back_inserter(this->_error),
+                           "select expects 3 arguments (condition, if true, if false), got {}",
+                           arguments.size());
+
+            return nullptr;
+        }
+
+        auto condition = node_cast<ASTNodeBinaryOp>(arguments[0].get());
+
+        if(condition == nullptr || !op_binary_is_comparison(condition->get_op()))
+        {
+            arguments[0]->set_needs_reg(true);
+
+            arguments[0] = std::make_shared<ASTNodeBinaryOp>(arguments[0],
+                                                             std::make_shared<ASTNodeLiteral>(0.0, "$0.0"),
+                                                             BinaryOpType_Neq);
+        }
+
+        return std::make_shared<ASTNodeFunctionOp>(SELECT_FUNCTION_NAME, std::move(arguments));
+    }
 
     MATHEXPR_FORCE_INLINE void advance() noexcept { this->_index++; }
 
@@ -108,7 +167,7 @@ public:
 
     MATHEXPR_FORCE_INLINE const LexerToken& peek() const noexcept
     {
-        if(this->_index >= (this->_tokens.size() - 2))
+        if(this->_index + 1 >= this->_tokens.size())
         {
             return EMPTY_TOKEN;
         }
@@ -125,11 +184,9 @@ public:
                 const std::string_view& lit = this->current().data;
                 double result;
 
-                auto [ptr, ec] = std::from_chars(lit.data(), lit.data() + lit.size(), result);
-
-                if(ec != std::errc())
+                if(!lexer_parse_literal(lit, result))
                 {
-                    std::format_to(std::back_inserter(this->_error), "Unknown error caught while parsing a literal");
+                    std::format_to(std::back_inserter(this->_error), "Cannot represent literal: {}", lit);
                     return nullptr;
                 }
 
@@ -176,12 +233,27 @@ public:
 
                     this->advance();
 
+                    if(name == SELECT_FUNCTION_NAME)
+                    {
+                        return this->make_select(std::move(arguments));
+                    }
+
                     return std::make_shared<ASTNodeFunctionOp>(name, std::move(arguments));
                 }
                 else
                 {
                     this->advance();
 
+                    /* The latest binding wins, so a name can be rebound from its previous value */
+                    auto binding = std::find_if(this->_bindings.rbegin(),
+                                                this->_bindings.rend(),
+                                                [&](const ASTBinding& b) { return b.name == name; });
+
+                    if(binding != this->_bindings.rend())
+                    {
+                        return std::make_shared<ASTNodeBindingRef>(name, binding->value);
+                    }
+
                     return std::make_shared<ASTNodeVariable>(name);
                 }
             }
@@ -206,16 +278,39 @@ public:
                     return nullptr;
                 }
 
+                const std::string_view minus = this->current().data;
+
                 this->advance();
 
-                std::shared_ptr<ASTNode> factor = this->parse_factor();
+                /* Negative literals are folded, their name spans the minus sign and the literal */
+                if(this->current().type == LexerTokenType::Literal &&
+                   !(this->peek().type == LexerTokenType::Operator &&
+                     op_binary_from_string(this->peek().data) == BinaryOpType_Pow))
+                {
+                    std::shared_ptr<ASTNode> factor = this->parse_factor();
+
+                    if(factor == nullptr)
+                    {
+                        return nullptr;
+                    }
+
+                    auto literal = node_cast<ASTNodeLiteral>(factor.get());
 
-                if(factor == nullptr)
+                    const std::string_view lit = literal->get_name();
+                    const std::string_view name(minus.data(), lit.data() + lit.size() - minus.data());
+
+                    return std::make_shared<ASTNodeLiteral>(-literal->get_value(), name);
+                }
+
+                /* Negates the whole power, -x ^ 2 is -(x ^ 2) */
+                std::shared_ptr<ASTNode> operand = this->parse_power();
+
+                if(operand == nullptr)
                 {
                     return nullptr;
                 }
 
-                return std::make_shared<ASTNodeUnaryOp>(factor, op_unary_from_string(this->current().data));
+                return std::make_shared<ASTNodeUnaryOp>(operand, op_unary_from_string(minus));
             }
             default:
             {
@@ -228,9 +323,58 @@ public:
         }
     }
 
+    std::shared_ptr<ASTNode> parse_power() noexcept
+    {
+        std::shared_ptr<ASTNode> base = this->parse_factor();
+
+        if(base == nullptr ||
+           this->current().type != LexerTokenType::Operator ||
+           op_binary_from_string(this->current().data) != BinaryOpType_Pow)
+        {
+            return base;
+        }
+
+        this->advance();
+
+        /* Right associative, x ^ y ^ z is x ^ (y ^ z) */
+        std::shared_ptr<ASTNode> exponent = this->parse_power();
+
+        if(exponent == nullptr)
+        {
+            return nullptr;
+        }
+
+        base->set_needs_reg(true);
+
+        auto literal = node_cast<ASTNodeLiteral>(exponent.get());
+
+        if(literal == nullptr || literal->get_value() > 0.0)
+        {
+            return std::make_shared<ASTNodeBinaryOp>(base, exponent, BinaryOpType_Pow);
+        }
+
+        std::shared_ptr<ASTNode> one = std::make_shared<ASTNodeLiteral>(1.0, "$1.0");
+
+        if(literal->get_value() == 0.0)
+        {
+            return one;
+        }
+
+        std::shared_ptr<ASTNode> positive_exponent = std::make_shared<ASTNodeLiteral>(-literal->get_value(),
+                                                                                      literal->get_name().substr(1));
+
+        one->set_needs_reg(true);
+
+        return std::make_shared<ASTNodeBinaryOp>(one,
+                                                 std::make_shared<ASTNodeBinaryOp>(base,
+                                                                                   positive_exponent,
+                                                                                   BinaryOpType_Pow),
+                                                 BinaryOpType_Div);
+    }
+
     std::shared_ptr<ASTNode> parse_term() noexcept
     {
-        std::shared_ptr<ASTNode> left = this->parse_factor();
+        std::shared_ptr<ASTNode> left = this->parse_power();
 
         while(this->current().type == LexerTokenType::Operator)
         {
@@ -244,7 +388,7 @@ public:
 
             this->advance();
 
-            std::shared_ptr<ASTNode> right = this->parse_factor();
+            std::shared_ptr<ASTNode> right = this->parse_power();
 
             if(right == nullptr)
             {
@@ -259,7 +403,7 @@ public:
         return left;
     }
 
-    std::shared_ptr<ASTNode> parse_expression() noexcept
+    std::shared_ptr<ASTNode> parse_sum() noexcept
     {
         std::shared_ptr<ASTNode> left = this->parse_term();
 
@@ -289,18 +433,148 @@ public:
 
         return left;
     }
+
+    std::shared_ptr<ASTNode> parse_comparison() noexcept
+    {
+        std::shared_ptr<ASTNode> left = this->parse_sum();
+
+        while(left != nullptr && this->current().type == LexerTokenType::Operator)
+        {
+            const uint32_t op = op_binary_from_string(this->current().data);
+
+            if(!op_binary_is_comparison(op))
+            {
+                break;
+            }
+
+            this->advance();
+
+            std::shared_ptr<ASTNode> right = this->parse_sum();
+
+            if(right == nullptr)
+            {
+                return nullptr;
+            }
+
+            left->set_needs_reg(true);
+
+            left = std::make_shared<ASTNodeBinaryOp>(left, right, op);
+        }
+
+        return left;
+    }
+
+    std::shared_ptr<ASTNode> parse_expression() noexcept
+    {
+        std::shared_ptr<ASTNode> condition = this->parse_comparison();
+
+        if(condition == nullptr || this->current().type != LexerTokenType::Question)
+        {
+            return condition;
+        }
+
+        this->advance();
+
+        std::shared_ptr<ASTNode> if_true = this->parse_expression();
+
+        if(if_true == nullptr)
+        {
+            return nullptr;
+        }
+
+        if(this->current().type != LexerTokenType::Colon)
+        {
+            std::format_to(std::back_inserter(this->_error),
+                           "Expected \":\" in ternary expression, found \"{}\"",
+                           lexer_token_type_to_string(this->current().type));
+
+            return nullptr;
+        }
+
+        this->advance();
+
+        std::shared_ptr<ASTNode> if_false = this->parse_expression();
+
+        if(if_false == nullptr)
+        {
+            return nullptr;
+        }
+
+        return this->make_select({ condition, if_true, if_false });
+    }
+
+    std::shared_ptr<ASTNode> parse_program() noexcept
+    {
+        while(this->current().type == LexerTokenType::Symbol && 
+              this->peek().type == LexerTokenType::Assign)
+        {
+            const std::string_view name = this->current().data;
+
+            this->advance();
+            this->advance();
+
+            std::shared_ptr<ASTNode> value = this->parse_expression();
+
+            if(value == nullptr)
+            {
+                return nullptr;
+            }
+
+            if(this->current().type != LexerTokenType::Semicolon)
+            {
+                std::format_to(std::back_inserter(this->_error),
+                               "Expected \";\" after the binding of \"{}\", found \"{}\"",
+                               name,
+                               lexer_token_type_to_string(this->current().type));
+
+                return nullptr;
+            }
+
+            this->advance();
+
+            this->_bindings.emplace_back(name, std::move(value));
+        }
+
+        std::shared_ptr<ASTNode> expr = this->parse_expression();
+
+        if(expr == nullptr)
+        {
+            return nullptr;
+        }
+
+        if(this->current().type == LexerTokenType::Semicolon)
+        {
+            this->advance();
+        }
+
+        if(!this->is_at_end())
+        {
+            std::format_to(std::back_inserter(this->_error),
+                           "Unexpected token \"{}\" found after the end of the expression",
+                           this->current().data);
+
+            return nullptr;
+        }
+
+        return expr;
+    }
 };
 
 bool AST::build_from_tokens(const LexerTokens& tokens) noexcept
 {
     this->clear();
 
-    Parser parser(tokens);
+    Parser parser(tokens, this->_bindings);
 
-    this->_root = parser.parse_expression();
+    this->_root = parser.parse_program();
 
     if(this->_root == nullptr)
     {
+        if(!parser.get_error().empty())
+        {
+            log_error("{}", parser.get_error());
+        }
+
         return false;
     }
 
@@ -0,0 +1,381 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/ssa.hpp"
+#include "mathexpr/op.hpp"
+#include "mathexpr/log.hpp"
+
+#include <functional>
+#include <unordered_map>
+
+MATHEXPR_NAMESPACE_BEGIN
+
+/*
+    Reverse-mode automatic differentiation. The expression is built as usual, then the adjoint of
+    each statement (the derivative of the result with respect to it) is accumulated by walking the
+    statements backwards and applying the chain rule. Adjoints go through the same common
+    subexpression elimination as the expression, so they reuse the values of the forward pass
+    (the derivative of exp(x) multiplies by the result of exp(x), cos(x) is computed once if the
+    expression already needs it ...)
+*/
+
+namespace {
+
+struct DerivativeLiteral
+{
+    std::string_view name;
+    double value;
+};
+
+static constexpr DerivativeLiteral ZERO = { "$0.0", 0.0 };
+static constexpr DerivativeLiteral ONE = { "$1.0", 1.0 };
+static constexpr DerivativeLiteral THREE = { "$3.0", 3.0 };
+static constexpr DerivativeLiteral LN2 = { "$0.6931471805599453", 0.6931471805599453 };
+static constexpr DerivativeLiteral LN10 = { "$2.302585092994046", 2.302585092994046 };
+
+class GradientBuilder
+{
+    std::function<uint32_t(const SSAStmt&)> _emit;
+
+    SSA& _ssa;
+
+    SymbolTable& _symtable;
+
+    /* Indexed by statement, INVALID_STMT_INDEX while nothing flows back to the statement */
+    std::vector<uint32_t> _adjoints;
+
+public:
+    GradientBuilder(std::function<uint32_t(const SSAStmt&)> emit,
+                    SSA& ssa,
+                    SymbolTable& symtable,
+                    size_t num_statements) : _emit(std::move(emit)),
+                                             _ssa(ssa),
+                                             _symtable(symtable),
+                                             _adjoints(num_statements, INVALID_STMT_INDEX) {}
+
+    uint32_t get_adjoint(uint32_t stmt) const noexcept { return this->_adjoints[stmt]; }
+
+    void set_adjoint(uint32_t stmt, uint32_t adjoint) noexcept { this->_adjoints[stmt] = adjoint; }
+
+    uint32_t literal(const DerivativeLiteral& literal) noexcept
+    {
+        this->_symtable.add_literal(literal.name, literal.value);
+
+        return this->_emit({ SSAStmtTypeId_Literal, this->_ssa.add_name(literal.name), 0, 0, 0 });
+    }
+
+    uint32_t binop(uint32_t op, uint32_t left, uint32_t right) noexcept
+    {
+        return this->_emit({ SSAStmtTypeId_BinOp, op, left, right, 0 });
+    }
+
+    uint32_t add(uint32_t left, uint32_t right) noexcept { return this->binop(BinaryOpType_Add, left, right); }
+
+    uint32_t sub(uint32_t left, uint32_t right) noexcept { return this->binop(BinaryOpType_Sub, left, right); }
+
+    uint32_t mul(uint32_t left, uint32_t right) noexcept { return this->binop(BinaryOpType_Mul, left, right); }
+
+    uint32_t div(uint32_t left, uint32_t right) noexcept { return this->binop(BinaryOpType_Div, left, right); }
+
+    uint32_t sqrt(uint32_t operand) noexcept
+    {
+        return this->_emit({ SSAStmtTypeId_UnOp, UnaryOpType_Sqrt, operand, 0, 0 });
+    }
+
+    uint32_t call(std::string_view name, std::initializer_list<uint32_t> arguments) noexcept
+    {
+        SSAStmt call = { SSAStmtTypeId_FuncOp, this->_ssa.add_name(name), INVALID_STMT_INDEX, INVALID_STMT_INDEX, INVALID_STMT_INDEX };
+
+        std::copy(arguments.begin(), arguments.end(), call.get_arguments());
+
+        return this->_emit(call);
+    }
+
+    /* adjoint(stmt) += term, or -= term when negate is true */
+    void accumulate(uint32_t stmt, uint32_t term, bool negate = false) noexcept
+    {
+        /* Nothing depends on literals */
+        if(this->_ssa.get_statements()[stmt].type == SSAStmtTypeId_Literal)
+        {
+            return;
+        }
+
+        const uint32_t adjoint = this->get_adjoint(stmt);
+
+        if(adjoint == INVALID_STMT_INDEX)
+        {
+            this->set_adjoint(stmt, negate ? this->sub(this->literal(ZERO), term) : term);
+        }
+        else
+        {
+            this->set_adjoint(stmt, this->binop(negate ? BinaryOpType_Sub : BinaryOpType_Add, adjoint, term));
+        }
+    }
+};
+
+/* Accumulates the adjoints of the arguments of a call, given its result and its own adjoint */
+using FunctionDerivative = void (*)(GradientBuilder& builder,
+                                    const uint32_t* args,
+                                    uint32_t result,
+                                    uint32_t adjoint);
+
+/* Derivatives of the functions of libmaths::g_function_table */
+static const std::unordered_map<std::string_view, FunctionDerivative> g_derivative_table = {
+    { "abs", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.call("copysign", { b.literal(ONE), args[0] })));
+    } },
+    { "sqrt", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.add(f, f)));
+    } },
+    { "cbrt", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.mul(b.literal(THREE), b.mul(f, f))));
+    } },
+    { "pow", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        /* d/dx = y * x ^ (y - 1), d/dy = x ^ y * log(x) */
+        const uint32_t power = b.call("pow", { args[0], b.sub(args[1], b.literal(ONE)) });
+        b.accumulate(args[0], b.mul(g, b.mul(args[1], power)));
+        b.accumulate(args[1], b.mul(g, b.mul(f, b.call("log", { args[0] }))));
+    } },
+    { "exp", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, f));
+    } },
+    { "expm1", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.add(f, b.literal(ONE))));
+    } },
+    { "log", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, args[0]));
+    } },
+    { "log10", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.mul(args[0], b.literal(LN10))));
+    } },
+    { "log2", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.mul(args[0], b.literal(LN2))));
+    } },
+    { "log1p", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.add(args[0], b.literal(ONE))));
+    } },
+    { "sin", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.call("cos", { args[0] })));
+    } },
+    { "cos", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.call("sin", { args[0] })), true);
+    } },
+    { "tan", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.add(b.literal(ONE), b.mul(f, f))));
+    } },
+    { "asin", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.sqrt(b.sub(b.literal(ONE), b.mul(args[0], args[0])))));
+    } },
+    { "acos", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.sqrt(b.sub(b.literal(ONE), b.mul(args[0], args[0])))), true);
+    } },
+    { "atan", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.add(b.literal(ONE), b.mul(args[0], args[0]))));
+    } },
+    { "atan2", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        /* atan2(y, x): d/dy = x / (x^2 + y^2), d/dx = -y / (x^2 + y^2) */
+        const uint32_t scale = b.div(g, b.add(b.mul(args[0], args[0]), b.mul(args[1], args[1])));
+        b.accumulate(args[0], b.mul(scale, args[1]));
+        b.accumulate(args[1], b.mul(scale, args[0]), true);
+    } },
+    { "sinh", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.call("cosh", { args[0] })));
+    } },
+    { "cosh", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.call("sinh", { args[0] })));
+    } },
+    { "tanh", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.mul(g, b.sub(b.literal(ONE), b.mul(f, f))));
+    } },
+    { "asinh", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.sqrt(b.add(b.mul(args[0], args[0]), b.literal(ONE)))));
+    } },
+    { "acosh", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.sqrt(b.sub(b.mul(args[0], args[0]), b.literal(ONE)))));
+    } },
+    { "atanh", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], b.div(g, b.sub(b.literal(ONE), b.mul(args[0], args[0]))));
+    } },
+    /* Piecewise constant */
+    { "floor", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {} },
+    { "ceil", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {} },
+    { "trunc", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {} },
+    /* fmod(x, y) and remainder(x, y) are x - n * y, with n = (x - f) / y constant between discontinuities */
+    { "fmod", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], g);
+        b.accumulate(args[1], b.mul(g, b.div(b.sub(args[0], f), args[1])), true);
+    } },
+    { "remainder", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], g);
+        b.accumulate(args[1], b.mul(g, b.div(b.sub(args[0], f), args[1])), true);
+    } },
+    { "copysign", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        /* |x| * sign(y), d/dx = sign(x) * sign(y) */
+        b.accumulate(args[0], b.mul(g, b.call("copysign", { b.call("copysign", { b.literal(ONE), args[0] }), args[1] })));
+    } },
+    { "hypot", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        const uint32_t scale = b.div(g, f);
+        b.accumulate(args[0], b.mul(scale, args[0]));
+        b.accumulate(args[1], b.mul(scale, args[1]));
+    } },
+    /* Follows libmaths, where both are the identity */
+    { "radians", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], g);
+    } },
+    { "degrees", [](GradientBuilder& b, const uint32_t* args, uint32_t f, uint32_t g) {
+        b.accumulate(args[0], g);
+    } },
+};
+
+} /* namespace */
+
+bool SSA::build_gradient_from_ast(const AST& ast, SymbolTable& symtable) noexcept
+{
+    this->clear();
+
+    SSAValueTable values;
+
+    const uint32_t result = this->build_expression(ast.get_root(), values);
+
+    if(result == INVALID_STMT_INDEX)
+    {
+        return false;
+    }
+
+    const size_t num_forward_statements = this->_statements.size();
+
+    GradientBuilder builder([&](const SSAStmt& stmt) -> uint32_t { return this->add_statement(stmt, values); },
+                            *this,
+                            symtable,
+                            num_forward_statements);
+
+    builder.set_adjoint(result, builder.literal(ONE));
+
+    for(uint32_t i = static_cast<uint32_t>(num_forward_statements); i-- > 0;)
+    {
+        /* Copied, accumulating adds statements */
+        const SSAStmt stmt = this->_statements[i];
+        const uint32_t adjoint = builder.get_adjoint(i);
+
+        if(adjoint == INVALID_STMT_INDEX)
+        {
+            continue;
+        }
+
+        switch(stmt.type)
+        {
+            case SSAStmtTypeId_UnOp:
+            {
+                switch(stmt.op)
+                {
+                    case UnaryOpType_Neg:
+                        builder.accumulate(stmt.a, adjoint, true);
+                        break;
+                    case UnaryOpType_Sqrt:
+                        builder.accumulate(stmt.a, builder.div(adjoint, builder.add(i, i)));
+                        break;
+                    default:
+                        /* Comparison results are piecewise constant */
+                        break;
+                }
+
+                break;
+            }
+            case SSAStmtTypeId_BinOp:
+            {
+                const uint32_t left = stmt.a;
+                const uint32_t right = stmt.b;
+
+                switch(stmt.op)
+                {
+                    case BinaryOpType_Add:
+                        builder.accumulate(left, adjoint);
+                        builder.accumulate(right, adjoint);
+                        break;
+                    case BinaryOpType_Sub:
+                        builder.accumulate(left, adjoint);
+                        builder.accumulate(right, adjoint, true);
+                        break;
+                    case BinaryOpType_Mul:
+                        builder.accumulate(left, builder.mul(adjoint, right));
+                        builder.accumulate(right, builder.mul(adjoint, left));
+                        break;
+                    case BinaryOpType_Div:
+                    {
+                        const uint32_t scaled = builder.div(adjoint, right);
+                        builder.accumulate(left, scaled);
+                        builder.accumulate(right, builder.mul(scaled, i), true);
+                        break;
+                    }
+                    /*
+                        select(c, a, b) is (mask & a) | (~mask & b): one side of the or is zero, the
+                        adjoint flows to both and each side lets it through where it selected its value
+                    */
+                    case BinaryOpType_Or:
+                        builder.accumulate(left, adjoint);
+                        builder.accumulate(right, adjoint);
+                        break;
+                    case BinaryOpType_And:
+                        builder.accumulate(right, builder.binop(BinaryOpType_And, left, adjoint));
+                        break;
+                    case BinaryOpType_AndNot:
+                        builder.accumulate(right, builder.binop(BinaryOpType_AndNot, left, adjoint));
+                        break;
+                    default:
+                        /* Comparison masks */
+                        break;
+                }
+
+                break;
+            }
+            case SSAStmtTypeId_FuncOp:
+            {
+                const auto it = g_derivative_table.find(this->get_name(stmt.op));
+
+                if(it == g_derivative_table.end())
+                {
+                    log_error("Cannot differentiate function \"{}\"", this->get_name(stmt.op));
+                    return false;
+                }
+
+                it->second(builder, stmt.get_arguments(), i, adjoint);
+
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::vector<uint32_t> variables(symtable.get_variables().size(), INVALID_STMT_INDEX);
+
+    for(uint32_t i = 0; i < num_forward_statements; i++)
+    {
+        if(this->_statements[i].type == SSAStmtTypeId_Variable)
+        {
+            variables[symtable.get_variables().at(this->get_name(this->_statements[i].op)).get_id()] = i;
+        }
+    }
+
+    std::vector<uint32_t> outputs = { result };
+
+    for(const uint32_t variable : variables)
+    {
+        const uint32_t adjoint = variable == INVALID_STMT_INDEX ? INVALID_STMT_INDEX : builder.get_adjoint(variable);
+
+        /* The variable only reaches the result through comparisons */
+        outputs.push_back(adjoint == INVALID_STMT_INDEX ? builder.literal(ZERO) : adjoint);
+    }
+
+    for(size_t i = 0; i < outputs.size(); i++)
+    {
+        this->_statements.push_back({ SSAStmtTypeId_StoreOp, 0, outputs[i], static_cast<uint32_t>(i), 0 });
+    }
+
+    this->calculate_live_ranges();
+
+    return true;
+}
+
+MATHEXPR_NAMESPACE_END
@@ -6,12 +6,18 @@
 #include "mathexpr/op.hpp"
 #include "mathexpr/log.hpp"
 
+#include <cstring>
+#include <algorithm>
+
 MATHEXPR_NAMESPACE_BEGIN
 
 /* Code Generation */
 
-CodeGenerator::CodeGenerator(uint32_t isa, PlatformABIPtr platform_abi) : _isa(isa),
-                                                                          _platform_abi(platform_abi)
+CodeGenerator::CodeGenerator(uint32_t isa,
+                             PlatformABIPtr platform_abi,
+                             uint32_t value_type) : _isa(isa),
+                                                    _platform_abi(platform_abi),
+                                                    _value_type(value_type)
 {
     this->_target_generator = CodeGenerator::create_target_generator(isa, platform_abi);
 
@@ -19,119 +25,158 @@ CodeGenerator::CodeGenerator(uint32_t isa, PlatformABIPtr platform_abi) : _isa(i
     {
         log_error("Cannot create code generator, unsupported isa: {}",
                   isa_as_string(this->_isa));
+        return;
     }
+
+    this->_target_generator->set_value_type(value_type);
 }
 
-bool CodeGenerator::build(const SSA& ssa,
-                          const RegisterAllocator& regalloc,
-                          SymbolTable& symtable) noexcept
+void CodeGenerator::load_constants(const SymbolTable& symtable) noexcept
 {
-    if(this->_target_generator == nullptr)
-    {
-        log_error("Cannot build code generator, unsupported isa: {}",
-                  isa_as_string(this->_isa));
+    /* Literals are looked up by offset in the constant pool, not by name */
+    this->_constants.assign(symtable.get_num_literals(), 0.0);
 
-        return false;
-    }
+    for(const auto& [_, literal] : symtable.get_literals())
+        this->_constants[literal.get_id()] = literal.get_value();
+}
 
-    this->_instructions.clear();
+bool CodeGenerator::build_statements(const SSA& ssa,
+                                     const RegisterAllocator& regalloc,
+                                     SymbolTable& symtable,
+                                     std::vector<InstrPtr>& instructions,
+                                     uint64_t& stack_size,
+                                     bool& frame_pointer) noexcept
+{
+    const std::vector<SSAStmt>& statements = ssa.get_statements();
 
-    uint64_t epilogue_stack_size = 0;
-    uint64_t shadow_space_stack = 0;
+    const bool has_outputs = std::ranges::any_of(statements, [](const SSAStmt& stmt) {
+        return stmt.type == SSAStmtTypeId_StoreOp;
+    });
 
-    for(auto stmt : ssa.get_statements())
-    {
-        if(stmt->type_id() == SSAStmtTypeId_FuncOp)
-        {
-            shadow_space_stack += this->_platform_abi->get_fcall_shadow_space();
-            break;
-        }
-    }
+    stack_size = std::max(stack_size, ssa.get_stack_size());
+    frame_pointer = ssa.has_frame_pointer();
 
-    for(auto stmt : ssa.get_statements())
+    for(uint32_t i = 0; i < statements.size(); i++)
     {
-        switch(stmt->type_id())
+        const SSAStmt& stmt = statements[i];
+
+        switch(stmt.type)
         {
             case SSAStmtTypeId_Variable:
             {
-                auto variable = statement_cast<SSAStmtVariable>(stmt.get());
-
-                MemLocPtr loc = regalloc.get_memloc(stmt);
+                MemLocPtr loc = regalloc.get_memloc(i);
 
                 if(loc->type_id() == MemLocTypeId_Register)
                 {
                     MemLocPtr mem = std::make_shared<Memory>(this->_platform_abi->get_variable_base_ptr(),
-                                                             symtable.get_variable_offset(variable->get_name()));
+                                                             symtable.get_variable_offset(ssa.get_name(stmt.op)));
 
-                    this->_instructions.push_back(this->_target_generator->create_mov(mem, loc));
+                    instructions.push_back(this->_target_generator->create_mov(mem, loc));
                 }
 
                 break;
             }
             case SSAStmtTypeId_Literal:
             {
-                auto literal = statement_cast<SSAStmtLiteral>(stmt.get());
-
-                MemLocPtr loc = regalloc.get_memloc(stmt);
+                MemLocPtr loc = regalloc.get_memloc(i);
 
                 if(loc->type_id() == MemLocTypeId_Register)
                 {
-                    MemLocPtr mem = std::make_shared<Memory>(this->_platform_abi->get_literal_base_ptr(),
-                                                             symtable.get_literal_offset(literal->get_name()));
+                    MemLocPtr mem = std::make_shared<Constant>(symtable.get_literal_offset(ssa.get_name(stmt.op)));
 
-                    this->_instructions.push_back(this->_target_generator->create_mov(mem, loc));
+                    instructions.push_back(this->_target_generator->create_mov(mem, loc));
                 }
 
                 break;
             }
             case SSAStmtTypeId_UnOp:
             {
+                MemLocPtr operand = regalloc.get_memloc(stmt.a);
+
+                switch(stmt.op)
+                {
+                    case UnaryOpType_MaskToBool:
+                    {
+                        instructions.push_back(this->_target_generator->create_mask_to_bool(operand));
+                        break;
+                    }
+                    case UnaryOpType_Sqrt:
+                    {
+                        instructions.push_back(this->_target_generator->create_sqrt(operand));
+                        break;
+                    }
+                    case UnaryOpType_Neg:
+                    {
+                        instructions.push_back(this->_target_generator->create_neg(operand));
+                        break;
+                    }
+                }
+
                 break;
             }
             case SSAStmtTypeId_BinOp:
             {
-                auto binop = statement_cast<SSAStmtBinOp>(stmt.get());
-
-                MemLocPtr left = regalloc.get_memloc(binop->get_left());
+                MemLocPtr left = regalloc.get_memloc(stmt.a);
 
                 if(left == nullptr)
                 {
-                    log_error("Error during codegen. Cannot find location of symbol: {}",
-                              binop->get_left()->get_version());
+                    log_error("Error during codegen. Cannot find location of symbol: {}", stmt.a);
 
                     return false;
                 }
 
-                MemLocPtr right = regalloc.get_memloc(binop->get_right());
+                MemLocPtr right = regalloc.get_memloc(stmt.b);
 
                 if(right == nullptr)
                 {
-                    log_error("Error during codegen. Cannot find location of symbol: {}",
-                              binop->get_right()->get_version());
+                    log_error("Error during codegen. Cannot find location of symbol: {}", stmt.b);
 
                     return false;
                 }
 
-                switch(binop->get_op())
+                switch(stmt.op)
                 {
                     case BinaryOpType_Add:
                     {
-                        this->_instructions.push_back(this->_target_generator->create_add(left, right));
+                        instructions.push_back(this->_target_generator->create_add(left, right));
                         break;
                     }
                     case BinaryOpType_Sub:
                     {
-                        this->_instructions.push_back(this->_target_generator->create_sub(left, right));
+                        instructions.push_back(this->_target_generator->create_sub(left, right));
                         break;
                     }
                     case BinaryOpType_Mul:
                     {
-                        this->_instructions.push_back(this->_target_generator->create_mul(left, right));
+                        instructions.push_back(this->_target_generator->create_mul(left, right));
                         break;
                     }
                     case BinaryOpType_Div:
                     {
-                        this->_instructions.push_back(this->_target_generator->create_div(left, right));
+                        instructions.push_back(this->_target_generator->create_div(left, right));
+                        break;
+                    }
+                    case BinaryOpType_Eq:
+                    case BinaryOpType_Neq:
+                    case BinaryOpType_Lt:
+                    case BinaryOpType_Le:
+                    {
+                        instructions.push_back(this->_target_generator->create_cmp(left, right, stmt.op));
+                        break;
+                    }
+                    case BinaryOpType_And:
+                    {
+                        instructions.push_back(this->_target_generator->create_and(left, right));
+                        break;
+                    }
+                    case BinaryOpType_AndNot:
+                    {
+                        instructions.push_back(this->_target_generator->create_andnot(left, right));
+                        break;
+                    }
+                    case BinaryOpType_Or:
+                    {
+                        instructions.push_back(this->_target_generator->create_or(left, right));
                         break;
                     }
                 }
@@ -140,66 +185,39 @@ bool CodeGenerator::build(const SSA& ssa,
             }
             case SSAStmtTypeId_FuncOp:
             {
-                auto funcop = statement_cast<SSAStmtFunctionOp>(stmt.get());
-
-                if(funcop == nullptr)
-                {
-                    log_error("Internal error during codegen: expected func op, got: {}", stmt->type_id());
-                    return false;
-                }
-
-                this->_instructions.push_back(this->_target_generator->create_call(funcop->get_name()));
+                instructions.push_back(this->_target_generator->create_call(ssa.get_name(stmt.op), has_outputs));
 
                 break;
             }
-            case SSAStmtTypeId_AllocateStackOp:
+            case SSAStmtTypeId_SpillOp:
             {
-                auto allocstackop = statement_cast<SSAStmtAllocateStackOp>(stmt.get());
-
-                if(allocstackop == nullptr)
-                {
-                    log_error("Internal error during codegen: expected alloc stack op, got: {}",
-                              stmt->type_id());
-                }
-
-                epilogue_stack_size += allocstackop->get_stack_size();
+                MemLocPtr reg = regalloc.get_memloc(stmt.a);
+                MemLocPtr mem = regalloc.get_memloc(i);
 
-                this->_instructions.insert(this->_instructions.begin(),
-                                           this->_target_generator->create_prologue(allocstackop->get_stack_size() + shadow_space_stack));
+                instructions.push_back(this->_target_generator->create_mov(reg, mem));
 
                 break;
             }
-            case SSAStmtTypeId_SpillOp:
+            case SSAStmtTypeId_StoreOp:
             {
-                auto spillop = statement_cast<SSAStmtSpillOp>(stmt.get());
+                MemLocPtr reg = regalloc.get_memloc(stmt.a);
+                MemLocPtr mem = regalloc.get_memloc(i);
 
-                if(spillop == nullptr)
+                if(stmt.is_accumulate())
                 {
-                    log_error("Internal error during codegen: expected spill op, got: {}", stmt->type_id());
-                    return false;
+                    instructions.push_back(this->_target_generator->create_add(reg, mem));
                 }
 
-                MemLocPtr reg = regalloc.get_memloc(spillop->get_operand());
-                MemLocPtr mem = regalloc.get_memloc(stmt);
-
-                this->_instructions.push_back(this->_target_generator->create_mov(reg, mem));
+                instructions.push_back(this->_target_generator->create_mov(reg, mem));
 
                 break;
             }
             case SSAStmtTypeId_LoadOp:
             {
-                auto loadop = statement_cast<SSAStmtLoadOp>(stmt.get());
-
-                if(loadop == nullptr)
-                {
-                    log_error("Internal error during codegen: expected load op, got: {}", stmt->type_id());
-                    return false;
-                }
+                MemLocPtr reg = regalloc.get_memloc(i);
+                MemLocPtr mem = regalloc.get_memloc(stmt.a);
 
-                MemLocPtr reg = regalloc.get_memloc(stmt);
-                MemLocPtr mem = regalloc.get_memloc(loadop->get_spill());
-
-                this->_instructions.push_back(this->_target_generator->create_mov(mem, reg));
+                instructions.push_back(this->_target_generator->create_mov(mem, reg));
 
                 break;
             }
@@ -209,28 +227,219 @@ bool CodeGenerator::build(const SSA& ssa,
         }
     }
 
-    if(epilogue_stack_size > 0)
+    return true;
+}
+
+bool CodeGenerator::build(const SSA& ssa,
+                          const RegisterAllocator& regalloc,
+                          SymbolTable& symtable) noexcept
+{
+    if(this->_target_generator == nullptr)
     {
-        this->_instructions.push_back(this->_target_generator->create_epilogue(epilogue_stack_size));
+        log_error("Cannot build code generator, unsupported isa: {}",
+                  isa_as_string(this->_isa));
+
+        return false;
+    }
+
+    this->_instructions.clear();
+    this->load_constants(symtable);
+
+    uint64_t stack_size = 0;
+    bool frame_pointer = false;
+
+    std::vector<InstrPtr> instructions;
+
+    if(!this->build_statements(ssa, regalloc, symtable, instructions, stack_size, frame_pointer))
+    {
+        return false;
+    }
+
+    if(stack_size > 0)
+    {
+        this->_instructions.push_back(this->_target_generator->create_prologue(stack_size, frame_pointer));
+    }
+
+    this->_instructions.insert(this->_instructions.end(), instructions.begin(), instructions.end());
+
+    if(stack_size > 0)
+    {
+        this->_instructions.push_back(this->_target_generator->create_epilogue(stack_size, frame_pointer));
     }
 
     this->_instructions.push_back(this->_target_generator->create_ret());
 
+    this->_peephole_stats = this->_target_generator->optimize_instr_sequence(this->_instructions);
+
+    log_debug("Peephole optimizer removed {} instructions ({} bytes)",
+              this->_peephole_stats.removed_instructions,
+              this->_peephole_stats.removed_bytes);
+
     return true;
 }
 
-std::tuple<bool, ByteCode> CodeGenerator::as_bytecode(Relocations& relocs) const noexcept
+bool CodeGenerator::build_reduction(const SSA& body,
+                                    const RegisterAllocator& body_regalloc,
+                                    const SSA& tail,
+                                    const RegisterAllocator& tail_regalloc,
+                                    SymbolTable& symtable,
+                                    uint64_t unroll,
+                                    bool mean) noexcept
+{
+    if(this->_target_generator == nullptr)
+    {
+        log_error("Cannot build code generator, unsupported isa: {}",
+                  isa_as_string(this->_isa));
+
+        return false;
+    }
+
+    this->_instructions.clear();
+    this->load_constants(symtable);
+
+    uint64_t stack_size = 0;
+    bool frame_pointer = false;
+
+    std::vector<InstrPtr> body_instructions;
+    std::vector<InstrPtr> tail_instructions;
+
+    if(!this->build_statements(body, body_regalloc, symtable, body_instructions, stack_size, frame_pointer) ||
+       !this->build_statements(tail, tail_regalloc, symtable, tail_instructions, stack_size, frame_pointer))
+    {
+        return false;
+    }
+
+    const uint64_t num_columns = symtable.get_variables().size();
+
+    /*
+        reduction begin, prologue
+        loop (unroll rows): body
+        loop (1 row): tail
+        epilogue, reduction end, ret
+    */
+    this->_instructions.push_back(this->_target_generator->create_reduction_begin(num_columns, unroll));
+
+    if(stack_size > 0)
+    {
+        this->_instructions.push_back(this->_target_generator->create_prologue(stack_size, frame_pointer));
+    }
+
+    auto add_loop = [&](uint64_t step, const std::vector<InstrPtr>& instructions) {
+        InstrPtr loop_begin = this->_target_generator->create_loop_begin(num_columns, step);
+
+        this->_instructions.push_back(loop_begin);
+        this->_instructions.insert(this->_instructions.end(), instructions.begin(), instructions.end());
+        this->_instructions.push_back(this->_target_generator->create_loop_end(loop_begin));
+    };
+
+    add_loop(unroll, body_instructions);
+    add_loop(1, tail_instructions);
+
+    if(stack_size > 0)
+    {
+        this->_instructions.push_back(this->_target_generator->create_epilogue(stack_size, frame_pointer));
+    }
+
+    this->_instructions.push_back(this->_target_generator->create_reduction_end(num_columns, unroll, mean));
+    this->_instructions.push_back(this->_target_generator->create_ret());
+
+    this->_peephole_stats = this->_target_generator->optimize_instr_sequence(this->_instructions);
+
+    log_debug("Peephole optimizer removed {} instructions ({} bytes)",
+              this->_peephole_stats.removed_instructions,
+              this->_peephole_stats.removed_bytes);
+
+    return true;
+}
+
+std::tuple<bool, ByteCode> CodeGenerator::as_bytecode(Relocations& relocs,
+                                                      std::size_t constant_pool_alignment) const noexcept
 {
     ByteCode code;
 
+    Relocations constant_relocs;
+    Relocations sign_mask_relocs;
+
     for(const auto& instruction : this->_instructions)
     {
         std::size_t bytecode_start = code.size();
 
         instruction->as_bytecode(code);
 
-        if(instruction->needs_linking())
-            relocs.emplace_back(std::move(instruction->get_link_info(bytecode_start)));
+        if(!instruction->needs_linking())
+            continue;
+
+        RelocInfo info = instruction->get_link_info(bytecode_start, code.size());
+
+        if(info.reloc_type == RelocType_Constant32)
+            constant_relocs.push_back(info);
+        else if(info.reloc_type == RelocType_SignMask32)
+            sign_mask_relocs.push_back(info);
+        else
+            relocs.push_back(info);
+    }
+
+    /*
+        Sign mask of the negations, a full vector of sign bits as the packed xor reads 16 aligned
+        bytes. It is placed before the constant pool, which stays at the end of the code
+    */
+    if(!sign_mask_relocs.empty())
+    {
+        while(code.size() % 16 != 0)
+            code.push_back(BYTE(0));
+
+        const std::size_t sign_mask_start = code.size();
+
+        code.resize(sign_mask_start + 16, BYTE(0));
+
+        const std::size_t element_size = this->_value_type == ValueType_Float32 ? sizeof(float) : sizeof(double);
+
+        for(std::size_t i = element_size - 1; i < 16; i += element_size)
+            code[sign_mask_start + i] = BYTE(0x80);
+
+        for(const auto& reloc : sign_mask_relocs)
+        {
+            const int64_t displacement = static_cast<int64_t>(sign_mask_start) -
+                                         static_cast<int64_t>(reloc.instruction_end);
+
+            for(std::size_t i = 0; i < 4; i++)
+                code[reloc.bytecode_offset + i] = BYTE((displacement >> (i * 8)) & 0xFF);
+        }
+    }
+
+    if(this->_constants.empty())
+        return std::make_tuple(true, code);
+
+    /* Constant pool, after the code */
+    while(code.size() % constant_pool_alignment != 0)
+        code.push_back(BYTE(0));
+
+    const std::size_t pool_start = code.size();
+
+    if(this->_value_type == ValueType_Float32)
+    {
+        code.resize(pool_start + this->_constants.size() * sizeof(float));
+
+        for(std::size_t i = 0; i < this->_constants.size(); i++)
+        {
+            const float value = static_cast<float>(this->_constants[i]);
+            std::memcpy(code.data() + pool_start + i * sizeof(float), &value, sizeof(float));
+        }
+    }
+    else
+    {
+        code.resize(pool_start + this->_constants.size() * sizeof(double));
+        std::memcpy(code.data() + pool_start, this->_constants.data(), this->_constants.size() * sizeof(double));
+    }
+
+    /* Displacements are relative to the end of the instruction, which can have an immediate after them */
+    for(const auto& reloc : constant_relocs)
+    {
+        const int64_t displacement = static_cast<int64_t>(pool_start + reloc.constant_offset) -
+                                     static_cast<int64_t>(reloc.instruction_end);
+
+        for(std::size_t i = 0; i < 4; i++)
+            code[reloc.bytecode_offset + i] = BYTE((displacement >> (i * 8)) & 0xFF);
     }
 
     return std::make_tuple(true, code);
@@ -0,0 +1,406 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/column_file.hpp"
+#include "mathexpr/log.hpp"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+
+#if defined(MATHEXPR_WIN)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* defined(MATHEXPR_WIN) */
+
+MATHEXPR_NAMESPACE_BEGIN
+
+/* Mapped files */
+
+void MappedFile::close() noexcept
+{
+#if defined(MATHEXPR_WIN)
+    if(this->_data != nullptr)
+        UnmapViewOfFile(this->_data);
+
+    if(this->_mapping != nullptr)
+        CloseHandle(this->_mapping);
+
+    if(this->_file != nullptr)
+        CloseHandle(this->_file);
+
+    this->_mapping = nullptr;
+    this->_file = nullptr;
+#else
+    if(this->_data != nullptr)
+        munmap(const_cast<std::byte*>(this->_data), this->_size);
+
+    if(this->_fd != -1)
+        ::close(this->_fd);
+
+    this->_fd = -1;
+#endif /* defined(MATHEXPR_WIN) */
+
+    this->_data = nullptr;
+    this->_size = 0;
+}
+
+bool MappedFile::open(const char* path) noexcept
+{
+    this->close();
+
+#if defined(MATHEXPR_WIN)
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        log_error("Cannot open file \"{}\"", path);
+        return false;
+    }
+
+    this->_file = file;
+
+    LARGE_INTEGER size;
+
+    if(!GetFileSizeEx(file, &size))
+    {
+        log_error("Cannot get the size of file \"{}\"", path);
+        return false;
+    }
+
+    /* Empty files cannot be mapped, they are valid but have no data */
+    if(size.QuadPart == 0)
+        return true;
+
+    this->_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if(this->_mapping == nullptr)
+    {
+        log_error("Cannot map file \"{}\"", path);
+        return false;
+    }
+
+    this->_data = static_cast<const std::byte*>(MapViewOfFile(this->_mapping, FILE_MAP_READ, 0, 0, 0));
+    this->_size = static_cast<size_t>(size.QuadPart);
+#else
+    this->_fd = ::open(path, O_RDONLY);
+
+    if(this->_fd == -1)
+    {
+        log_error("Cannot open file \"{}\"", path);
+        return false;
+    }
+
+    struct stat st;
+
+    if(fstat(this->_fd, &st) != 0)
+    {
+        log_error("Cannot get the size of file \"{}\"", path);
+        return false;
+    }
+
+    /* Empty files cannot be mapped, they are valid but have no data */
+    if(st.st_size == 0)
+        return true;
+
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, this->_fd, 0);
+
+    if(data != MAP_FAILED)
+    {
+        madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        this->_data = static_cast<const std::byte*>(data);
+        this->_size = static_cast<size_t>(st.st_size);
+    }
+#endif /* defined(MATHEXPR_WIN) */
+
+    if(this->_data == nullptr)
+    {
+        log_error("Cannot map file \"{}\"", path);
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::advise_huge_pages(size_t begin, size_t end) noexcept
+{
+#if defined(MADV_HUGEPAGE)
+    const size_t page_size = ExecMem::get_page_size();
+
+    begin = begin & ~(page_size - 1);
+
+    /* Not all filesystems support huge pages for mapped files, the hint is simply ignored then */
+    if(begin < end && end <= this->_size)
+        madvise(const_cast<std::byte*>(this->_data) + begin, end - begin, MADV_HUGEPAGE);
+#endif /* defined(MADV_HUGEPAGE) */
+}
+
+void MappedFile::release(size_t begin, size_t end) noexcept
+{
+#if !defined(MATHEXPR_WIN)
+    const size_t page_size = ExecMem::get_page_size();
+
+    begin = (begin + page_size - 1) & ~(page_size - 1);
+    end = std::min(end, this->_size) & ~(page_size - 1);
+
+    if(begin < end)
+        madvise(const_cast<std::byte*>(this->_data) + begin, end - begin, MADV_DONTNEED);
+#endif /* !defined(MATHEXPR_WIN) */
+}
+
+/* Column files */
+
+template<typename T>
+static T read_value(const std::byte* data) noexcept
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+
+    return value;
+}
+
+bool ColumnFile::has_magic(const std::byte* data, size_t size) noexcept
+{
+    return size >= sizeof(COLUMN_FILE_MAGIC) &&
+           std::memcmp(data, COLUMN_FILE_MAGIC, sizeof(COLUMN_FILE_MAGIC)) == 0;
+}
+
+bool ColumnFile::open(const char* path) noexcept
+{
+    this->_num_rows = 0;
+    this->_names.clear();
+    this->_columns.clear();
+
+    if constexpr(std::endian::native != std::endian::little)
+    {
+        log_error("Column files can only be read on little endian platforms");
+        return false;
+    }
+
+    if(!this->_file.open(path))
+        return false;
+
+    const std::byte* data = this->_file.data();
+    const size_t size = this->_file.size();
+
+    if(size < COLUMN_FILE_HEADER_SIZE || !ColumnFile::has_magic(data, size))
+    {
+        log_error("File \"{}\" is not a column file", path);
+        return false;
+    }
+
+    const uint32_t version = read_value<uint32_t>(data + 8);
+
+    if(version != COLUMN_FILE_VERSION)
+    {
+        log_error("Column file \"{}\" has version {}, only version {} is supported",
+                  path,
+                  version,
+                  COLUMN_FILE_VERSION);
+
+        return false;
+    }
+
+    const uint32_t num_columns = read_value<uint32_t>(data + 12);
+    const uint64_t num_rows = read_value<uint64_t>(data + 16);
+
+    if(num_columns > (size - COLUMN_FILE_HEADER_SIZE) / COLUMN_FILE_ENTRY_SIZE)
+    {
+        log_error("Column file \"{}\" is truncated", path);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < num_columns; i++)
+    {
+        const std::byte* entry = data + COLUMN_FILE_HEADER_SIZE + i * COLUMN_FILE_ENTRY_SIZE;
+
+        const uint64_t values_offset = read_value<uint64_t>(entry);
+        const uint32_t name_offset = read_value<uint32_t>(entry + 8);
+        const uint32_t name_size = read_value<uint32_t>(entry + 12);
+
+        if(name_offset > size || name_size > size - name_offset)
+        {
+            log_error("Name of column {} of file \"{}\" is out of the file", i, path);
+            return false;
+        }
+
+        const std::string_view name(reinterpret_cast<const char*>(data + name_offset), name_size);
+
+        if((values_offset % alignof(double)) != 0 ||
+           values_offset > size ||
+           num_rows > (size - values_offset) / sizeof(double))
+        {
+            log_error("Values of column \"{}\" of file \"{}\" are misaligned or out of the file", name, path);
+            return false;
+        }
+
+        if(this->get_column(name) != nullptr)
+        {
+            log_error("Column \"{}\" appears several times in file \"{}\"", name, path);
+            return false;
+        }
+
+        const size_t values_size = num_rows * sizeof(double);
+
+        if((values_offset % COLUMN_FILE_HUGE_PAGE_ALIGNMENT) == 0 && values_size >= COLUMN_FILE_HUGE_PAGE_ALIGNMENT)
+            this->_file.advise_huge_pages(values_offset, values_offset + values_size);
+
+        this->_names.push_back(name);
+        this->_columns.push_back(reinterpret_cast<const double*>(data + values_offset));
+    }
+
+    this->_num_rows = num_rows;
+
+    log_debug("Opened column file \"{}\": {} columns of {} rows", path, num_columns, num_rows);
+
+    return true;
+}
+
+const double* ColumnFile::get_column(std::string_view name) const noexcept
+{
+    for(size_t i = 0; i < this->_names.size(); i++)
+    {
+        if(this->_names[i] == name)
+            return this->_columns[i];
+    }
+
+    return nullptr;
+}
+
+bool ColumnFile::bind(const VariableLayout& variables, std::vector<const double*>& columns) const noexcept
+{
+    columns.resize(variables.size());
+
+    for(size_t slot = 0; slot < variables.size(); slot++)
+    {
+        columns[slot] = this->get_column(variables.get_name(slot));
+
+        if(columns[slot] == nullptr)
+        {
+            log_error("Variable \"{}\" has no matching column in the column file", variables.get_name(slot));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ColumnFile::release_rows(uint64_t begin, uint64_t end) noexcept
+{
+    end = std::min(end, this->_num_rows);
+
+    for(const double* column : this->_columns)
+    {
+        const size_t offset = static_cast<size_t>(reinterpret_cast<const std::byte*>(column) - this->_file.data());
+
+        this->_file.release(offset + begin * sizeof(double), offset + end * sizeof(double));
+    }
+}
+
+bool write_column_file(const char* path,
+                       std::span<const std::string_view> names,
+                       std::span<const double* const> columns,
+                       uint64_t num_rows) noexcept
+{
+    if constexpr(std::endian::native != std::endian::little)
+    {
+        log_error("Column files can only be written on little endian platforms");
+        return false;
+    }
+
+    if(names.size() != columns.size())
+    {
+        log_error("You passed {} names but {} columns", names.size(), columns.size());
+        return false;
+    }
+
+    /* Header, entries and names, the values follow at aligned offsets */
+    std::vector<std::byte> header(COLUMN_FILE_HEADER_SIZE + columns.size() * COLUMN_FILE_ENTRY_SIZE);
+
+    auto write_value = [&header](size_t offset, auto value) {
+        std::memcpy(header.data() + offset, &value, sizeof(value));
+    };
+
+    std::memcpy(header.data(), COLUMN_FILE_MAGIC, sizeof(COLUMN_FILE_MAGIC));
+    write_value(8, COLUMN_FILE_VERSION);
+    write_value(12, static_cast<uint32_t>(columns.size()));
+    write_value(16, num_rows);
+    write_value(24, static_cast<uint64_t>(0));
+
+    for(size_t i = 0; i < names.size(); i++)
+    {
+        write_value(COLUMN_FILE_HEADER_SIZE + i * COLUMN_FILE_ENTRY_SIZE + 8, static_cast<uint32_t>(header.size()));
+        write_value(COLUMN_FILE_HEADER_SIZE + i * COLUMN_FILE_ENTRY_SIZE + 12, static_cast<uint32_t>(names[i].size()));
+
+        const std::byte* name = reinterpret_cast<const std::byte*>(names[i].data());
+        header.insert(header.end(), name, name + names[i].size());
+    }
+
+    const size_t values_size = num_rows * sizeof(double);
+    const size_t alignment = values_size >= COLUMN_FILE_HUGE_PAGE_ALIGNMENT ? COLUMN_FILE_HUGE_PAGE_ALIGNMENT
+                                                                            : COLUMN_FILE_ALIGNMENT;
+
+    std::vector<uint64_t> offsets(columns.size());
+
+    size_t offset = header.size();
+
+    for(size_t i = 0; i < columns.size(); i++)
+    {
+        offset = (offset + alignment - 1) & ~(alignment - 1);
+        offsets[i] = offset;
+
+        write_value(COLUMN_FILE_HEADER_SIZE + i * COLUMN_FILE_ENTRY_SIZE, offsets[i]);
+
+        offset += values_size;
+    }
+
+    FILE* file = std::fopen(path, "wb");
+
+    if(file == nullptr)
+    {
+        log_error("Cannot open file \"{}\" for writing", path);
+        return false;
+    }
+
+    bool success = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+
+    offset = header.size();
+
+    static constexpr std::byte padding[COLUMN_FILE_ALIGNMENT] = {};
+
+    for(size_t i = 0; success && i < columns.size(); i++)
+    {
+        while(success && offset < offsets[i])
+        {
+            const size_t padding_size = std::min(offsets[i] - offset, sizeof(padding));
+
+            success = std::fwrite(padding, 1, padding_size, file) == padding_size;
+            offset += padding_size;
+        }
+
+        success = success && std::fwrite(columns[i], 1, values_size, file) == values_size;
+        offset += values_size;
+    }
+
+    if(std::fclose(file) != 0 || !success)
+    {
+        log_error("Error while writing column file \"{}\"", path);
+        return false;
+    }
+
+    return true;
+}
+
+MATHEXPR_NAMESPACE_END
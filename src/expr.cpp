@@ -6,15 +6,101 @@
 #include "mathexpr/log.hpp"
 #include "mathexpr/codegen.hpp"
 #include "mathexpr/regalloc.hpp"
+#include "mathexpr/interpreter.hpp"
 
+#include <cstring>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <ranges>
+#include <thread>
 
 MATHEXPR_NAMESPACE_BEGIN
 
+/* Tiered and interpreted execution */
+
+struct TieredCode
+{
+    std::string expr;
+
+    /* No platform ABI when the expression is only interpreted, it never gets promoted */
+    uint32_t isa;
+    PlatformABIPtr platform_abi;
+
+    Interpreter interpreter;
+
+    ExecMem exec_mem;
+
+    /* Published once exec_mem holds the code, read without locking by the evaluating threads */
+    std::atomic<ExecMem::FunctionType> function = nullptr;
+
+    std::atomic<uint64_t> num_calls = 0;
+
+    std::once_flag compiled;
+    std::atomic<bool> promotion_started = false;
+    std::thread promotion_thread;
+
+    ~TieredCode()
+    {
+        if(this->promotion_thread.joinable())
+            this->promotion_thread.join();
+    }
+
+    /* Generates the machine code, runs once whichever thread gets there first */
+    void compile() noexcept;
+
+    ExecMem::FunctionType get_function() noexcept
+    {
+        if(this->platform_abi == nullptr)
+            return nullptr;
+
+        std::call_once(this->compiled, [this]() { this->compile(); });
+
+        return this->function.load(std::memory_order_acquire);
+    }
+
+    double evaluate(const double* values) noexcept
+    {
+        ExecMem::FunctionType func = this->function.load(std::memory_order_acquire);
+
+        if(func != nullptr)
+            return func(values);
+
+        if(this->platform_abi != nullptr &&
+           this->num_calls.fetch_add(1, std::memory_order_relaxed) + 1 >= EXPR_TIERED_JIT_THRESHOLD &&
+           !this->promotion_started.exchange(true))
+        {
+            this->promotion_thread = std::thread([this]() { this->get_function(); });
+        }
+
+        return this->interpreter.evaluate(values);
+    }
+};
+
+bool Expr::is_jit_compiled() const noexcept
+{
+    if(this->_tiered != nullptr)
+        return this->_tiered->function.load(std::memory_order_acquire) != nullptr;
+
+    return this->_exec_mem.is_locked();
+}
+
+ExecMem::FunctionType Expr::_get_function() const noexcept
+{
+    if(this->_tiered != nullptr)
+        return this->_tiered->get_function();
+
+    return this->_exec_mem.is_locked() ? this->_exec_mem.as_function() : nullptr;
+}
+
 std::tuple<bool, double> Expr::_evaluate_internal(const double* values) const noexcept
 {
-    MATHEXPR_ASSERT(values != nullptr, "values is NULL");
+    /* Expressions without variables are evaluated without values (empty spans have no data) */
+    MATHEXPR_ASSERT(values != nullptr || this->_variables.size() == 0, "values is NULL");
+
+    if(this->_tiered != nullptr)
+        return std::make_tuple(true, this->_tiered->evaluate(values));
 
     if(!this->_exec_mem.is_locked())
     {
@@ -22,58 +108,278 @@ std::tuple<bool, double> Expr::_evaluate_internal(const double* values) const no
         return std::make_tuple(false, 0.0);
     }
 
+    if(this->_value_type != ValueType_Float64)
+    {
+        log_error("Expression has been compiled in single precision, evaluate it with floats");
+        return std::make_tuple(false, 0.0);
+    }
+
     auto exec_func = this->_exec_mem.as_function();
 
-    double result = exec_func(values, this->_literals.data());
+    double result = exec_func(values);
+
+    return std::make_tuple(true, result);
+}
+
+std::tuple<bool, float> Expr::_evaluate_internal(const float* values) const noexcept
+{
+    /* Expressions without variables are evaluated without values (empty spans have no data) */
+    MATHEXPR_ASSERT(values != nullptr || this->_variables.size() == 0, "values is NULL");
+
+    if(!this->_exec_mem.is_locked())
+    {
+        log_error("ExecMem is not locked nor ready, compile expr before evaluating it");
+        return std::make_tuple(false, 0.0f);
+    }
+
+    if(this->_value_type != ValueType_Float32)
+    {
+        log_error("Expression has been compiled in double precision, evaluate it with doubles");
+        return std::make_tuple(false, 0.0f);
+    }
+
+    auto exec_func = this->_exec_mem.as_function<ExecMem::FloatFunctionType>();
+
+    float result = exec_func(values);
 
     return std::make_tuple(true, result);
 }
 
-bool Expr::compile(uint64_t debug_flags) noexcept
+bool Expr::_check_batch(size_t num_columns) const noexcept
+{
+    if(num_columns != this->_variables.size())
+    {
+        log_error("You passed {} columns but the expression needs {}",
+                  num_columns,
+                  this->_variables.size());
+
+        return false;
+    }
+
+    if(this->_tiered == nullptr && !this->_exec_mem.is_locked())
+    {
+        log_error("ExecMem is not locked nor ready, compile expr before evaluating it");
+        return false;
+    }
+
+    if(this->_value_type != ValueType_Float64)
+    {
+        log_error("Expression has been compiled in single precision, evaluate it with floats");
+        return false;
+    }
+
+    return true;
+}
+
+bool Expr::evaluate_batch(std::span<const double* const> columns, std::span<double> outputs) const noexcept
+{
+    if(!this->_check_batch(columns.size()))
+        return false;
+
+    /* Tiered expressions count each row as a call */
+    TieredCode* tiered = this->_tiered.get();
+
+    auto exec_func = tiered == nullptr ? this->_exec_mem.as_function() : nullptr;
+
+    /* Each row is gathered into the values buffer the compiled function takes */
+    std::vector<double> values(std::max(columns.size(), static_cast<size_t>(1)));
+
+    for(size_t row = 0; row < outputs.size(); row++)
+    {
+        for(size_t slot = 0; slot < columns.size(); slot++)
+            values[slot] = columns[slot][row];
+
+        outputs[row] = tiered != nullptr ? tiered->evaluate(values.data()) : exec_func(values.data());
+    }
+
+    return true;
+}
+
+bool Expr::evaluate_batch(std::span<const StridedColumn> columns, std::span<double> outputs) const noexcept
+{
+    if(!this->_check_batch(columns.size()))
+        return false;
+
+    TieredCode* tiered = this->_tiered.get();
+
+    auto exec_func = tiered == nullptr ? this->_exec_mem.as_function() : nullptr;
+
+    std::vector<double> values(std::max(columns.size(), static_cast<size_t>(1)));
+    std::vector<const std::byte*> pointers(columns.size());
+
+    for(size_t slot = 0; slot < columns.size(); slot++)
+        pointers[slot] = reinterpret_cast<const std::byte*>(columns[slot].values);
+
+    /* Same gather as for contiguous columns, the pointers step by the stride of their column */
+    for(size_t row = 0; row < outputs.size(); row++)
+    {
+        for(size_t slot = 0; slot < columns.size(); slot++)
+        {
+            std::memcpy(&values[slot], pointers[slot], sizeof(double));
+            pointers[slot] += columns[slot].stride;
+        }
+
+        outputs[row] = tiered != nullptr ? tiered->evaluate(values.data()) : exec_func(values.data());
+    }
+
+    return true;
+}
+
+/* Returns the 8 validity bits of the rows [row, row + 8) of a bitmap starting at bit offset */
+static uint8_t load_validity_byte(const uint8_t* validity, size_t offset, size_t row, size_t num_rows) noexcept
+{
+    const size_t bit = offset + row;
+    const size_t shift = bit % 8;
+    const size_t num_bits = std::min(num_rows - row, static_cast<size_t>(8));
+
+    uint32_t bits = validity[bit / 8] >> shift;
+
+    /* The next byte is only read when the rows actually reach it, it may be past the bitmap */
+    if(shift + num_bits > 8)
+        bits |= static_cast<uint32_t>(validity[bit / 8 + 1]) << (8 - shift);
+
+    return static_cast<uint8_t>(bits);
+}
+
+bool Expr::evaluate_batch(std::span<const ArrowColumn> columns,
+                          std::span<double> outputs,
+                          std::span<uint8_t> validity) const noexcept
+{
+    const size_t num_rows = outputs.size();
+
+    if(validity.size() < (num_rows + 7) / 8)
+    {
+        log_error("Validity bitmap of {} bytes is too small for {} rows", validity.size(), num_rows);
+        return false;
+    }
+
+    std::vector<const double*> values(columns.size());
+
+    for(size_t slot = 0; slot < columns.size(); slot++)
+        values[slot] = columns[slot].values + columns[slot].offset;
+
+    if(!this->evaluate_batch(values, outputs))
+        return false;
+
+    /* Nulls only affect the output bitmap, a byte of rows at a time */
+    for(size_t row = 0; row < num_rows; row += 8)
+    {
+        uint8_t valid = 0xFF;
+
+        for(const ArrowColumn& column : columns)
+        {
+            if(column.validity != nullptr)
+                valid &= load_validity_byte(column.validity, column.offset, row, num_rows);
+        }
+
+        /* Padding bits of the last byte are cleared */
+        if(num_rows - row < 8)
+            valid &= static_cast<uint8_t>((1u << (num_rows - row)) - 1);
+
+        validity[row / 8] = valid;
+    }
+
+    return true;
+}
+
+bool Expr::evaluate_batch(const ArrowColumns& columns,
+                          std::span<double> outputs,
+                          std::span<uint8_t> validity) const noexcept
+{
+    std::vector<ArrowColumn> slot_columns(this->_variables.size());
+
+    for(size_t slot = 0; slot < this->_variables.size(); slot++)
+    {
+        const auto it = columns.find(this->_variables.get_name(slot));
+
+        if(it == columns.end())
+        {
+            log_error("Variable \"{}\" has no matching column", this->_variables.get_name(slot));
+            return false;
+        }
+
+        slot_columns[slot] = it->second;
+    }
+
+    return this->evaluate_batch(slot_columns, outputs, validity);
+}
+
+bool Expr::set_literal(size_t slot, double value) noexcept
+{
+    if(this->_parametric_literals == nullptr)
+    {
+        log_error("Expression has not been compiled with parametric literals");
+        return false;
+    }
+
+    if(slot >= this->_literals.size())
+    {
+        log_error("Invalid literal slot: {}", slot);
+        return false;
+    }
+
+    if(this->_value_type == ValueType_Float32)
+        static_cast<float*>(this->_parametric_literals)[slot] = static_cast<float>(value);
+    else
+        static_cast<double*>(this->_parametric_literals)[slot] = value;
+
+    return true;
+}
+
+/*
+    Returns the ABI of the platform we're running on, nullptr if we cannot generate code for it.
+    Nothing is logged when the caller can do without code generation
+*/
+PlatformABIPtr get_compilation_platform_abi(uint32_t& isa, bool required = true) noexcept
 {
     uint32_t platform = get_current_platform();
 
     if(platform == Platform_Invalid)
     {
-        log_error("Current platform is not supported");
-        return false;
+        if(required)
+            log_error("Current platform is not supported");
+
+        return nullptr;
     }
 
-    uint32_t isa = get_current_isa();
+    isa = get_current_isa();
 
     if(isa == ISA_Invalid)
     {
-        log_error("Current isa is not supported");
-        return false;
+        if(required)
+            log_error("Current isa is not supported");
+
+        return nullptr;
     }
 
     PlatformABIPtr platform_abi = get_current_platform_abi(isa, platform);
 
     if(platform_abi == nullptr)
     {
-        log_error("Current ABI is not supported");
-        return false;
-    }
+        if(required)
+            log_error("Current ABI is not supported");
 
-    this->_variables.clear();
-    this->_literals.clear();
+        return nullptr;
+    }
 
-    log_debug("Compiling expression: {}", this->_expr);
+    return platform_abi;
+}
 
-    auto [lex_success, tokens] = lexer_lex_expression(this->_expr);
+/* Parses an expression and collects its symbols */
+bool parse_expression(std::string_view expr, AST& ast, SymbolTable& symtable, uint64_t debug_flags) noexcept
+{
+    auto [lex_success, tokens] = lexer_lex_expression(expr);
 
     if(!lex_success)
     {
-        log_error("Error while lexing expression: {}", this->_expr);
+        log_error("Error while lexing expression: {}", expr);
         log_error("Check the log for more information");
         return false;
     }
 
-    AST ast;
-
     if(!ast.build_from_tokens(tokens))
     {
-        log_error("Error while building AST for expression: {}", this->_expr);
+        log_error("Error while building AST for expression: {}", expr);
         log_error("Check the log for more information");
         return false;
     }
@@ -81,37 +387,46 @@ bool Expr::compile(uint64_t debug_flags) noexcept
     if(debug_flags & ExprPrintFlags_PrintAST)
         ast.print();
 
-    SymbolTable symtable;
-
     symtable.collect(ast);
 
-    if(debug_flags & ExprPrintFlags_PrintSymTable)
-        symtable.print();
-
-    /* Variables and literals are stored in order of parsing */
-    for(auto [name, _] : symtable.get_variables())
-        this->_variables.insert(name);
+    return true;
+}
 
-    for(auto [_, lit] : symtable.get_literals())
-        this->_literals.push_back(lit.get_value());
+/* Parses an expression straight to SSA, the AST is only built when it has to be printed */
+bool parse_expression_to_ssa(std::string_view expr, SSA& ssa, SymbolTable& symtable, uint64_t debug_flags) noexcept
+{
+    if(debug_flags & ExprPrintFlags_PrintAST)
+    {
+        AST ast;
+        SymbolTable ast_symtable;
 
-    SSA ssa;
+        if(!parse_expression(expr, ast, ast_symtable, ExprPrintFlags_PrintAST))
+            return false;
+    }
 
-    if(!ssa.build_from_ast(ast))
+    if(!ssa.build_from_source(expr, symtable))
     {
-        log_error("Error while building SSA for expression: {}", this->_expr);
+        log_error("Error while building SSA for expression: {}", expr);
         log_error("Check the log for more information");
         return false;
     }
 
+    return true;
+}
+
+/* Register allocation of an SSA, shared by the expressions and the reductions */
+bool allocate_ssa(std::string_view expr,
+                  SSA& ssa,
+                  SymbolTable& symtable,
+                  RegisterAllocator& reg_allocator,
+                  uint64_t debug_flags) noexcept
+{
     if(debug_flags & ExprPrintFlags_PrintSSA)
         ssa.print();
 
-    RegisterAllocator reg_allocator(platform_abi);
-
     if(!reg_allocator.allocate(ssa, symtable))
     {
-        log_error("Error during register allocation for expression: {}", this->_expr);
+        log_error("Error during register allocation for expression: {}", expr);
         log_error("Check the log for more information");
         return false;
     }
@@ -119,22 +434,24 @@ bool Expr::compile(uint64_t debug_flags) noexcept
     if(debug_flags & ExprPrintFlags_PrintSSARegisterAlloc)
         ssa.print();
 
-    CodeGenerator generator(isa, platform_abi);
-
-    if(!generator.build(ssa, reg_allocator, symtable))
-    {
-        log_error("Error while building CodeGenerator for expression: {}", this->_expr);
-        log_error("Check the log for more information");
-        return false;
-    }
+    return true;
+}
 
+/* Bytecode generation and linking of a built code generator */
+bool emit_bytecode(std::string_view expr,
+                   const CodeGenerator& generator,
+                   uint32_t value_type,
+                   uint64_t debug_flags,
+                   size_t constant_pool_alignment,
+                   ByteCode& bytecode) noexcept
+{
     if(debug_flags & ExprPrintFlags_PrintCodeGeneratorAsString)
     {
         auto [gen_str_success, code] = generator.as_string();
 
         if(!gen_str_success)
         {
-            log_error("Error during code generation for expression: {}", this->_expr);
+            log_error("Error during code generation for expression: {}", expr);
             log_error("Check the log for more information");
 
             return false;
@@ -145,11 +462,11 @@ bool Expr::compile(uint64_t debug_flags) noexcept
 
     Relocations relocs;
 
-    auto [gen_success, bytecode] = generator.as_bytecode(relocs);
+    auto [gen_success, code] = generator.as_bytecode(relocs, constant_pool_alignment);
 
     if(!gen_success)
     {
-        log_error("Error during bytecode generation for expression: {}", this->_expr);
+        log_error("Error during bytecode generation for expression: {}", expr);
         log_error("Check the log for more information");
         return false;
     }
@@ -160,9 +477,9 @@ bool Expr::compile(uint64_t debug_flags) noexcept
         std::cout << "\n";
     }
 
-    if(!relocate(bytecode, relocs))
+    if(!relocate(code, relocs, value_type))
     {
-        log_error("Error during relocation for expression: {}", this->_expr);
+        log_error("Error during relocation for expression: {}", expr);
         log_error("Check the log for more information");
         return false;
     }
@@ -171,20 +488,200 @@ bool Expr::compile(uint64_t debug_flags) noexcept
     {
         std::cout << "BYTECODE" << "\n";
 
-        for(const auto byte : bytecode)
+        for(const auto byte : code)
             std::cout << std::format("{:02x}", static_cast<uint8_t>(byte));
 
         std::cout << "\n\n";
     }
 
+    bytecode = std::move(code);
+
+    return true;
+}
+
+/* Register allocation, code generation and linking of an SSA, shared by Expr and ExprGroup */
+bool compile_ssa(std::string_view expr,
+                 SSA& ssa,
+                 SymbolTable& symtable,
+                 uint32_t isa,
+                 PlatformABIPtr platform_abi,
+                 uint32_t value_type,
+                 uint64_t debug_flags,
+                 size_t constant_pool_alignment,
+                 ByteCode& bytecode) noexcept
+{
+    RegisterAllocator reg_allocator(platform_abi);
+
+    if(!allocate_ssa(expr, ssa, symtable, reg_allocator, debug_flags))
+        return false;
+
+    CodeGenerator generator(isa, platform_abi, value_type);
+
+    if(!generator.build(ssa, reg_allocator, symtable))
+    {
+        log_error("Error while building CodeGenerator for expression: {}", expr);
+        log_error("Check the log for more information");
+        return false;
+    }
+
+    return emit_bytecode(expr, generator, value_type, debug_flags, constant_pool_alignment, bytecode);
+}
+
+void TieredCode::compile() noexcept
+{
+    SymbolTable symtable;
+    SSA ssa;
+
+    /* The expression is parsed again, the SSA of the interpreter references the Expr it was built for */
+    if(!parse_expression_to_ssa(this->expr, ssa, symtable, 0))
+        return;
+
+    ByteCode bytecode;
+
+    if(!compile_ssa(this->expr,
+                    ssa,
+                    symtable,
+                    this->isa,
+                    this->platform_abi,
+                    ValueType_Float64,
+                    0,
+                    sizeof(double),
+                    bytecode))
+    {
+        return;
+    }
+
+    ExecMem exec_mem(bytecode.size() * sizeof(std::byte));
+
+    if(!exec_mem.write(bytecode) || !exec_mem.lock())
+        return;
+
+    this->exec_mem = std::move(exec_mem);
+    this->function.store(this->exec_mem.as_function(), std::memory_order_release);
+
+    log_debug("Promoted expression to machine code: {}", this->expr);
+}
+
+bool Expr::compile(uint64_t debug_flags, uint64_t compile_flags) noexcept
+{
+    this->_variables.clear();
+    this->_literals.clear();
+    this->_parametric_literals = nullptr;
+    this->_tiered = nullptr;
+    this->_value_type = (compile_flags & ExprCompileFlags_Float32) ? ValueType_Float32 : ValueType_Float64;
+
+    uint32_t isa = ISA_Invalid;
+
+    PlatformABIPtr platform_abi = (compile_flags & ExprCompileFlags_Interpreted) ?
+                                      nullptr :
+                                      get_compilation_platform_abi(isa, false);
+
+    /* Without a code generator for this platform the expression is interpreted */
+    const bool interpreted = platform_abi == nullptr;
+
+    if(interpreted && !(compile_flags & ExprCompileFlags_Interpreted))
+        log_warning("Cannot generate code for the current platform, expression will be interpreted");
+
+    if(interpreted && (compile_flags & ExprCompileFlags_Float32))
+    {
+        log_error("Single precision is only available for expressions compiled to machine code");
+        return false;
+    }
+
+    const bool tiered = !interpreted && (compile_flags & ExprCompileFlags_Tiered);
+
+    if(tiered && (compile_flags & (ExprCompileFlags_Float32 | ExprCompileFlags_ParametricLiterals)))
+    {
+        log_error("Tiered execution is only available for double precision expressions without parametric literals");
+        return false;
+    }
+
+    log_debug("Compiling expression: {}", this->_expr);
+
+    SymbolTable symtable(value_type_size(this->_value_type));
+    SSA ssa;
+
+    if(!parse_expression_to_ssa(this->_expr, ssa, symtable, debug_flags))
+        return false;
+
+    if(debug_flags & ExprPrintFlags_PrintSymTable)
+        symtable.print();
+
+    /* Variables and literals are stored in order of parsing */
+    for(auto [name, var] : symtable.get_variables())
+        this->_variables.add(name, var.get_id());
+
+    /* Internal literals are not exposed, their slots come after the ones of the expression literals */
+    for(auto [name, lit] : symtable.get_literals())
+        if(!lit.is_internal())
+            this->_literals.add(name, lit.get_id());
+
+    const bool parametric_literals = (compile_flags & ExprCompileFlags_ParametricLiterals) &&
+                                     this->_literals.size() > 0;
+
+    /* Code generation is deferred until the expression gets hot, or never happens */
+    if(tiered || interpreted)
+    {
+        auto tiered_code = std::make_shared<TieredCode>();
+        tiered_code->expr = this->_expr;
+        tiered_code->isa = isa;
+        tiered_code->platform_abi = platform_abi;
+
+        if(debug_flags & ExprPrintFlags_PrintSSA)
+            ssa.print();
+
+        if(!tiered_code->interpreter.build(ssa, symtable))
+        {
+            log_error("Error while building interpreter for expression: {}", this->_expr);
+            log_error("Check the log for more information");
+            return false;
+        }
+
+        if(debug_flags & ExprPrintFlags_PrintInterpreter)
+            tiered_code->interpreter.print();
+
+        /* The interpreter constants are indexed by the literal ids, like the constant pool */
+        if(parametric_literals)
+            this->_parametric_literals = tiered_code->interpreter.get_constants();
+
+        this->_exec_mem = ExecMem();
+        this->_tiered = std::move(tiered_code);
+
+        log_debug("Interpreting expression: {}", this->_expr);
+
+        return true;
+    }
+
+    ByteCode bytecode;
+
+    /* Parametric literals get their own pages, they stay writable once the code is locked */
+    if(!compile_ssa(this->_expr,
+                    ssa,
+                    symtable,
+                    isa,
+                    platform_abi,
+                    this->_value_type,
+                    debug_flags,
+                    parametric_literals ? ExecMem::get_page_size() : sizeof(double),
+                    bytecode))
+    {
+        return false;
+    }
+
     ExecMem exec_mem(bytecode.size() * sizeof(std::byte));
 
     if(!exec_mem.write(bytecode))
         return false;
 
-    if(!exec_mem.lock())
+    const size_t constant_pool_start = bytecode.size() -
+                                       symtable.get_num_literals() * value_type_size(this->_value_type);
+
+    if(!exec_mem.lock(parametric_literals ? constant_pool_start : bytecode.size()))
         return false;
 
+    if(parametric_literals)
+        this->_parametric_literals = exec_mem.get_writable_data();
+
     this->_exec_mem = std::move(exec_mem);
 
     log_debug("Compiled expression: {}", this->_expr);
@@ -193,4 +690,315 @@ bool Expr::compile(uint64_t debug_flags) noexcept
     return true;
 }
 
-MATHEXPR_NAMESPACE_END
+/* Gradients */
+
+bool Expr::evaluate_gradient(std::span<const double> values, std::span<double> outputs) const noexcept
+{
+    if(values.size() != this->_gradient_variables.size())
+    {
+        log_error("You passed {} values but the expression needs {}",
+                  values.size(),
+                  this->_gradient_variables.size());
+
+        return false;
+    }
+
+    if(outputs.size() < this->_gradient_variables.size() + 1)
+    {
+        log_error("You passed {} outputs but the gradient needs {} (value and partial derivatives)",
+                  outputs.size(),
+                  this->_gradient_variables.size() + 1);
+
+        return false;
+    }
+
+    if(!this->_gradient_exec_mem.is_locked())
+    {
+        log_error("ExecMem is not locked nor ready, compile the gradient of expr before evaluating it");
+        return false;
+    }
+
+    auto exec_func = this->_gradient_exec_mem.as_function<ExecMem::GroupFunctionType>();
+
+    exec_func(values.data(), outputs.data());
+
+    return true;
+}
+
+bool Expr::compile_gradient(uint64_t debug_flags) noexcept
+{
+    uint32_t isa;
+
+    PlatformABIPtr platform_abi = get_compilation_platform_abi(isa);
+
+    if(platform_abi == nullptr)
+        return false;
+
+    log_debug("Compiling gradient of expression: {}", this->_expr);
+
+    AST ast;
+    SymbolTable symtable;
+
+    if(!parse_expression(this->_expr, ast, symtable, debug_flags))
+        return false;
+
+    /* The outputs follow the layout of the gradient */
+    this->_gradient_variables.clear();
+
+    for(auto [name, var] : symtable.get_variables())
+        this->_gradient_variables.add(name, var.get_id());
+
+    SSA ssa;
+
+    if(!ssa.build_gradient_from_ast(ast, symtable))
+    {
+        log_error("Error while building gradient SSA for expression: {}", this->_expr);
+        log_error("Check the log for more information");
+        return false;
+    }
+
+    if(debug_flags & ExprPrintFlags_PrintSymTable)
+        symtable.print();
+
+    ByteCode bytecode;
+
+    if(!compile_ssa(this->_expr,
+                    ssa,
+                    symtable,
+                    isa,
+                    platform_abi,
+                    ValueType_Float64,
+                    debug_flags,
+                    sizeof(double),
+                    bytecode))
+    {
+        return false;
+    }
+
+    ExecMem exec_mem(bytecode.size() * sizeof(std::byte));
+
+    if(!exec_mem.write(bytecode))
+        return false;
+
+    if(!exec_mem.lock())
+        return false;
+
+    this->_gradient_exec_mem = std::move(exec_mem);
+
+    log_debug("Compiled gradient of expression: {}", this->_expr);
+
+    return true;
+}
+
+/* Expression groups */
+
+bool ExprGroup::evaluate(std::span<const double> values, std::span<double> outputs) const noexcept
+{
+    if(values.size() != this->_variables.size())
+    {
+        log_error("You passed {} values but the expression group needs {}",
+                  values.size(),
+                  this->_variables.size());
+
+        return false;
+    }
+
+    if(outputs.size() < this->_exprs.size())
+    {
+        log_error("You passed {} outputs but the expression group has {} expressions",
+                  outputs.size(),
+                  this->_exprs.size());
+
+        return false;
+    }
+
+    if(!this->_exec_mem.is_locked())
+    {
+        log_error("ExecMem is not locked nor ready, compile expr group before evaluating it");
+        return false;
+    }
+
+    auto exec_func = this->_exec_mem.as_function<ExecMem::GroupFunctionType>();
+
+    exec_func(values.data(), outputs.data());
+
+    return true;
+}
+
+bool ExprGroup::compile(uint64_t debug_flags) noexcept
+{
+    if(this->_exprs.empty())
+    {
+        log_error("Cannot compile an empty expression group");
+        return false;
+    }
+
+    uint32_t isa;
+
+    PlatformABIPtr platform_abi = get_compilation_platform_abi(isa);
+
+    if(platform_abi == nullptr)
+        return false;
+
+    this->_variables.clear();
+
+    log_debug("Compiling expression group of {} expressions", this->_exprs.size());
+
+    /* All the expressions share the same symbol table, variables and literals are loaded once */
+    std::vector<AST> asts(this->_exprs.size());
+    SymbolTable symtable;
+
+    for(const auto [i, expr] : std::views::enumerate(this->_exprs))
+    {
+        if(!parse_expression(expr, asts[i], symtable, debug_flags))
+            return false;
+    }
+
+    if(debug_flags & ExprPrintFlags_PrintSymTable)
+        symtable.print();
+
+    for(auto [name, var] : symtable.get_variables())
+        this->_variables.add(name, var.get_id());
+
+    SSA ssa;
+
+    if(!ssa.build_from_asts(asts))
+    {
+        log_error("Error while building SSA for expression group");
+        log_error("Check the log for more information");
+        return false;
+    }
+
+    ByteCode bytecode;
+
+    if(!compile_ssa("<group>",
+                    ssa,
+                    symtable,
+                    isa,
+                    platform_abi,
+                    ValueType_Float64,
+                    debug_flags,
+                    sizeof(double),
+                    bytecode))
+        return false;
+
+    ExecMem exec_mem(bytecode.size() * sizeof(std::byte));
+
+    if(!exec_mem.write(bytecode))
+        return false;
+
+    if(!exec_mem.lock())
+        return false;
+
+    this->_exec_mem = std::move(exec_mem);
+
+    log_debug("Compiled expression group of {} expressions", this->_exprs.size());
+
+    return true;
+}
+
+/* Reductions */
+
+/* Rows processed per iteration of the reduction loops, each one with its own accumulator */
+static constexpr uint64_t REDUCTION_UNROLL = 4;
+
+std::tuple<bool, double> ExprReduction::evaluate(std::span<const double* const> columns,
+                                                 size_t num_rows) const noexcept
+{
+    if(columns.size() != this->_variables.size())
+    {
+        log_error("You passed {} columns but the reduction needs {}",
+                  columns.size(),
+                  this->_variables.size());
+
+        return std::make_tuple(false, 0.0);
+    }
+
+    if(!this->_exec_mem.is_locked())
+    {
+        log_error("ExecMem is not locked nor ready, compile reduction before evaluating it");
+        return std::make_tuple(false, 0.0);
+    }
+
+    auto exec_func = this->_exec_mem.as_function<ExecMem::ReductionFunctionType>();
+
+    return std::make_tuple(true, exec_func(columns.data(), static_cast<uint64_t>(num_rows)));
+}
+
+bool ExprReduction::compile(uint64_t debug_flags) noexcept
+{
+    uint32_t isa;
+
+    PlatformABIPtr platform_abi = get_compilation_platform_abi(isa);
+
+    if(platform_abi == nullptr)
+        return false;
+
+    this->_variables.clear();
+
+    log_debug("Compiling reduction: {}", this->_expr);
+
+    AST ast;
+    SymbolTable symtable;
+
+    if(!parse_expression(this->_expr, ast, symtable, debug_flags))
+        return false;
+
+    if(debug_flags & ExprPrintFlags_PrintSymTable)
+        symtable.print();
+
+    for(auto [name, var] : symtable.get_variables())
+        this->_variables.add(name, var.get_id());
+
+    /* The unrolled body and the tail processing the remaining rows one by one */
+    SSA body;
+    SSA tail;
+
+    if(!body.build_reduction_from_ast(ast, REDUCTION_UNROLL) || !tail.build_reduction_from_ast(ast, 1))
+    {
+        log_error("Error while building SSA for reduction: {}", this->_expr);
+        log_error("Check the log for more information");
+        return false;
+    }
+
+    RegisterAllocator body_allocator(platform_abi);
+    RegisterAllocator tail_allocator(platform_abi);
+
+    if(!allocate_ssa(this->_expr, body, symtable, body_allocator, debug_flags) ||
+       !allocate_ssa(this->_expr, tail, symtable, tail_allocator, debug_flags))
+    {
+        return false;
+    }
+
+    CodeGenerator generator(isa, platform_abi);
+
+    const bool mean = node_cast<ASTNodeFunctionOp>(ast.get_root())->get_function_name() == MEAN_FUNCTION_NAME;
+
+    if(!generator.build_reduction(body, body_allocator, tail, tail_allocator, symtable, REDUCTION_UNROLL, mean))
+    {
+        log_error("Error while building CodeGenerator for reduction: {}", this->_expr);
+        log_error("Check the log for more information");
+        return false;
+    }
+
+    ByteCode bytecode;
+
+    if(!emit_bytecode(this->_expr, generator, ValueType_Float64, debug_flags, sizeof(double), bytecode))
+        return false;
+
+    ExecMem exec_mem(bytecode.size() * sizeof(std::byte));
+
+    if(!exec_mem.write(bytecode))
+        return false;
+
+    if(!exec_mem.lock())
+        return false;
+
+    this->_exec_mem = std::move(exec_mem);
+
+    log_debug("Compiled reduction: {}", this->_expr);
+
+    return true;
+}
+
+MATHEXPR_NAMESPACE_END
\ No newline at end of file
@@ -0,0 +1,481 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/interpreter.hpp"
+#include "mathexpr/libmaths.hpp"
+#include "mathexpr/op.hpp"
+#include "mathexpr/log.hpp"
+
+#include <bit>
+#include <cmath>
+#include <format>
+#include <iostream>
+
+MATHEXPR_NAMESPACE_BEGIN
+
+const char* interpreter_op_as_string(uint32_t op) noexcept
+{
+    switch(op)
+    {
+        case InterpreterOp_LoadVariable:
+            return "load";
+        case InterpreterOp_LoadConstant:
+            return "loadi";
+        case InterpreterOp_Neg:
+            return "neg";
+        case InterpreterOp_MaskToBool:
+            return "bool";
+        case InterpreterOp_Sqrt:
+            return "sqrt";
+        case InterpreterOp_Add:
+            return "add";
+        case InterpreterOp_Sub:
+            return "sub";
+        case InterpreterOp_Mul:
+            return "mul";
+        case InterpreterOp_Div:
+            return "div";
+        case InterpreterOp_Eq:
+            return "eq";
+        case InterpreterOp_Neq:
+            return "neq";
+        case InterpreterOp_Lt:
+            return "lt";
+        case InterpreterOp_Le:
+            return "le";
+        case InterpreterOp_Gt:
+            return "gt";
+        case InterpreterOp_Ge:
+            return "ge";
+        case InterpreterOp_And:
+            return "and";
+        case InterpreterOp_AndNot:
+            return "andnot";
+        case InterpreterOp_Or:
+            return "or";
+        case InterpreterOp_Call1:
+        case InterpreterOp_Call2:
+        case InterpreterOp_Call3:
+            return "call";
+        case InterpreterOp_Return:
+            return "ret";
+        default:
+            return "?";
+    }
+}
+
+static uint32_t interpreter_op_from_binary_op(uint32_t op) noexcept
+{
+    switch(op)
+    {
+        case BinaryOpType_Add:
+            return InterpreterOp_Add;
+        case BinaryOpType_Sub:
+            return InterpreterOp_Sub;
+        case BinaryOpType_Mul:
+            return InterpreterOp_Mul;
+        case BinaryOpType_Div:
+            return InterpreterOp_Div;
+        case BinaryOpType_Eq:
+            return InterpreterOp_Eq;
+        case BinaryOpType_Neq:
+            return InterpreterOp_Neq;
+        case BinaryOpType_Lt:
+            return InterpreterOp_Lt;
+        case BinaryOpType_Le:
+            return InterpreterOp_Le;
+        case BinaryOpType_Gt:
+            return InterpreterOp_Gt;
+        case BinaryOpType_Ge:
+            return InterpreterOp_Ge;
+        case BinaryOpType_And:
+            return InterpreterOp_And;
+        case BinaryOpType_AndNot:
+            return InterpreterOp_AndNot;
+        case BinaryOpType_Or:
+            return InterpreterOp_Or;
+        default:
+            return INVALID_INTERPRETER_OP;
+    }
+}
+
+bool Interpreter::build(const SSA& ssa, const SymbolTable& symtable) noexcept
+{
+    this->_instructions.clear();
+    this->_constants.assign(symtable.get_num_literals(), 0.0);
+    this->_functions.clear();
+    this->_num_registers = 0;
+
+    for(const auto& [_, literal] : symtable.get_literals())
+        this->_constants[literal.get_id()] = literal.get_value();
+
+    /* Each statement gets the register of its index */
+    const std::vector<SSAStmt>& statements = ssa.get_statements();
+
+    for(uint32_t i = 0; i < statements.size(); i++)
+    {
+        const SSAStmt& stmt = statements[i];
+
+        InterpreterInstr instr = { INVALID_INTERPRETER_OP, i, stmt.a, stmt.b, stmt.c, 0 };
+
+        switch(stmt.type)
+        {
+            case SSAStmtTypeId_Variable:
+            {
+                const auto it = symtable.get_variables().find(ssa.get_name(stmt.op));
+
+                if(it == symtable.get_variables().end())
+                {
+                    log_error("Cannot find variable \"{}\" in the symbol table", ssa.get_name(stmt.op));
+                    return false;
+                }
+
+                instr.op = InterpreterOp_LoadVariable;
+                instr.a = static_cast<uint32_t>(it->second.get_id());
+
+                break;
+            }
+            case SSAStmtTypeId_Literal:
+            {
+                const auto it = symtable.get_literals().find(ssa.get_name(stmt.op));
+
+                if(it == symtable.get_literals().end())
+                {
+                    log_error("Cannot find literal \"{}\" in the symbol table", ssa.get_name(stmt.op));
+                    return false;
+                }
+
+                instr.op = InterpreterOp_LoadConstant;
+                instr.a = static_cast<uint32_t>(it->second.get_id());
+
+                break;
+            }
+            case SSAStmtTypeId_UnOp:
+            {
+                switch(stmt.op)
+                {
+                    case UnaryOpType_Neg:
+                        instr.op = InterpreterOp_Neg;
+                        break;
+                    case UnaryOpType_MaskToBool:
+                        instr.op = InterpreterOp_MaskToBool;
+                        break;
+                    case UnaryOpType_Sqrt:
+                        instr.op = InterpreterOp_Sqrt;
+                        break;
+                }
+
+                break;
+            }
+            case SSAStmtTypeId_BinOp:
+            {
+                instr.op = interpreter_op_from_binary_op(stmt.op);
+
+                break;
+            }
+            case SSAStmtTypeId_FuncOp:
+            {
+                const std::string_view name = ssa.get_name(stmt.op);
+                const libmaths::FunctionEntry* entry = libmaths::get_function_entry(name);
+                const size_t num_arguments = stmt.get_num_arguments();
+
+                if(entry == nullptr ||
+                   entry->scalar_ptr == nullptr ||
+                   entry->arity != num_arguments ||
+                   num_arguments == 0)
+                {
+                    log_error("Cannot interpret call to function \"{}\"", name);
+                    return false;
+                }
+
+                instr.op = InterpreterOp_Call1 + static_cast<uint32_t>(num_arguments) - 1;
+                instr.function = static_cast<uint32_t>(this->_functions.size());
+
+                this->_functions.push_back(entry->scalar_ptr);
+
+                break;
+            }
+            default:
+            {
+                log_error("Cannot interpret SSA statement of type {}", stmt.type);
+                return false;
+            }
+        }
+
+        if(instr.op == INVALID_INTERPRETER_OP || instr.op > InterpreterOp_Call3)
+        {
+            log_error("Cannot interpret SSA statement {}{}", VERSION_CHAR, i);
+            return false;
+        }
+
+        this->_instructions.push_back(instr);
+    }
+
+    this->_num_registers = static_cast<uint32_t>(statements.size());
+
+    if(this->_instructions.empty())
+    {
+        log_error("Cannot build an interpreter from an empty SSA");
+        return false;
+    }
+
+    /* The result of the expression is the last statement */
+    this->_instructions.push_back({ InterpreterOp_Return, 0, this->_instructions.back().dst, 0, 0, 0 });
+
+    return true;
+}
+
+void Interpreter::print() const noexcept
+{
+    static std::ostream_iterator<char> out(std::cout);
+
+    std::format_to(out, "INTERPRETER ({} registers)\n", this->_num_registers);
+
+    for(const InterpreterInstr& instr : this->_instructions)
+    {
+        switch(instr.op)
+        {
+            case InterpreterOp_LoadVariable:
+                std::format_to(out, "    r{} = load values[{}]\n", instr.dst, instr.a);
+                break;
+            case InterpreterOp_LoadConstant:
+                std::format_to(out, "    r{} = loadi {}\n", instr.dst, this->_constants[instr.a]);
+                break;
+            case InterpreterOp_Neg:
+            case InterpreterOp_MaskToBool:
+            case InterpreterOp_Sqrt:
+                std::format_to(out, "    r{} = {} r{}\n", instr.dst, interpreter_op_as_string(instr.op), instr.a);
+                break;
+            case InterpreterOp_Call1:
+                std::format_to(out, "    r{} = call f{}(r{})\n", instr.dst, instr.function, instr.a);
+                break;
+            case InterpreterOp_Call2:
+                std::format_to(out, "    r{} = call f{}(r{}, r{})\n", instr.dst, instr.function, instr.a, instr.b);
+                break;
+            case InterpreterOp_Call3:
+                std::format_to(out,
+                               "    r{} = call f{}(r{}, r{}, r{})\n",
+                               instr.dst,
+                               instr.function,
+                               instr.a,
+                               instr.b,
+                               instr.c);
+                break;
+            case InterpreterOp_Return:
+                std::format_to(out, "    ret r{}\n", instr.a);
+                break;
+            default:
+                std::format_to(out,
+                               "    r{} = {} r{}, r{}\n",
+                               instr.dst,
+                               interpreter_op_as_string(instr.op),
+                               instr.a,
+                               instr.b);
+                break;
+        }
+    }
+
+    std::format_to(out, "\n");
+}
+
+/* Comparisons produce all bits set or cleared, like cmpsd */
+static MATHEXPR_FORCE_INLINE double mask_from_bool(bool value) noexcept
+{
+    return std::bit_cast<double>(value ? UINT64_T_MAX : uint64_t(0));
+}
+
+static MATHEXPR_FORCE_INLINE uint64_t bits(double value) noexcept
+{
+    return std::bit_cast<uint64_t>(value);
+}
+
+#if defined(MATHEXPR_GCC) || defined(MATHEXPR_CLANG)
+#define MATHEXPR_INTERPRETER_COMPUTED_GOTO
+#endif /* defined(MATHEXPR_GCC) || defined(MATHEXPR_CLANG) */
+
+/*
+    Each handler is written once and expanded in both dispatch loops. With computed gotos every
+    handler ends with its own indirect jump, which the branch predictor tracks separately
+*/
+#if defined(MATHEXPR_INTERPRETER_COMPUTED_GOTO)
+#define INTERPRETER_HANDLER(__op__) handler_##__op__:
+#define INTERPRETER_DISPATCH() instr++; goto *handlers[instr->op]
+#else
+#define INTERPRETER_HANDLER(__op__) case InterpreterOp_##__op__:
+#define INTERPRETER_DISPATCH() instr++; continue
+#endif /* defined(MATHEXPR_INTERPRETER_COMPUTED_GOTO) */
+
+#if defined(MATHEXPR_GCC)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#elif defined(MATHEXPR_CLANG)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-label-as-value"
+#endif /* defined(MATHEXPR_GCC) */
+
+double Interpreter::evaluate(const double* values) const noexcept
+{
+    MATHEXPR_ASSERT(this->is_built(), "Interpreter has not been built");
+
+    double stack_registers[INTERPRETER_STACK_REGISTERS];
+    std::vector<double> heap_registers;
+
+    double* r = stack_registers;
+
+    if(this->_num_registers > INTERPRETER_STACK_REGISTERS)
+    {
+        heap_registers.resize(this->_num_registers);
+        r = heap_registers.data();
+    }
+
+    const double* constants = this->_constants.data();
+    void* const* functions = this->_functions.data();
+
+    const InterpreterInstr* instr = this->_instructions.data();
+
+#if defined(MATHEXPR_INTERPRETER_COMPUTED_GOTO)
+    /* Indexed by InterpreterOp */
+    static const void* const handlers[] = {
+        &&handler_LoadVariable,
+        &&handler_LoadConstant,
+        &&handler_Neg,
+        &&handler_MaskToBool,
+        &&handler_Sqrt,
+        &&handler_Add,
+        &&handler_Sub,
+        &&handler_Mul,
+        &&handler_Div,
+        &&handler_Eq,
+        &&handler_Neq,
+        &&handler_Lt,
+        &&handler_Le,
+        &&handler_Gt,
+        &&handler_Ge,
+        &&handler_And,
+        &&handler_AndNot,
+        &&handler_Or,
+        &&handler_Call1,
+        &&handler_Call2,
+        &&handler_Call3,
+        &&handler_Return,
+    };
+
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == InterpreterOp_Count);
+
+    goto *handlers[instr->op];
+#else
+    while(true)
+    {
+        switch(instr->op)
+        {
+#endif /* defined(MATHEXPR_INTERPRETER_COMPUTED_GOTO) */
+
+    INTERPRETER_HANDLER(LoadVariable)
+        r[instr->dst] = values[instr->a];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(LoadConstant)
+        r[instr->dst] = constants[instr->a];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Neg)
+        r[instr->dst] = -r[instr->a];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(MaskToBool)
+        r[instr->dst] = bits(r[instr->a]) != 0 ? 1.0 : 0.0;
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Sqrt)
+        r[instr->dst] = std::sqrt(r[instr->a]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Add)
+        r[instr->dst] = r[instr->a] + r[instr->b];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Sub)
+        r[instr->dst] = r[instr->a] - r[instr->b];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Mul)
+        r[instr->dst] = r[instr->a] * r[instr->b];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Div)
+        r[instr->dst] = r[instr->a] / r[instr->b];
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Eq)
+        r[instr->dst] = mask_from_bool(r[instr->a] == r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Neq)
+        r[instr->dst] = mask_from_bool(r[instr->a] != r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Lt)
+        r[instr->dst] = mask_from_bool(r[instr->a] < r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Le)
+        r[instr->dst] = mask_from_bool(r[instr->a] <= r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Gt)
+        r[instr->dst] = mask_from_bool(r[instr->a] > r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Ge)
+        r[instr->dst] = mask_from_bool(r[instr->a] >= r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(And)
+        r[instr->dst] = std::bit_cast<double>(bits(r[instr->a]) & bits(r[instr->b]));
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(AndNot)
+        r[instr->dst] = std::bit_cast<double>(~bits(r[instr->a]) & bits(r[instr->b]));
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Or)
+        r[instr->dst] = std::bit_cast<double>(bits(r[instr->a]) | bits(r[instr->b]));
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Call1)
+        r[instr->dst] = reinterpret_cast<libmaths::Fn1_d>(functions[instr->function])(r[instr->a]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Call2)
+        r[instr->dst] = reinterpret_cast<libmaths::Fn2_d>(functions[instr->function])(r[instr->a], r[instr->b]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Call3)
+        r[instr->dst] = reinterpret_cast<libmaths::Fn3_d>(functions[instr->function])(r[instr->a],
+                                                                                      r[instr->b],
+                                                                                      r[instr->c]);
+        INTERPRETER_DISPATCH();
+
+    INTERPRETER_HANDLER(Return)
+        return r[instr->a];
+
+#if !defined(MATHEXPR_INTERPRETER_COMPUTED_GOTO)
+            default:
+                MATHEXPR_ASSERT(false, "Invalid interpreter op");
+                return 0.0;
+        }
+    }
+#endif /* !defined(MATHEXPR_INTERPRETER_COMPUTED_GOTO) */
+}
+
+#if defined(MATHEXPR_GCC)
+#pragma GCC diagnostic pop
+#elif defined(MATHEXPR_CLANG)
+#pragma clang diagnostic pop
+#endif /* defined(MATHEXPR_GCC) */
+
+#undef INTERPRETER_HANDLER
+#undef INTERPRETER_DISPATCH
+
+MATHEXPR_NAMESPACE_END
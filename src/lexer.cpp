@@ -5,7 +5,7 @@
 #include "mathexpr/lexer.hpp"
 #include "mathexpr/log.hpp"
 
-#include <cctype>
+#include <charconv>
 #include <format>
 #include <iostream>
 
@@ -18,7 +18,26 @@ MATHEXPR_FORCE_INLINE bool is_operator(unsigned int c)
     return (c == '+') |
            (c == '-') |
            (c == '*') |
-           (c == '/');
+           (c == '/') |
+           (c == '^');
+}
+
+/* Returns the size of the comparison operator at the start of s (< <= > >= == !=), 0 if there is none */
+MATHEXPR_FORCE_INLINE uint32_t consume_comparison(std::string_view s)
+{
+    const bool followed_by_equal = s.size() > 1 && s[1] == '=';
+
+    switch(s.front())
+    {
+        case '<':
+        case '>':
+            return followed_by_equal ? 2 : 1;
+        case '=':
+        case '!':
+            return followed_by_equal ? 2 : 0;
+        default:
+            return 0;
+    }
 }
 
 MATHEXPR_FORCE_INLINE bool is_paren(unsigned int c)
@@ -31,38 +50,145 @@ MATHEXPR_FORCE_INLINE bool is_comma(unsigned int c)
     return c == ',';
 }
 
-MATHEXPR_FORCE_INLINE uint32_t consume_literal(std::string_view s)
+MATHEXPR_FORCE_INLINE bool is_assign(unsigned int c)
 {
-    const std::string_view orig = s;
+    return c == '=';
+}
 
-    uint32_t start = 0;
-    bool found_dot = false;
+MATHEXPR_FORCE_INLINE bool is_semicolon(unsigned int c)
+{
+    return c == ';';
+}
+
+MATHEXPR_FORCE_INLINE bool is_ternary(unsigned int c)
+{
+    return (c == '?') | (c == ':');
+}
+
+/* Returns the number of digits at the start of s, separators are only allowed between two digits */
+MATHEXPR_FORCE_INLINE size_t consume_digits(std::string_view s, uint8_t digit_class)
+{
+    size_t size = 0;
+
+    while(size < s.size())
+    {
+        if(lexer_char_is(s[size], digit_class))
+        {
+            size++;
+        }
+        else if(s[size] == LEXER_DIGIT_SEPARATOR &&
+                size > 0 &&
+                size + 1 < s.size() &&
+                lexer_char_is(s[size + 1], digit_class))
+        {
+            size += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return size;
+}
+
+MATHEXPR_FORCE_INLINE bool is_hex_literal(std::string_view s)
+{
+    return s.size() > 2 && s[0] == '0' && (s[1] | 0x20) == 'x';
+}
+
+uint32_t lexer_consume_literal(std::string_view s, bool& well_formed) noexcept
+{
+    const bool hex = is_hex_literal(s);
+    const uint8_t digit_class = hex ? LexerCharClass_HexDigit : LexerCharClass_Digit;
+
+    size_t size = hex ? 2 : 0;
+    size_t num_digits = consume_digits(s.substr(size), digit_class);
+
+    size += num_digits;
 
-    while(!s.empty() && (std::isdigit(static_cast<int>(s.front())) || s.front() == '.'))
+    if(size < s.size() && s[size] == '.')
     {
-        if(s.front() == '.')
+        const size_t num_fraction_digits = consume_digits(s.substr(size + 1), digit_class);
+
+        num_digits += num_fraction_digits;
+        size += 1 + num_fraction_digits;
+    }
+
+    bool valid_exponent = true;
+
+    /* The exponent is a power of 10 for decimal literals and of 2 for hexadecimal ones, in decimal */
+    if(size < s.size() && (s[size] | 0x20) == (hex ? 'p' : 'e'))
+    {
+        size++;
+
+        if(size < s.size() && (s[size] == '+' || s[size] == '-'))
         {
-            if(found_dot)
+            size++;
+        }
+
+        const size_t num_exponent_digits = consume_digits(s.substr(size), LexerCharClass_Digit);
+
+        valid_exponent = num_exponent_digits > 0;
+        size += num_exponent_digits;
+    }
+
+    const size_t literal_size = size;
+
+    while(size < s.size() && lexer_char_is(s[size], LexerCharClass_LiteralTail))
+    {
+        size++;
+    }
+
+    well_formed = num_digits > 0 && valid_exponent && size == literal_size;
+
+    return static_cast<uint32_t>(size);
+}
+
+bool lexer_parse_literal(std::string_view literal, double& value) noexcept
+{
+    const bool hex = is_hex_literal(literal);
+
+    if(hex)
+    {
+        literal.remove_prefix(2);
+    }
+
+    char buffer[LEXER_MAX_SEPARATED_LITERAL_SIZE];
+
+    if(literal.find(LEXER_DIGIT_SEPARATOR) != std::string_view::npos)
+    {
+        if(literal.size() > sizeof(buffer))
+        {
+            return false;
+        }
+
+        size_t size = 0;
+
+        for(const char c : literal)
+        {
+            if(c != LEXER_DIGIT_SEPARATOR)
             {
-                log_error("Ill-formed literal: {}", orig.substr(0, start + 1));
-                return LEXER_ERROR;
+                buffer[size++] = c;
             }
-        
-            found_dot = true;
         }
 
-        start++;
-        s.remove_prefix(1);
+        literal = std::string_view(buffer, size);
     }
 
-    return start;
+    const auto [ptr, ec] = std::from_chars(literal.data(),
+                                           literal.data() + literal.size(),
+                                           value,
+                                           hex ? std::chars_format::hex : std::chars_format::general);
+
+    return ec == std::errc() && ptr == literal.data() + literal.size();
 }
 
 MATHEXPR_FORCE_INLINE uint32_t consume_symbol(std::string_view s)
 {
     uint32_t start = 0;
 
-    while(!s.empty() && (std::isalnum(static_cast<int>(s.front())) || s.front() == '_'))
+    while(!s.empty() && lexer_char_is(s.front(), LexerCharClass_SymbolTail))
     {
         start++;
         s.remove_prefix(1);
@@ -78,12 +204,14 @@ std::tuple<bool, LexerTokens> lexer_lex_expression(std::string_view expression)
     while(!expression.empty())
     {
         /* Literal */
-        if(std::isdigit(static_cast<int>(expression.front())))
+        if(lexer_char_is(expression.front(), LexerCharClass_Digit))
         {
-            const uint32_t lit_size = consume_literal(expression);
-            
-            if(lit_size == LEXER_ERROR)
+            bool well_formed;
+            const uint32_t lit_size = lexer_consume_literal(expression, well_formed);
+
+            if(!well_formed)
             {
+                log_error("Ill-formed literal: {}", expression.substr(0, lit_size));
                 return std::make_tuple(false, std::move(tokens));
             }
 
@@ -92,7 +220,7 @@ std::tuple<bool, LexerTokens> lexer_lex_expression(std::string_view expression)
             expression.remove_prefix(lit_size);
         }
         /* Symbol */
-        else if(std::isalpha(static_cast<int>(expression.front())))
+        else if(lexer_char_is(expression.front(), LexerCharClass_Alpha))
         {
             const uint32_t sym_size = consume_symbol(expression);
 
@@ -112,6 +240,13 @@ std::tuple<bool, LexerTokens> lexer_lex_expression(std::string_view expression)
 
             expression.remove_prefix(1);
         }
+        /* Comparison operator, checked before the assignment since == starts like it */
+        else if(const uint32_t cmp_size = consume_comparison(expression); cmp_size > 0)
+        {
+            tokens.emplace_back(expression.substr(0, cmp_size), LexerTokenType::Operator);
+
+            expression.remove_prefix(cmp_size);
+        }
         /* Paren */
         else if(is_paren(static_cast<int>(expression.front())))
         {
@@ -128,6 +263,29 @@ std::tuple<bool, LexerTokens> lexer_lex_expression(std::string_view expression)
 
             expression.remove_prefix(1);
         }
+        /* Assignment (in let-bindings) */
+        else if(is_assign(static_cast<int>(expression.front())))
+        {
+            tokens.emplace_back(expression.substr(0, 1), LexerTokenType::Assign);
+
+            expression.remove_prefix(1);
+        }
+        /* Semicolon (terminates let-bindings) */
+        else if(is_semicolon(static_cast<int>(expression.front())))
+        {
+            tokens.emplace_back(expression.substr(0, 1), LexerTokenType::Semicolon);
+
+            expression.remove_prefix(1);
+        }
+        /* Ternary (cond ? a : b) */
+        else if(is_ternary(static_cast<int>(expression.front())))
+        {
+            tokens.emplace_back(expression.substr(0, 1), 
+                                expression.front() == '?' ? LexerTokenType::Question : 
+                                                            LexerTokenType::Colon);
+
+            expression.remove_prefix(1);
+        }
         else
         {
             expression.remove_prefix(1);
@@ -141,12 +299,19 @@ uint32_t lexer_get_operator_precedence(char op) noexcept
 {
     switch(op) 
     {
+        case '^':
+            return 4;
         case '*':
         case '/':
             return 3;
         case '+':
         case '-':         
             return 2;
+        case '<':
+        case '>':
+        case '=':
+        case '!':
+            return 1;
         default:
             return 0;
     }
@@ -175,6 +340,14 @@ const char* lexer_token_type_to_string(const uint32_t type) noexcept
             return "ENDOFFILE";
         case Comma:
             return "COMMA";
+        case Assign:
+            return "ASSIGN";
+        case Semicolon:
+            return "SEMICOLON";
+        case Question:
+            return "QUESTION";
+        case Colon:
+            return "COLON";
         case Empty:
             return "EMPTY";
         default:
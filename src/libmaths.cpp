@@ -30,6 +30,11 @@ double4 abs_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float abs_f(const float x) noexcept
+{
+    return ::fabsf(x);
+}
+
 /* Square root */
 double sqrt_d(const double x) noexcept
 {
@@ -46,6 +51,11 @@ double4 sqrt_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float sqrt_f(const float x) noexcept
+{
+    return ::sqrtf(x);
+}
+
 /* Cube root */
 double cbrt_d(const double x) noexcept
 {
@@ -62,6 +72,11 @@ double4 cbrt_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float cbrt_f(const float x) noexcept
+{
+    return ::cbrtf(x);
+}
+
 /* Power function */
 double pow_d(const double x, const double y) noexcept
 {
@@ -78,6 +93,11 @@ double4 pow_d4(const double4 x, const double4 y) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float pow_f(const float x, const float y) noexcept
+{
+    return ::powf(x, y);
+}
+
 /* Exponential function */
 double exp_d(const double x) noexcept
 {
@@ -94,6 +114,11 @@ double4 exp_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float exp_f(const float x) noexcept
+{
+    return ::expf(x);
+}
+
 /* exp(x) - 1 */
 double expm1_d(const double x) noexcept
 {
@@ -110,6 +135,11 @@ double4 expm1_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float expm1_f(const float x) noexcept
+{
+    return ::expm1f(x);
+}
+
 /* Natural logarithm */
 double log_d(const double x) noexcept
 {
@@ -126,6 +156,11 @@ double4 log_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float log_f(const float x) noexcept
+{
+    return ::logf(x);
+}
+
 /* Base-10 logarithm */
 double log10_d(const double x) noexcept
 {
@@ -142,6 +177,11 @@ double4 log10_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float log10_f(const float x) noexcept
+{
+    return ::log10f(x);
+}
+
 /* Base-2 logarithm */
 double log2_d(const double x) noexcept
 {
@@ -158,6 +198,11 @@ double4 log2_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float log2_f(const float x) noexcept
+{
+    return ::log2f(x);
+}
+
 /* log(1 + x) */
 double log1p_d(const double x) noexcept
 {
@@ -174,6 +219,11 @@ double4 log1p_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float log1p_f(const float x) noexcept
+{
+    return ::log1pf(x);
+}
+
 /* Trigonometric functions */
 /* Sine */
 double sin_d(const double x) noexcept
@@ -191,6 +241,11 @@ double4 sin_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float sin_f(const float x) noexcept
+{
+    return ::sinf(x);
+}
+
 /* Cosine */
 double cos_d(const double x) noexcept
 {
@@ -207,6 +262,11 @@ double4 cos_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float cos_f(const float x) noexcept
+{
+    return ::cosf(x);
+}
+
 /* Tangent */
 double tan_d(const double x) noexcept
 {
@@ -223,6 +283,11 @@ double4 tan_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float tan_f(const float x) noexcept
+{
+    return ::tanf(x);
+}
+
 /* Arcsine */
 double asin_d(const double x) noexcept
 {
@@ -239,6 +304,11 @@ double4 asin_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float asin_f(const float x) noexcept
+{
+    return ::asinf(x);
+}
+
 /* Arccosine */
 double acos_d(const double x) noexcept
 {
@@ -255,6 +325,11 @@ double4 acos_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float acos_f(const float x) noexcept
+{
+    return ::acosf(x);
+}
+
 /* Arctangent */
 double atan_d(const double x) noexcept
 {
@@ -271,6 +346,11 @@ double4 atan_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float atan_f(const float x) noexcept
+{
+    return ::atanf(x);
+}
+
 /* Arctangent with two arguments */
 double atan2_d(const double y, const double x) noexcept
 {
@@ -287,6 +367,11 @@ double4 atan2_d4(const double4 y, const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float atan2_f(const float y, const float x) noexcept
+{
+    return ::atan2f(y, x);
+}
+
 /* Hyperbolic functions */
 /* Hyperbolic sine */
 double sinh_d(const double x) noexcept
@@ -304,6 +389,11 @@ double4 sinh_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float sinh_f(const float x) noexcept
+{
+    return ::sinhf(x);
+}
+
 /* Hyperbolic cosine */
 double cosh_d(const double x) noexcept
 {
@@ -320,6 +410,11 @@ double4 cosh_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float cosh_f(const float x) noexcept
+{
+    return ::coshf(x);
+}
+
 /* Hyperbolic tangent */
 double tanh_d(const double x) noexcept
 {
@@ -336,6 +431,11 @@ double4 tanh_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float tanh_f(const float x) noexcept
+{
+    return ::tanhf(x);
+}
+
 /* Inverse hyperbolic sine */
 double asinh_d(const double x) noexcept
 {
@@ -352,6 +452,11 @@ double4 asinh_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float asinh_f(const float x) noexcept
+{
+    return ::asinhf(x);
+}
+
 /* Inverse hyperbolic cosine */
 double acosh_d(const double x) noexcept
 {
@@ -368,6 +473,11 @@ double4 acosh_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float acosh_f(const float x) noexcept
+{
+    return ::acoshf(x);
+}
+
 /* Inverse hyperbolic tangent */
 double atanh_d(const double x) noexcept
 {
@@ -384,6 +494,11 @@ double4 atanh_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float atanh_f(const float x) noexcept
+{
+    return ::atanhf(x);
+}
+
 /* Rounding and modulo */
 /* Floor function */
 double floor_d(const double x) noexcept
@@ -401,6 +516,11 @@ double4 floor_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float floor_f(const float x) noexcept
+{
+    return ::floorf(x);
+}
+
 /* Ceiling function */
 double ceil_d(const double x) noexcept
 {
@@ -417,6 +537,11 @@ double4 ceil_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float ceil_f(const float x) noexcept
+{
+    return ::ceilf(x);
+}
+
 /* Truncate */
 double trunc_d(const double x) noexcept
 {
@@ -433,6 +558,11 @@ double4 trunc_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float trunc_f(const float x) noexcept
+{
+    return ::truncf(x);
+}
+
 /* Round to nearest */
 double round_d(const double x) noexcept
 {
@@ -449,6 +579,11 @@ double4 round_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float round_f(const float x) noexcept
+{
+    return ::roundf(x);
+}
+
 /* Floating-point remainder */
 double fmod_d(const double x, const double y) noexcept
 {
@@ -465,6 +600,11 @@ double4 fmod_d4(const double4 x, const double4 y) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float fmod_f(const float x, const float y) noexcept
+{
+    return ::fmodf(x, y);
+}
+
 /* IEEE remainder */
 double remainder_d(const double x, const double y) noexcept
 {
@@ -481,6 +621,11 @@ double4 remainder_d4(const double4 x, const double4 y) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float remainder_f(const float x, const float y) noexcept
+{
+    return ::remainderf(x, y);
+}
+
 /* Copy sign from y to x */
 double copysign_d(const double x, const double y) noexcept
 {
@@ -497,6 +642,11 @@ double4 copysign_d4(const double4 x, const double4 y) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float copysign_f(const float x, const float y) noexcept
+{
+    return ::copysignf(x, y);
+}
+
 /* Miscellaneous */
 /* Hypotenuse sqrt(x*x + y*y) */
 double hypot_d(const double x, const double y) noexcept
@@ -514,6 +664,11 @@ double4 hypot_d4(const double4 x, const double4 y) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float hypot_f(const float x, const float y) noexcept
+{
+    return ::hypotf(x, y);
+}
+
 /* Convert degrees to radians */
 double radians_d(const double x) noexcept
 {
@@ -530,6 +685,11 @@ double4 radians_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float radians_f(const float x) noexcept
+{
+    return x;
+}
+
 /* Convert radians to degrees */
 double degrees_d(const double x) noexcept
 {
@@ -546,6 +706,11 @@ double4 degrees_d4(const double4 x) noexcept
     MATHEXPR_NOT_IMPLEMENTED;
 }
 
+float degrees_f(const float x) noexcept
+{
+    return x;
+}
+
 /* Function table */
 
 #define REGISTER_FUNCTION(name, base, arity) \
@@ -553,6 +718,7 @@ double4 degrees_d4(const double4 x) noexcept
         reinterpret_cast<void*>(static_cast<Fn##arity##_d>(&base##_d)), \
         reinterpret_cast<void*>(static_cast<Fn##arity##_d2>(&base##_d2)), \
         reinterpret_cast<void*>(static_cast<Fn##arity##_d2>(&base##_d2)), \
+        reinterpret_cast<void*>(static_cast<Fn##arity##_f>(&base##_f)), \
         arity \
     } }
 
@@ -8,7 +8,7 @@
 
 MATHEXPR_NAMESPACE_BEGIN
 
-bool relocate(ByteCode& bytecode, const Relocations& relocations) noexcept
+bool relocate(ByteCode& bytecode, const Relocations& relocations, uint32_t value_type) noexcept
 {
     for(const auto& relocation : relocations)
     {
@@ -27,7 +27,8 @@ bool relocate(ByteCode& bytecode, const Relocations& relocations) noexcept
         }
 
         /* TODO: modify when using simd to get the right ptr */
-        uint64_t addr = reinterpret_cast<uint64_t>(entry->scalar_ptr);
+        uint64_t addr = reinterpret_cast<uint64_t>(value_type == ValueType_Float32 ? entry->scalar_float_ptr :
+                                                                                   entry->scalar_ptr);
 
         log_debug("Relocating symbol: \"{}\" (0x{:016x})", relocation.symbol_name, addr);
 
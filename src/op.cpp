@@ -12,6 +12,10 @@ const char* op_unary_to_string(const uint32_t type) noexcept
     {
         case UnaryOpType_Neg:
             return "-";
+        case UnaryOpType_MaskToBool:
+            return "bool ";
+        case UnaryOpType_Sqrt:
+            return "sqrt ";
         default:
             return "?";
     }
@@ -39,6 +43,26 @@ const char* op_binary_to_string(const uint32_t type) noexcept
             return "*";
         case BinaryOpType_Div: 
             return "/";
+        case BinaryOpType_Pow: 
+            return "^";
+        case BinaryOpType_Eq:
+            return "==";
+        case BinaryOpType_Neq:
+            return "!=";
+        case BinaryOpType_Lt:
+            return "<";
+        case BinaryOpType_Le:
+            return "<=";
+        case BinaryOpType_Gt:
+            return ">";
+        case BinaryOpType_Ge:
+            return ">=";
+        case BinaryOpType_And:
+            return "&";
+        case BinaryOpType_AndNot:
+            return "&~";
+        case BinaryOpType_Or:
+            return "|";
         default:
             return "?";
     }
@@ -66,6 +90,41 @@ uint32_t op_binary_from_string(const std::string_view& data) noexcept
         return BinaryOpType_Div;
     }
 
+    if(data == "^") 
+    {
+        return BinaryOpType_Pow;
+    }
+
+    if(data == "==") 
+    {
+        return BinaryOpType_Eq;
+    }
+
+    if(data == "!=") 
+    {
+        return BinaryOpType_Neq;
+    }
+
+    if(data == "<") 
+    {
+        return BinaryOpType_Lt;
+    }
+
+    if(data == "<=") 
+    {
+        return BinaryOpType_Le;
+    }
+
+    if(data == ">") 
+    {
+        return BinaryOpType_Gt;
+    }
+
+    if(data == ">=") 
+    {
+        return BinaryOpType_Ge;
+    }
+
     return static_cast<uint32_t>(BinaryOpType_Unknown);
 }
 
@@ -75,6 +134,41 @@ bool op_binary_is_commutative(const uint32_t type) noexcept
     {
         case BinaryOpType_Add:
         case BinaryOpType_Mul:
+        case BinaryOpType_Eq:
+        case BinaryOpType_Neq:
+        case BinaryOpType_And:
+        case BinaryOpType_Or:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool op_binary_is_comparison(const uint32_t type) noexcept
+{
+    switch(type)
+    {
+        case BinaryOpType_Eq:
+        case BinaryOpType_Neq:
+        case BinaryOpType_Lt:
+        case BinaryOpType_Le:
+        case BinaryOpType_Gt:
+        case BinaryOpType_Ge:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool op_binary_is_bitwise(const uint32_t type) noexcept
+{
+    switch(type)
+    {
+        case BinaryOpType_And:
+        case BinaryOpType_AndNot:
+        case BinaryOpType_Or:
             return true;
 
         default:
@@ -0,0 +1,856 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/ssa.hpp"
+#include "mathexpr/op.hpp"
+#include "mathexpr/log.hpp"
+
+#include <algorithm>
+#include <functional>
+
+MATHEXPR_NAMESPACE_BEGIN
+
+/*
+    Single pass front end, for the expressions that don't need their AST. The source is scanned one
+    token ahead of the parser, and the parser emits the SSA statements as soon as it reduces an
+    operation. It parses the same grammar as the AST parser (see ast.cpp), with precedence climbing
+    for the binary operators:
+
+    precedence  operators           associativity
+    1           < <= > >= == !=     left
+    2           + -                 left
+    3           * /                 left
+    4           ^                   right
+
+    Unary minus binds looser than ^ and tighter than the other operators, as in the AST parser
+    (-x ^ 2 is -(x ^ 2), x ^ -y is x ^ (-y)).
+
+    Literals and comparisons are only emitted once we know how they are used, so x ^ 3 is
+    specialized without emitting 3, -2 is folded in a single literal and a comparison used as the
+    condition of a select gives its mask directly instead of going through MaskToBool. Let-bindings
+    are emitted where they are bound, the statements nothing depends on (unused bindings, the base
+    of x ^ 0) are removed once the whole expression has been parsed
+*/
+
+namespace {
+
+struct SourceToken
+{
+    std::string_view data;
+    uint32_t type;
+    uint32_t op; /* BinaryOpType of the operators */
+};
+
+enum ParsedValueType : uint32_t
+{
+    ParsedValueType_Invalid,
+    ParsedValueType_Statement,
+    ParsedValueType_Literal,
+    ParsedValueType_Comparison,
+};
+
+/* Value of a parsed subexpression, literals and comparisons are not emitted yet */
+struct ParsedValue
+{
+    uint32_t type = ParsedValueType_Invalid;
+
+    /* Statement: its index. Comparison: the compared statements, op being the lowered comparison */
+    uint32_t stmt = INVALID_STMT_INDEX;
+    uint32_t right = INVALID_STMT_INDEX;
+    uint32_t op = BinaryOpType_Unknown;
+
+    /* Literal: its value and its name, which always spans the source */
+    double literal = 0.0;
+    std::string_view name;
+
+    bool valid() const noexcept { return this->type != ParsedValueType_Invalid; }
+
+    static ParsedValue statement(uint32_t stmt) noexcept
+    {
+        ParsedValue value;
+        value.type = stmt == INVALID_STMT_INDEX ? ParsedValueType_Invalid : ParsedValueType_Statement;
+        value.stmt = stmt;
+        return value;
+    }
+};
+
+struct ParsedBinding
+{
+    std::string_view name;
+    ParsedValue value;
+};
+
+MATHEXPR_FORCE_INLINE uint32_t get_operator_precedence(uint32_t op) noexcept
+{
+    switch(op)
+    {
+        case BinaryOpType_Pow:
+            return 4;
+        case BinaryOpType_Mul:
+        case BinaryOpType_Div:
+            return 3;
+        case BinaryOpType_Add:
+        case BinaryOpType_Sub:
+            return 2;
+        default:
+            return op_binary_is_comparison(op) ? 1 : 0;
+    }
+}
+
+class SourceParser
+{
+    std::function<uint32_t(const SSAStmt&)> _emit;
+    std::function<uint32_t(uint32_t, double)> _emit_power;
+
+    SSA& _ssa;
+
+    SymbolTable& _symtable;
+
+    const char* _cursor;
+    const char* _end;
+
+    SourceToken _current;
+    SourceToken _next;
+
+    std::vector<ParsedBinding> _bindings;
+
+    std::string _error;
+
+    /* Only the first error is kept, the following ones are consequences of it */
+    template<typename... Args>
+    void error(std::format_string<Args...> format, Args&&... args) noexcept
+    {
+        if(this->_error.empty())
+        {
+            this->_error = std::vformat(format.get(), std::make_format_args(args...));
+        }
+    }
+
+    /* Lexing */
+
+    MATHEXPR_FORCE_INLINE SourceToken make_token(const char* start, uint32_t type, uint32_t op = BinaryOpType_Unknown) noexcept
+    {
+        return { std::string_view(start, this->_cursor - start), type, op };
+    }
+
+    /* Characters that don't start a token are skipped, like the lexer does */
+    SourceToken scan() noexcept
+    {
+        while(this->_cursor < this->_end)
+        {
+            const char* start = this->_cursor;
+            const char c = *this->_cursor++;
+
+            if(lexer_char_is(c, LexerCharClass_Digit))
+            {
+                bool well_formed;
+                this->_cursor = start + lexer_consume_literal(std::string_view(start, this->_end - start), well_formed);
+
+                if(!well_formed)
+                {
+                    this->error("Ill-formed literal: {}", std::string_view(start, this->_cursor - start));
+                    return this->make_token(start, LexerTokenType::Empty);
+                }
+
+                return this->make_token(start, LexerTokenType::Literal);
+            }
+
+            if(lexer_char_is(c, LexerCharClass_Alpha))
+            {
+                while(this->_cursor < this->_end && lexer_char_is(*this->_cursor, LexerCharClass_SymbolTail))
+                {
+                    this->_cursor++;
+                }
+
+                return this->make_token(start, LexerTokenType::Symbol);
+            }
+
+            const bool followed_by_equal = this->_cursor < this->_end && *this->_cursor == '=';
+
+            switch(c)
+            {
+                case '+':
+                    return this->make_token(start, LexerTokenType::Operator, BinaryOpType_Add);
+                case '-':
+                    return this->make_token(start, LexerTokenType::Operator, BinaryOpType_Sub);
+                case '*':
+                    return this->make_token(start, LexerTokenType::Operator, BinaryOpType_Mul);
+                case '/':
+                    return this->make_token(start, LexerTokenType::Operator, BinaryOpType_Div);
+                case '^':
+                    return this->make_token(start, LexerTokenType::Operator, BinaryOpType_Pow);
+                case '<':
+                    this->_cursor += followed_by_equal;
+                    return this->make_token(start,
+                                            LexerTokenType::Operator,
+                                            followed_by_equal ? BinaryOpType_Le : BinaryOpType_Lt);
+                case '>':
+                    this->_cursor += followed_by_equal;
+                    return this->make_token(start,
+                                            LexerTokenType::Operator,
+                                            followed_by_equal ? BinaryOpType_Ge : BinaryOpType_Gt);
+                case '=':
+                    this->_cursor += followed_by_equal;
+                    return followed_by_equal ? this->make_token(start, LexerTokenType::Operator, BinaryOpType_Eq) :
+                                               this->make_token(start, LexerTokenType::Assign);
+                case '!':
+                    if(!followed_by_equal)
+                    {
+                        break;
+                    }
+
+                    this->_cursor++;
+                    return this->make_token(start, LexerTokenType::Operator, BinaryOpType_Neq);
+                case '(':
+                    return this->make_token(start, LexerTokenType::LParen);
+                case ')':
+                    return this->make_token(start, LexerTokenType::RParen);
+                case ',':
+                    return this->make_token(start, LexerTokenType::Comma);
+                case ';':
+                    return this->make_token(start, LexerTokenType::Semicolon);
+                case '?':
+                    return this->make_token(start, LexerTokenType::Question);
+                case ':':
+                    return this->make_token(start, LexerTokenType::Colon);
+                default:
+                    break;
+            }
+        }
+
+        return { std::string_view(this->_end, 0), LexerTokenType::EndOfFile, BinaryOpType_Unknown };
+    }
+
+    MATHEXPR_FORCE_INLINE void advance() noexcept
+    {
+        this->_current = this->_next;
+        this->_next = this->scan();
+    }
+
+    bool expect(uint32_t type, std::string_view what) noexcept
+    {
+        if(this->_current.type != type)
+        {
+            this->error("Expected \"{}\", found \"{}\"", what, lexer_token_type_to_string(this->_current.type));
+            return false;
+        }
+
+        this->advance();
+
+        return true;
+    }
+
+    /* Emission */
+
+    uint32_t emit_literal(std::string_view name, double value) noexcept
+    {
+        this->_symtable.add_literal(name, value);
+
+        return this->_emit({ SSAStmtTypeId_Literal, this->_ssa.add_name(name), 0, 0, 0 });
+    }
+
+    uint32_t emit_binop(uint32_t op, uint32_t left, uint32_t right) noexcept
+    {
+        return this->_emit({ SSAStmtTypeId_BinOp, op, left, right, 0 });
+    }
+
+    uint32_t emit_call(std::string_view name, const uint32_t* arguments, size_t num_arguments) noexcept
+    {
+        SSAStmt call = { SSAStmtTypeId_FuncOp, this->_ssa.add_name(name), INVALID_STMT_INDEX, INVALID_STMT_INDEX, INVALID_STMT_INDEX };
+
+        std::copy(arguments, arguments + num_arguments, call.get_arguments());
+
+        return this->_emit(call);
+    }
+
+    /* Emits the value if it has not been yet, comparisons used as values become 1.0 or 0.0 */
+    uint32_t materialize(const ParsedValue& value) noexcept
+    {
+        switch(value.type)
+        {
+            case ParsedValueType_Literal:
+                return this->emit_literal(value.name, value.literal);
+            case ParsedValueType_Comparison:
+                return this->_emit({ SSAStmtTypeId_UnOp,
+                                     UnaryOpType_MaskToBool,
+                                     this->emit_binop(value.op, value.stmt, value.right),
+                                     0,
+                                     0 });
+            default:
+                return value.stmt;
+        }
+    }
+
+    /* Conditions that are not comparisons are compared against zero, as in C */
+    uint32_t materialize_mask(const ParsedValue& condition) noexcept
+    {
+        if(condition.type == ParsedValueType_Comparison)
+        {
+            return this->emit_binop(condition.op, condition.stmt, condition.right);
+        }
+
+        const uint32_t value = this->materialize(condition);
+
+        return this->emit_binop(BinaryOpType_Neq, value, this->emit_literal("$0.0", 0.0));
+    }
+
+    /* Branchless, (mask & if_true) | (~mask & if_false) */
+    ParsedValue select(const ParsedValue& condition, const ParsedValue& if_true, const ParsedValue& if_false) noexcept
+    {
+        const uint32_t mask = this->materialize_mask(condition);
+        const uint32_t true_value = this->materialize(if_true);
+        const uint32_t false_value = this->materialize(if_false);
+
+        return ParsedValue::statement(this->emit_binop(BinaryOpType_Or,
+                                                       this->emit_binop(BinaryOpType_And, mask, true_value),
+                                                       this->emit_binop(BinaryOpType_AndNot, mask, false_value)));
+    }
+
+    uint32_t positive_power(uint32_t base, const ParsedValue& exponent) noexcept
+    {
+        if(can_specialize_power(exponent.literal))
+        {
+            return this->_emit_power(base, exponent.literal);
+        }
+
+        const uint32_t arguments[2] = { base, this->materialize(exponent) };
+
+        return this->emit_call(POW_FUNCTION_NAME, arguments, 2);
+    }
+
+    /* x ^ -n is 1 / x ^ n and x ^ 0 is 1, as in the AST parser */
+    ParsedValue power(const ParsedValue& base, const ParsedValue& exponent) noexcept
+    {
+        const uint32_t base_value = this->materialize(base);
+
+        if(exponent.type != ParsedValueType_Literal)
+        {
+            const uint32_t arguments[2] = { base_value, this->materialize(exponent) };
+
+            return ParsedValue::statement(this->emit_call(POW_FUNCTION_NAME, arguments, 2));
+        }
+
+        if(exponent.literal > 0.0)
+        {
+            return ParsedValue::statement(this->positive_power(base_value, exponent));
+        }
+
+        const uint32_t one = this->emit_literal("$1.0", 1.0);
+
+        if(exponent.literal == 0.0)
+        {
+            return ParsedValue::statement(one);
+        }
+
+        ParsedValue positive_exponent = exponent;
+        positive_exponent.literal = -exponent.literal;
+        positive_exponent.name = exponent.name.substr(1);
+
+        return ParsedValue::statement(this->emit_binop(BinaryOpType_Div,
+                                                       one,
+                                                       this->positive_power(base_value, positive_exponent)));
+    }
+
+    ParsedValue binary(uint32_t op, const ParsedValue& left, const ParsedValue& right) noexcept
+    {
+        if(op == BinaryOpType_Pow)
+        {
+            return this->power(left, right);
+        }
+
+        const uint32_t left_value = this->materialize(left);
+        const uint32_t right_value = this->materialize(right);
+
+        if(!op_binary_is_comparison(op))
+        {
+            return ParsedValue::statement(this->emit_binop(op, left_value, right_value));
+        }
+
+        /* x86_64 can only compare for (in)equality and less than, a > b is lowered as b < a */
+        ParsedValue comparison;
+        comparison.type = ParsedValueType_Comparison;
+
+        switch(op)
+        {
+            case BinaryOpType_Gt:
+                comparison.op = BinaryOpType_Lt;
+                comparison.stmt = right_value;
+                comparison.right = left_value;
+                break;
+            case BinaryOpType_Ge:
+                comparison.op = BinaryOpType_Le;
+                comparison.stmt = right_value;
+                comparison.right = left_value;
+                break;
+            default:
+                comparison.op = op;
+                comparison.stmt = left_value;
+                comparison.right = right_value;
+                break;
+        }
+
+        return comparison;
+    }
+
+    /* Parsing */
+
+    ParsedValue parse_call(std::string_view name) noexcept
+    {
+        this->advance();
+        this->advance();
+
+        ParsedValue arguments[SSA_MAX_FUNCTION_ARGUMENTS];
+        size_t num_arguments = 0;
+
+        if(this->_current.type != LexerTokenType::RParen)
+        {
+            do
+            {
+                if(num_arguments > 0)
+                {
+                    this->advance();
+                }
+
+                const ParsedValue argument = this->parse_expression();
+
+                if(!argument.valid())
+                {
+                    return ParsedValue();
+                }
+
+                if(num_arguments < SSA_MAX_FUNCTION_ARGUMENTS)
+                {
+                    arguments[num_arguments] = argument;
+                }
+
+                num_arguments++;
+            }
+            while(this->_current.type == LexerTokenType::Comma);
+        }
+
+        if(!this->expect(LexerTokenType::RParen, ")"))
+        {
+            return ParsedValue();
+        }
+
+        if(name == SELECT_FUNCTION_NAME)
+        {
+            if(num_arguments != 3)
+            {
+                this->error("select expects 3 arguments (condition, if true, if false), got {}", num_arguments);
+                return ParsedValue();
+            }
+
+            return this->select(arguments[0], arguments[1], arguments[2]);
+        }
+
+        if(num_arguments > SSA_MAX_FUNCTION_ARGUMENTS)
+        {
+            this->error("Function \"{}\" is called with {} arguments, at most {} are supported",
+                        name,
+                        num_arguments,
+                        SSA_MAX_FUNCTION_ARGUMENTS);
+
+            return ParsedValue();
+        }
+
+        uint32_t values[SSA_MAX_FUNCTION_ARGUMENTS];
+
+        for(size_t i = 0; i < num_arguments; i++)
+        {
+            values[i] = this->materialize(arguments[i]);
+        }
+
+        this->_symtable.add_function_call(name);
+
+        return ParsedValue::statement(this->emit_call(name, values, num_arguments));
+    }
+
+    ParsedValue parse_factor() noexcept
+    {
+        switch(this->_current.type)
+        {
+            case LexerTokenType::Literal:
+            {
+                const std::string_view lit = this->_current.data;
+
+                ParsedValue literal;
+                literal.type = ParsedValueType_Literal;
+                literal.name = lit;
+
+                if(!lexer_parse_literal(lit, literal.literal))
+                {
+                    this->error("Cannot represent literal: {}", lit);
+                    return ParsedValue();
+                }
+
+                this->advance();
+
+                return literal;
+            }
+            case LexerTokenType::Symbol:
+            {
+                const std::string_view name = this->_current.data;
+
+                if(this->_next.type == LexerTokenType::LParen)
+                {
+                    return this->parse_call(name);
+                }
+
+                this->advance();
+
+                /* The latest binding wins, so a name can be rebound from its previous value */
+                auto binding = std::find_if(this->_bindings.rbegin(),
+                                            this->_bindings.rend(),
+                                            [&](const ParsedBinding& b) { return b.name == name; });
+
+                /* Bound literals are not folded nor specialized, their name doesn't span the reference */
+                if(binding != this->_bindings.rend())
+                {
+                    return binding->value.type == ParsedValueType_Literal ?
+                               ParsedValue::statement(this->materialize(binding->value)) :
+                               binding->value;
+                }
+
+                this->_symtable.add_variable(name);
+
+                return ParsedValue::statement(this->_emit({ SSAStmtTypeId_Variable,
+                                                            this->_ssa.add_name(name),
+                                                            INVALID_STMT_ROW,
+                                                            0,
+                                                            0 }));
+            }
+            case LexerTokenType::LParen:
+            {
+                this->advance();
+
+                const ParsedValue expr = this->parse_expression();
+
+                if(!expr.valid() || !this->expect(LexerTokenType::RParen, ")"))
+                {
+                    return ParsedValue();
+                }
+
+                return expr;
+            }
+            case LexerTokenType::Operator:
+            {
+                if(this->_current.op != BinaryOpType_Sub)
+                {
+                    this->error("Unexpected operator \"{}\" found when parsing unary op", this->_current.data);
+                    return ParsedValue();
+                }
+
+                const std::string_view minus = this->_current.data;
+
+                this->advance();
+
+                /* Negative literals are folded, their name spans the minus sign and the literal */
+                if(this->_current.type == LexerTokenType::Literal && this->_next.op != BinaryOpType_Pow)
+                {
+                    ParsedValue literal = this->parse_factor();
+
+                    if(literal.valid())
+                    {
+                        literal.literal = -literal.literal;
+                        literal.name = std::string_view(minus.data(),
+                                                        literal.name.data() + literal.name.size() - minus.data());
+                    }
+
+                    return literal;
+                }
+
+                /* Negates the whole power, -x ^ 2 is -(x ^ 2) */
+                const ParsedValue operand = this->parse_binary(get_operator_precedence(BinaryOpType_Pow));
+
+                if(!operand.valid())
+                {
+                    return ParsedValue();
+                }
+
+                return ParsedValue::statement(this->_emit({ SSAStmtTypeId_UnOp,
+                                                            UnaryOpType_Neg,
+                                                            this->materialize(operand),
+                                                            0,
+                                                            0 }));
+            }
+            default:
+            {
+                this->error("Unexpected token \"{}\" found when parsing factor",
+                            lexer_token_type_to_string(this->_current.type));
+
+                return ParsedValue();
+            }
+        }
+    }
+
+    ParsedValue parse_binary(uint32_t min_precedence) noexcept
+    {
+        ParsedValue left = this->parse_factor();
+
+        while(left.valid() && this->_current.type == LexerTokenType::Operator)
+        {
+            const uint32_t op = this->_current.op;
+            const uint32_t precedence = get_operator_precedence(op);
+
+            if(precedence < min_precedence)
+            {
+                break;
+            }
+
+            this->advance();
+
+            /* Right associative, x ^ y ^ z is x ^ (y ^ z) */
+            const ParsedValue right = this->parse_binary(op == BinaryOpType_Pow ? precedence : precedence + 1);
+
+            if(!right.valid())
+            {
+                return ParsedValue();
+            }
+
+            left = this->binary(op, left, right);
+        }
+
+        return left;
+    }
+
+    ParsedValue parse_expression() noexcept
+    {
+        const ParsedValue condition = this->parse_binary(1);
+
+        if(!condition.valid() || this->_current.type != LexerTokenType::Question)
+        {
+            return condition;
+        }
+
+        this->advance();
+
+        const ParsedValue if_true = this->parse_expression();
+
+        if(!if_true.valid())
+        {
+            return ParsedValue();
+        }
+
+        if(this->_current.type != LexerTokenType::Colon)
+        {
+            this->error("Expected \":\" in ternary expression, found \"{}\"",
+                        lexer_token_type_to_string(this->_current.type));
+
+            return ParsedValue();
+        }
+
+        this->advance();
+
+        const ParsedValue if_false = this->parse_expression();
+
+        if(!if_false.valid())
+        {
+            return ParsedValue();
+        }
+
+        return this->select(condition, if_true, if_false);
+    }
+
+public:
+    SourceParser(std::string_view expression,
+                 std::function<uint32_t(const SSAStmt&)> emit,
+                 std::function<uint32_t(uint32_t, double)> emit_power,
+                 SSA& ssa,
+                 SymbolTable& symtable) : _emit(std::move(emit)),
+                                          _emit_power(std::move(emit_power)),
+                                          _ssa(ssa),
+                                          _symtable(symtable),
+                                          _cursor(expression.data()),
+                                          _end(expression.data() + expression.size())
+    {
+        this->_current = this->scan();
+        this->_next = this->scan();
+    }
+
+    const std::string& get_error() const noexcept { return this->_error; }
+
+    /* Returns the statement holding the result of the expression */
+    uint32_t parse_program() noexcept
+    {
+        while(this->_current.type == LexerTokenType::Symbol &&
+              this->_next.type == LexerTokenType::Assign)
+        {
+            const std::string_view name = this->_current.data;
+
+            this->advance();
+            this->advance();
+
+            const ParsedValue value = this->parse_expression();
+
+            if(!value.valid())
+            {
+                return INVALID_STMT_INDEX;
+            }
+
+            if(this->_current.type != LexerTokenType::Semicolon)
+            {
+                this->error("Expected \";\" after the binding of \"{}\", found \"{}\"",
+                            name,
+                            lexer_token_type_to_string(this->_current.type));
+
+                return INVALID_STMT_INDEX;
+            }
+
+            this->advance();
+
+            this->_bindings.emplace_back(name, value);
+        }
+
+        const ParsedValue expr = this->parse_expression();
+
+        if(!expr.valid())
+        {
+            return INVALID_STMT_INDEX;
+        }
+
+        if(this->_current.type == LexerTokenType::Semicolon)
+        {
+            this->advance();
+        }
+
+        if(this->_current.type != LexerTokenType::EndOfFile)
+        {
+            this->error("Unexpected token \"{}\" found after the end of the expression", this->_current.data);
+            return INVALID_STMT_INDEX;
+        }
+
+        return this->materialize(expr);
+    }
+};
+
+/* Drops the statements the result doesn't depend on, returns the new index of the result */
+uint32_t remove_unused_statements(std::vector<SSAStmt>& statements, uint32_t result) noexcept
+{
+    /* Used statements are marked with 0 until they are renumbered */
+    std::vector<uint32_t> indices(result + 1, INVALID_STMT_INDEX);
+
+    indices[result] = 0;
+
+    for(uint32_t i = result + 1; i-- > 0;)
+    {
+        const SSAStmt& stmt = statements[i];
+
+        if(indices[i] == INVALID_STMT_INDEX)
+        {
+            continue;
+        }
+
+        switch(stmt.type)
+        {
+            case SSAStmtTypeId_UnOp:
+                indices[stmt.a] = 0;
+                break;
+            case SSAStmtTypeId_BinOp:
+                indices[stmt.a] = 0;
+                indices[stmt.b] = 0;
+                break;
+            case SSAStmtTypeId_FuncOp:
+                for(size_t j = 0; j < stmt.get_num_arguments(); j++)
+                {
+                    indices[stmt.get_arguments()[j]] = 0;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint32_t num_statements = 0;
+
+    for(uint32_t i = 0; i <= result; i++)
+    {
+        if(indices[i] == INVALID_STMT_INDEX)
+        {
+            continue;
+        }
+
+        SSAStmt stmt = statements[i];
+
+        switch(stmt.type)
+        {
+            case SSAStmtTypeId_UnOp:
+                stmt.a = indices[stmt.a];
+                break;
+            case SSAStmtTypeId_BinOp:
+                stmt.a = indices[stmt.a];
+                stmt.b = indices[stmt.b];
+                break;
+            case SSAStmtTypeId_FuncOp:
+                for(size_t j = 0; j < stmt.get_num_arguments(); j++)
+                {
+                    stmt.get_arguments()[j] = indices[stmt.get_arguments()[j]];
+                }
+                break;
+            default:
+                break;
+        }
+
+        statements[num_statements] = stmt;
+        indices[i] = num_statements++;
+    }
+
+    statements.resize(num_statements);
+
+    return num_statements - 1;
+}
+
+} /* namespace */
+
+bool SSA::build_from_source(std::string_view expression, SymbolTable& symtable) noexcept
+{
+    this->clear();
+
+    SSAValueTable values;
+
+    SourceParser parser(expression,
+                        [&](const SSAStmt& stmt) -> uint32_t { return this->add_statement(stmt, values); },
+                        [&](uint32_t base, double exponent) -> uint32_t { return this->add_power(base, exponent, values); },
+                        *this,
+                        symtable);
+
+    const uint32_t result = parser.parse_program();
+
+    if(result == INVALID_STMT_INDEX)
+    {
+        if(!parser.get_error().empty())
+        {
+            log_error("{}", parser.get_error());
+        }
+
+        return false;
+    }
+
+    /* The result of a single expression is its last statement */
+    const size_t num_statements = this->_statements.size();
+
+    remove_unused_statements(this->_statements, result);
+
+    /* Symbols only used by the removed statements are not part of the layout, as in the AST path */
+    if(this->_statements.size() != num_statements)
+    {
+        std::unordered_set<std::string_view> used_names;
+
+        for(const SSAStmt& stmt : this->_statements)
+        {
+            if(stmt.type == SSAStmtTypeId_Variable || stmt.type == SSAStmtTypeId_Literal)
+            {
+                used_names.insert(this->get_name(stmt.op));
+            }
+        }
+
+        symtable.remove_unused_symbols(used_names);
+    }
+
+    this->calculate_live_ranges();
+
+    return true;
+}
+
+MATHEXPR_NAMESPACE_END
@@ -8,17 +8,74 @@
 
 #include <ranges>
 #include <algorithm>
+#include <numeric>
 #include <cstring>
-#include <unordered_set>
 
 MATHEXPR_NAMESPACE_BEGIN
 
+/*
+    Spills are addressed relative to rsp by default, so functions with spills don't need to set up
+    an rbp frame. Building with KEEP_FRAME_POINTER=1 keeps the frames, for profilers and debuggers
+*/
+#if defined(MATHEXPR_KEEP_FRAME_POINTER)
+static constexpr bool KEEP_FRAME_POINTER = true;
+#else
+static constexpr bool KEEP_FRAME_POINTER = false;
+#endif
+
+bool memloc_equals(const MemLoc* a, const MemLoc* b) noexcept
+{
+    if(a == nullptr || b == nullptr || a->type_id() != b->type_id())
+    {
+        return false;
+    }
+
+    switch(a->type_id())
+    {
+        case MemLocTypeId_Register:
+            return static_cast<const Register*>(a)->get_id() == static_cast<const Register*>(b)->get_id();
+
+        case MemLocTypeId_Stack:
+        {
+            auto stack_a = static_cast<const Stack*>(a);
+            auto stack_b = static_cast<const Stack*>(b);
+
+            return stack_a->get_base_ptr_register() == stack_b->get_base_ptr_register() &&
+                   stack_a->get_offset() == stack_b->get_offset();
+        }
+
+        case MemLocTypeId_Memory:
+        {
+            auto mem_a = static_cast<const Memory*>(a);
+            auto mem_b = static_cast<const Memory*>(b);
+
+            return mem_a->get_base_ptr_register() == mem_b->get_base_ptr_register() &&
+                   mem_a->get_offset() == mem_b->get_offset();
+        }
+
+        case MemLocTypeId_Constant:
+            return static_cast<const Constant*>(a)->get_offset() == static_cast<const Constant*>(b)->get_offset();
+
+        case MemLocTypeId_Column:
+        {
+            auto column_a = static_cast<const Column*>(a);
+            auto column_b = static_cast<const Column*>(b);
+
+            return column_a->get_base_ptr_register() == column_b->get_base_ptr_register() &&
+                   column_a->get_pointer_offset() == column_b->get_pointer_offset() &&
+                   column_a->get_element_offset() == column_b->get_element_offset();
+        }
+    }
+
+    return false;
+}
+
 /* Register allocation on SSA */
 
 /*
     Since we don't have phi-nodes in our SSA form, register allocation is trivial and can be performed
-    with a linear scan (with constraints). Since we only support floating point operations, we only
-    allocate in fp registers (xmm[i])
+    with a single linear scan (with constraints). Since we only support floating point operations, we
+    only allocate in fp registers (xmm[i])
 
     For Linux x86_64, we can use xmm0-xmm7
     For Windows x86_64, we can use xmm0-xmm5
@@ -147,661 +204,971 @@ public:
     }
 };
 
-/* Utilities */
+/* Optimization passes for better register allocation */
 
-/* Should return a valid register if we can reuse a register to store the result */
-const MemLocPtr RegisterAllocator::get_reusable_register(const SSAStmtPtr& statement) const noexcept
+/*
+    This pass swaps operands of commutative binary ops if the right operand can be loaded from the
+    stack or constant-memory (i.e a literal, a variable, a spilled temporary)
+*/
+bool RegisterAllocator::prepass_commutative_operand_swap(SSA& ssa) noexcept
 {
-    /* Assume that for now, except x86_64, all targets use three-address form (aarch64, nvptx...) */
-    if(this->_platform_abi->get_target_isa() != ISA_x86_64)
-    {
-        return nullptr;
-    }
+    std::vector<SSAStmt>& statements = ssa.get_statements();
 
-    switch(statement->type_id())
+    for(SSAStmt& stmt : statements)
     {
-        case SSAStmtTypeId_Variable:
-        case SSAStmtTypeId_Literal:
+        if(stmt.type != SSAStmtTypeId_BinOp || !op_binary_is_commutative(stmt.op))
         {
-            auto it = this->_mapping.find(statement);
-
-            return it == this->_mapping.end() ? nullptr : it->second;
+            continue;
         }
-        case SSAStmtTypeId_UnOp:
-        {
-            auto unop = statement_const_cast<SSAStmtUnOp>(statement.get());
 
-            auto it = this->_mapping.find(unop->get_operand());
+        auto swap_if = [&](uint32_t type) {
+            if(statements[stmt.a].type == type && statements[stmt.b].type != type)
+            {
+                std::swap(stmt.a, stmt.b);
+            }
+        };
+
+        /* Spills don't exist yet, they are inserted during the allocation */
+        swap_if(SSAStmtTypeId_Literal);
+        swap_if(SSAStmtTypeId_Variable);
+    }
+
+    return true;
+}
+
+/* Register allocation */
+
+/*
+    Single-pass linear scan. Statements are visited once, in order: a value gets a register when it
+    is defined (or reloaded) and gives it back after its last use. When no register is free, the
+    active value whose next use is the furthest away is evicted (Belady's heuristic). It is stored
+    once in a stack slot and reloaded right before its next use, which splits its live interval in
+    two. Spills and loads are emitted during the sweep itself, so the allocation never restarts.
+
+    Variables and literals are rematerializable: they live at fixed offsets from the variables base
+    pointer and in the constant pool, so evicting them only drops the register and they are reloaded
+    from (or used directly as a memory operand at) their home location, without any stack traffic.
+
+    Constraints are handled with hints (the return value and function arguments have a preferred
+    register, propagated down the left operands) and fixed up with moves when a hint can't be
+    honored.
+*/
+
+static constexpr uint64_t NO_NEXT_USE = std::numeric_limits<uint64_t>::max();
+static constexpr uint32_t NO_VALUE = std::numeric_limits<uint32_t>::max();
 
-            return it == this->_mapping.end() ? nullptr : it->second;
+template<typename F>
+void for_each_operand(const SSAStmt& stmt, F&& func) noexcept
+{
+    switch(stmt.type)
+    {
+        case SSAStmtTypeId_UnOp:
+        case SSAStmtTypeId_StoreOp:
+        {
+            func(stmt.a);
+            break;
         }
+
         case SSAStmtTypeId_BinOp:
         {
-            auto binop = statement_const_cast<SSAStmtBinOp>(statement.get());
-
-            auto it = this->_mapping.find(binop->get_left());
+            func(stmt.a);
+            func(stmt.b);
 
-            return it == this->_mapping.end() ? nullptr : it->second;
+            break;
         }
+
         case SSAStmtTypeId_FuncOp:
         {
-            auto funcop = statement_const_cast<SSAStmtFunctionOp>(statement.get());
-
-            if(funcop->get_arguments().size() == 0)
+            for(size_t i = 0; i < stmt.get_num_arguments(); i++)
             {
-                return nullptr;
+                func(stmt.get_arguments()[i]);
             }
 
-            auto it = this->_mapping.find(funcop->get_arguments()[0]);
-
-            return it == this->_mapping.end() ? nullptr : it->second;
+            break;
         }
-
-        default:
-            return nullptr;
     }
 }
 
-/* Optimization passes for better register allocation */
+/* Single expressions return their last statement, groups end with the stores of their outputs */
+bool has_return_value(const std::vector<SSAStmt>& statements) noexcept
+{
+    return statements.back().type != SSAStmtTypeId_StoreOp;
+}
 
 /*
-    This pass swaps operands of commutative binary ops if the right operand can be loaded from the
-    stack or constant-memory (i.e a literal, a variable, a spilled temporary)
+    Values are identified by the index of the statement defining them in the SSA being allocated.
+    The statements are rewritten to a new array, with spills and loads, where operands are the
+    indices of the rewritten statements holding their values
 */
-bool RegisterAllocator::prepass_commutative_operand_swap(SSA& ssa) noexcept
+class LinearScan
 {
-    for(auto& stmt : ssa.get_statements())
-    {
-        switch(stmt->type_id())
-        {
-            case SSAStmtTypeId_BinOp:
-            {
-                auto binop = statement_cast<SSAStmtBinOp>(stmt.get());
+    PlatformABIPtr _platform_abi;
+    const SymbolTable& _symtable;
+    std::vector<MemLocPtr>& _mapping;
 
-                if(binop == nullptr)
-                {
-                    log_error("Error during commutative operand swap opt pass. Expected binop, got: {}",
-                              stmt->type_id());
-                    return false;
-                }
+    const SSA* _ssa;
 
-                if(!op_binary_is_commutative(binop->get_op()))
-                {
-                    break;
-                }
+    /* Rewritten statements, with spills and loads */
+    std::vector<SSAStmt> _statements;
 
-                auto& left = binop->get_left();
-                auto& right = binop->get_right();
+    /* Per value, indexed by the index of the statement defining it */
+    std::vector<std::vector<uint32_t>> _uses;
+    std::vector<uint32_t> _use_cursors;
+    std::vector<uint32_t> _definitions; /* rewritten statement defining the value */
+    std::vector<uint32_t> _current;     /* rewritten statement currently holding the value */
+    std::vector<uint32_t> _spills;      /* spill op holding a stack copy of the value */
+    std::vector<uint64_t> _spill_slots;
+    std::vector<RegisterId> _hints;
 
-                if(left->type_id() == SSAStmtTypeId_Literal &&
-                   right->type_id() != SSAStmtTypeId_Literal)
-                {
-                    binop->swap_operands();
-                }
+    /* Per register, the value it holds */
+    std::vector<uint32_t> _owners;
+    BitVector _pinned;
 
-                if(left->type_id() == SSAStmtTypeId_Variable &&
-                   right->type_id() != SSAStmtTypeId_Variable)
-                {
-                    binop->swap_operands();
-                }
+    std::vector<uint64_t> _free_slots;
+    uint64_t _num_slots;
+    bool _frame_pointer;
 
-                if(left->type_id() == SSAStmtTypeId_SpillOp &&
-                   right->type_id() != SSAStmtTypeId_SpillOp)
-                {
-                    binop->swap_operands();
-                }
+    uint64_t _max_pressure;
+    uint64_t _num_spills;
 
-                break;
-            }
-        }
+    uint64_t get_num_registers() const noexcept
+    {
+        return this->_platform_abi->get_max_available_fp_registers();
     }
 
-    return true;
-}
+    const SSAStmt& get_source(uint32_t value) const noexcept
+    {
+        return this->_ssa->get_statements()[value];
+    }
 
-/* Register allocation */
+    uint32_t emit(const SSAStmt& stmt) noexcept
+    {
+        this->_statements.push_back(stmt);
 
-using StackOffset = uint64_t;
-using Active = std::pair<SSAStmtPtr, RegisterId>;
+        return static_cast<uint32_t>(this->_statements.size() - 1);
+    }
 
-Active select_spill_candidate(std::vector<Active>& candidates) noexcept
-{
-    uint64_t duration = 0;
-    size_t position = 0;
+    void set_memloc(uint32_t stmt, MemLocPtr loc) noexcept
+    {
+        if(stmt >= this->_mapping.size())
+        {
+            this->_mapping.resize(stmt + 1);
+        }
+
+        this->_mapping[stmt] = std::move(loc);
+    }
 
-    for(auto [i, candidate] : std::ranges::enumerate_view(candidates))
+    const MemLocPtr& get_memloc(uint32_t stmt) const noexcept
     {
-        if(candidate.first->get_live_range().get_duration() > duration)
+        return this->_mapping[stmt];
+    }
+
+    MemLocPtr get_home_memloc(const SSAStmt& stmt) const noexcept
+    {
+        if(stmt.type == SSAStmtTypeId_Variable)
+        {
+            const std::string_view name = this->_ssa->get_name(stmt.op);
+
+            /* In reduction loops, the variables base pointer points to the column pointers */
+            if(stmt.is_column_element())
+            {
+                return std::make_shared<Column>(this->_platform_abi->get_variable_base_ptr(),
+                                                this->_symtable.get_variable_offset(name),
+                                                stmt.a * this->_symtable.get_value_size());
+            }
+
+            return std::make_shared<Memory>(this->_platform_abi->get_variable_base_ptr(),
+                                            this->_symtable.get_variable_offset(name));
+        }
+
+        if(stmt.type == SSAStmtTypeId_Literal)
         {
-            duration = candidate.first->get_live_range().get_duration();
-            position = i;
+            return std::make_shared<Constant>(this->_symtable.get_literal_offset(this->_ssa->get_name(stmt.op)));
         }
+
+        return nullptr;
     }
 
-    Active candidate = std::move(candidates[position]);
+    /* Column elements are only read through a register, see Column */
+    bool is_memory_operand(uint32_t value) const noexcept
+    {
+        return !this->get_source(value).is_column_element();
+    }
 
-    candidates.erase(candidates.begin() + position);
+    bool is_rematerializable(uint32_t value) const noexcept
+    {
+        const uint32_t type = this->get_source(value).type;
 
-    return candidate;
-}
+        return type == SSAStmtTypeId_Variable || type == SSAStmtTypeId_Literal;
+    }
 
-bool RegisterAllocator::allocate(SSA& ssa,
-                                 const SymbolTable& symtable) noexcept
-{
-    /* multi-pass register allocation using linear scan. we iteratively insert spills/loads */
-    uint32_t num_passes = 0;
-    uint32_t max_pressure = 0;
-    uint64_t needed_stack_size = 0;
+    /* Returns the statement holding a copy of value in memory, if any */
+    uint32_t get_memory_copy(uint32_t value) const noexcept
+    {
+        return this->is_rematerializable(value) ? this->_definitions[value] : this->_spills[value];
+    }
 
-    std::unordered_map<SSAStmtPtr, SSAStmtPtr> spilled;
+    RegisterId get_register(uint32_t value) const noexcept
+    {
+        const MemLocPtr& loc = this->get_memloc(this->_current[value]);
+
+        if(loc == nullptr || loc->type_id() != MemLocTypeId_Register)
+        {
+            return INVALID_FP_REGISTER;
+        }
 
-    while(true)
+        return memloc_const_cast<Register>(loc.get())->get_id();
+    }
+
+    /* Returns the position of the first use of value strictly after position */
+    uint64_t get_next_use(uint32_t value, uint64_t position) noexcept
     {
-        num_passes++;
+        const std::vector<uint32_t>& uses = this->_uses[value];
+        uint32_t& cursor = this->_use_cursors[value];
 
-        log_debug("Register allocation: pass {}", num_passes);
+        while(cursor < uses.size() && uses[cursor] <= position)
+        {
+            cursor++;
+        }
 
-        needed_stack_size = 0;
-        this->_mapping.clear();
+        return cursor < uses.size() ? uses[cursor] : NO_NEXT_USE;
+    }
 
-        if(!ssa.calculate_live_ranges())
+    uint64_t allocate_stack_slot() noexcept
+    {
+        if(!this->_free_slots.empty())
         {
-            return false;
+            const uint64_t slot = this->_free_slots.back();
+            this->_free_slots.pop_back();
+            return slot;
         }
 
-        if(!RegisterAllocator::prepass_commutative_operand_swap(ssa))
+        return this->_num_slots++;
+    }
+
+    /* Slots are stored below the frame pointer, or above the stack pointer when there is no frame */
+    MemLocPtr get_stack_slot_memloc(uint64_t slot) const noexcept
+    {
+        if(this->_frame_pointer)
         {
-            return false;
+            const int64_t offset = static_cast<int64_t>(this->_platform_abi->get_stack_base_offset() + slot * 8);
+
+            return std::make_shared<Stack>(this->_platform_abi->get_frame_ptr(), -offset);
         }
 
-        std::vector<Active> actives;
+        return std::make_shared<Stack>(this->_platform_abi->get_stack_ptr(), static_cast<int64_t>(slot * 8));
+    }
 
-        std::vector<SSAStmtPtr>& statements = ssa.get_statements();
+    uint32_t emit_load(uint32_t source, RegisterId reg) noexcept
+    {
+        const uint32_t load = this->emit({ SSAStmtTypeId_LoadOp, 0, source, 0, 0 });
 
-        /*
-            Allocation of constrained ops: - function calls return in xmm0
-                                           - expr return value in xmm0
-                                           - function args must go in xmm[i]
-                                           - allocate the memory address of each literal
+        this->set_memloc(load, std::make_shared<Register>(reg));
 
-        */
+        return load;
+    }
 
-        /* We only deal with fp values (double or float) so we only care about this rv */
-        RegisterId rv_reg = this->_platform_abi->get_call_return_value_fp_register();
+    /*
+        Makes sure the value held by reg has a copy in memory, without releasing the register.
+        Rematerializable values already have one at their home location
+    */
+    void store(RegisterId reg) noexcept
+    {
+        const uint32_t value = this->_owners[reg];
 
-        if(rv_reg == INVALID_FP_REGISTER)
+        if(this->get_memory_copy(value) != INVALID_STMT_INDEX)
         {
-            return false;
+            return;
         }
 
-        SSAStmtPtr& last_stmt = statements.back();
+        const uint32_t spill = this->emit({ SSAStmtTypeId_SpillOp, 0, this->_current[value], 0, 0 });
+
+        const uint64_t slot = this->allocate_stack_slot();
+
+        this->set_memloc(spill, this->get_stack_slot_memloc(slot));
+        this->_spill_slots[value] = slot;
+        this->_spills[value] = spill;
+        this->_num_spills++;
+
+        log_debug("Inserted spill op for ssa var: {}{}", VERSION_CHAR, value);
+    }
 
-        this->_mapping[last_stmt] = std::make_shared<Register>(rv_reg);
-        actives.emplace_back(last_stmt, rv_reg);
+    void evict(RegisterId reg) noexcept
+    {
+        const uint32_t value = this->_owners[reg];
 
-        switch(last_stmt->type_id())
+        if(this->is_rematerializable(value))
         {
-            case SSAStmtTypeId_UnOp:
-            {
-                auto unop = statement_cast<SSAStmtUnOp>(last_stmt.get());
+            log_debug("Dropped rematerializable ssa var: {}{}", VERSION_CHAR, value);
+        }
 
-                if(unop == nullptr)
-                {
-                    log_error("Error during return value register allocation. Expected unop, got: {}",
-                            last_stmt->type_id());
-                    return false;
-                }
+        this->store(reg);
+        this->_current[value] = this->get_memory_copy(value);
+        this->_owners[reg] = NO_VALUE;
+    }
 
-                auto operand = unop->get_operand();
+    RegisterId allocate_register(RegisterId hint, uint64_t position) noexcept
+    {
+        const uint64_t num_registers = this->get_num_registers();
 
-                this->_mapping[operand] = std::make_shared<Register>(rv_reg);
-                actives.emplace_back(operand, rv_reg);
+        RegisterId reg = INVALID_FP_REGISTER;
 
-                break;
-            }
+        if(hint < num_registers && this->_owners[hint] == NO_VALUE)
+        {
+            reg = hint;
+        }
 
-            case SSAStmtTypeId_BinOp:
+        for(RegisterId i = 0; reg == INVALID_FP_REGISTER && i < num_registers; i++)
+        {
+            if(this->_owners[i] == NO_VALUE)
             {
-                auto binop = statement_cast<SSAStmtBinOp>(last_stmt.get());
+                reg = i;
+            }
+        }
 
-                if(binop == nullptr)
+        if(reg == INVALID_FP_REGISTER)
+        {
+            uint64_t furthest_use = 0;
+
+            for(RegisterId i = 0; i < num_registers; i++)
+            {
+                if(this->_pinned.get(i))
                 {
-                    log_error("Error during return value register allocation. Expected binop, got: {}",
-                            last_stmt->type_id());
-                    return false;
+                    continue;
                 }
 
-                auto left = binop->get_left();
+                const uint64_t next_use = this->get_next_use(this->_owners[i], position);
 
-                this->_mapping[left] = std::make_shared<Register>(rv_reg);
-                actives.emplace_back(left, rv_reg);
+                if(reg == INVALID_FP_REGISTER || next_use > furthest_use)
+                {
+                    reg = i;
+                    furthest_use = next_use;
+                }
+            }
 
-                break;
+            if(reg == INVALID_FP_REGISTER)
+            {
+                log_error("Internal error during register allocation. No register can be evicted");
+                return INVALID_FP_REGISTER;
             }
+
+            this->evict(reg);
         }
 
-        for(int64_t i = statements.size() - 2; i >= 0; i--)
+        uint64_t pressure = 1;
+
+        for(RegisterId i = 0; i < num_registers; i++)
         {
-            auto& stmt = statements[i];
+            pressure += this->_owners[i] != NO_VALUE;
+        }
 
-            switch(stmt->type_id())
-            {
-                case SSAStmtTypeId_Literal:
-                {
-                    auto literal = statement_cast<SSAStmtLiteral>(stmt.get());
+        this->_max_pressure = std::max(this->_max_pressure, pressure);
 
-                    if(literal == nullptr)
-                    {
-                        log_error("Internal error during register allocation. Expected literal, got: {}",
-                                  stmt->type_id());
+        return reg;
+    }
 
-                        return false;
-                    }
+    /* Returns the statement holding value in a register, loading it if needed */
+    uint32_t ensure_in_register(uint32_t value, RegisterId hint, uint64_t position) noexcept
+    {
+        if(this->get_register(value) != INVALID_FP_REGISTER)
+        {
+            return this->_current[value];
+        }
 
-                    if(this->_mapping.contains(stmt))
-                    {
-                        break;
-                    }
+        const RegisterId reg = this->allocate_register(hint, position);
 
-                    this->_mapping[stmt] = std::make_shared<Memory>(this->_platform_abi->get_literal_base_ptr(),
-                                                                    symtable.get_literal_offset(literal->get_name()));
+        if(reg == INVALID_FP_REGISTER)
+        {
+            return INVALID_STMT_INDEX;
+        }
 
-                    break;
-                }
+        const uint32_t load = this->emit_load(this->_current[value], reg);
 
-                case SSAStmtTypeId_Variable:
-                {
-                    auto variable = statement_cast<SSAStmtVariable>(stmt.get());
+        this->_owners[reg] = value;
+        this->_current[value] = load;
 
-                    if(variable == nullptr)
-                    {
-                        log_error("Internal error during register allocation. Expected variable, got: {}",
-                                  stmt->type_id());
+        log_debug("Inserted load op for ssa var: {}{}", VERSION_CHAR, value);
 
-                        return false;
-                    }
+        return load;
+    }
 
-                    if(this->_mapping.contains(stmt))
-                    {
-                        break;
-                    }
+    void define(uint32_t value, const SSAStmt& stmt, RegisterId reg) noexcept
+    {
+        const uint32_t index = this->emit(stmt);
 
-                    this->_mapping[stmt] = std::make_shared<Memory>(this->_platform_abi->get_variable_base_ptr(),
-                                                                    symtable.get_variable_offset(variable->get_name()));
+        this->set_memloc(index, std::make_shared<Register>(reg));
+        this->_owners[reg] = value;
+        this->_current[value] = index;
+    }
 
-                    break;
-                }
+    bool is_reusable_register_operand(uint32_t value, uint64_t position) noexcept
+    {
+        return this->get_register(value) != INVALID_FP_REGISTER &&
+               this->get_next_use(value, position) == NO_NEXT_USE;
+    }
 
-                case SSAStmtTypeId_BinOp:
-                {
-                    auto binop = statement_cast<SSAStmtBinOp>(stmt.get());
+    /* Gives back the register and the stack slot of a value once its last use has been seen */
+    void release_if_dead(uint32_t value, uint64_t position) noexcept
+    {
+        if(this->get_next_use(value, position) != NO_NEXT_USE)
+        {
+            return;
+        }
 
-                    if(binop == nullptr)
-                    {
-                        log_error("Internal error during register allocation. Expected binop, got: {}",
-                                  stmt->type_id());
+        const RegisterId reg = this->get_register(value);
 
-                        return false;
-                    }
+        if(reg != INVALID_FP_REGISTER && this->_owners[reg] == value)
+        {
+            this->_owners[reg] = NO_VALUE;
+        }
 
-                    if(this->_mapping.contains(stmt))
-                    {
-                        RegisterId reg = memloc_cast<Register>(this->_mapping[stmt].get())->get_id();
+        if(this->_spills[value] != INVALID_STMT_INDEX)
+        {
+            this->_free_slots.push_back(this->_spill_slots[value]);
+            this->_spills[value] = INVALID_STMT_INDEX;
+        }
+    }
 
-                        this->_mapping[binop->get_left()] = std::make_shared<Register>(reg);
-                        actives.emplace_back(binop->get_left(), reg);
-                    }
+    void compute_uses_and_hints(const std::vector<SSAStmt>& statements) noexcept
+    {
+        for(const auto [i, stmt] : std::ranges::enumerate_view(statements))
+        {
+            for_each_operand(stmt, [&](uint32_t operand) {
+                std::vector<uint32_t>& uses = this->_uses[operand];
 
-                    break;
+                if(uses.empty() || uses.back() != static_cast<uint32_t>(i))
+                {
+                    uses.push_back(static_cast<uint32_t>(i));
                 }
+            });
+        }
 
-                case SSAStmtTypeId_FuncOp:
-                {
-                    this->_mapping[stmt] = std::make_shared<Register>(rv_reg);
-                    actives.emplace_back(stmt, rv_reg);
+        const uint32_t last = static_cast<uint32_t>(statements.size() - 1);
 
-                    auto funcop = statement_cast<SSAStmtFunctionOp>(stmt.get());
+        /* The return value lives until the end of the function, groups store their results instead */
+        if(has_return_value(statements))
+        {
+            this->_uses[last].push_back(static_cast<uint32_t>(statements.size()));
 
-                    if(funcop == nullptr)
-                    {
-                        log_error("Internal error during register allocation. Expected func op, got: {}",
-                                stmt->type_id());
-                        return false;
-                    }
+            this->_hints[last] = this->_platform_abi->get_call_return_value_fp_register();
+        }
+
+        for(uint32_t i = static_cast<uint32_t>(statements.size()); i-- > 0;)
+        {
+            const SSAStmt& stmt = statements[i];
+            const RegisterId hint = this->_hints[i];
 
-                    if(funcop->get_arguments().size() > this->_platform_abi->get_call_max_args_fp_registers())
+            switch(stmt.type)
+            {
+                case SSAStmtTypeId_UnOp:
+                case SSAStmtTypeId_BinOp:
+                {
+                    if(this->_hints[stmt.a] == INVALID_FP_REGISTER)
                     {
-                        return false;
+                        this->_hints[stmt.a] = hint;
                     }
 
+                    break;
+                }
+
+                case SSAStmtTypeId_FuncOp:
+                {
                     auto& args_registers = this->_platform_abi->get_call_args_fp_registers();
 
-                    for(auto [i, argument] : std::ranges::enumerate_view(funcop->get_arguments()))
+                    for(size_t j = 0; j < stmt.get_num_arguments() && j < args_registers.size(); j++)
                     {
-                        this->_mapping[argument] = std::make_shared<Register>(args_registers[i]);
-                        actives.emplace_back(argument, args_registers[i]);
+                        this->_hints[stmt.get_arguments()[j]] = args_registers[j];
                     }
 
                     break;
                 }
             }
         }
+    }
+
+    bool allocate_unop(SSAStmt stmt, uint32_t value) noexcept
+    {
+        const uint64_t position = value;
+        const uint32_t operand_value = stmt.a;
+
+        this->_pinned.reset();
 
-        /* Allocation of non-constrained ops */
+        uint32_t operand = this->ensure_in_register(operand_value, this->_hints[value], position);
 
-        std::vector<SSAStmtPtr> statements_sorted(statements.size());
+        if(operand == INVALID_STMT_INDEX)
+        {
+            return false;
+        }
 
-        std::copy(statements.begin(), statements.end(), statements_sorted.begin());
+        RegisterId reg = this->get_register(operand_value);
+        this->_pinned.set(reg);
 
-        std::sort(statements_sorted.begin(),
-                  statements_sorted.end(),
-                  [](const SSAStmtPtr& a, const SSAStmtPtr& b) -> bool {
-            return a->get_live_range().start < b->get_live_range().start;
-        });
+        /* The operation is done in place, keep the operand alive in its register if still needed */
+        if(this->get_next_use(operand_value, position) != NO_NEXT_USE)
+        {
+            reg = this->allocate_register(this->_hints[value], position);
 
-        std::unordered_set<SSAStmtPtr> to_spill;
-        uint64_t stack_offset = this->_platform_abi->get_stack_base_offset();
+            if(reg == INVALID_FP_REGISTER)
+            {
+                return false;
+            }
 
-        std::unordered_set<SSAStmtPtr> to_load;
+            operand = this->emit_load(operand, reg);
+        }
 
-        for(size_t i = 0; i < statements_sorted.size(); i++)
+        stmt.a = operand;
+
+        this->define(value, stmt, reg);
+
+        this->release_if_dead(operand_value, position);
+
+        return true;
+    }
+
+    bool allocate_binop(SSAStmt stmt, uint32_t value) noexcept
+    {
+        const uint64_t position = value;
+
+        /*
+            The result overwrites the left operand register. For commutative ops, put on the left
+            the operand that is already in a register and dies here, the other one being read from
+            memory if it is not in a register
+        */
+        if(op_binary_is_commutative(stmt.op) &&
+           !this->is_reusable_register_operand(stmt.a, position) &&
+           this->is_reusable_register_operand(stmt.b, position))
         {
-            auto& stmt = statements_sorted[i];
+            std::swap(stmt.a, stmt.b);
+        }
 
-            /* Remove expired intervals from the actives, freeing registers */
-            auto remove_result = std::remove_if(actives.begin(),
-                                                actives.end(),
-                                                [&](const Active& active) -> bool {
-                return active.first->get_live_range().end < stmt->get_live_range().start;
-            });
+        const uint32_t left_value = stmt.a;
+        const uint32_t right_value = stmt.b;
+
+        this->_pinned.reset();
+
+        const RegisterId right_reg = this->get_register(right_value);
+
+        if(right_reg != INVALID_FP_REGISTER)
+        {
+            this->_pinned.set(right_reg);
+        }
+
+        uint32_t left = this->ensure_in_register(left_value, this->_hints[value], position);
+
+        if(left == INVALID_STMT_INDEX)
+        {
+            return false;
+        }
 
-            actives.erase(remove_result, actives.end());
+        RegisterId reg = this->get_register(left_value);
+        this->_pinned.set(reg);
 
-            /*
-                Check if we have to insert a load. Since we let all literals and variables in memory,
-                if we need a register for one, load it here
-                TODO: maybe check function ops too
-            */
-            switch(stmt->type_id())
+        /* Bitwise ops read 16 bytes, memory operands are not guaranteed to be aligned for them */
+        if(op_binary_is_bitwise(stmt.op) || !this->is_memory_operand(right_value))
+        {
+            if(this->ensure_in_register(right_value, INVALID_FP_REGISTER, position) == INVALID_STMT_INDEX)
             {
-                case SSAStmtTypeId_UnOp:
-                {
-                    auto unop = statement_cast<SSAStmtUnOp>(stmt.get());
+                return false;
+            }
 
-                    if(unop == nullptr)
-                    {
-                        log_error("Internal error during register allocation. Expected unop, got: {}",
-                                  stmt->type_id());
-                        return false;
-                    }
+            this->_pinned.set(this->get_register(right_value));
+        }
 
-                    if(unop->get_operand()->type_id() == SSAStmtTypeId_Literal ||
-                       unop->get_operand()->type_id() == SSAStmtTypeId_Variable)
-                    {
-                        to_load.insert(unop->get_operand());
-                    }
+        /* x86_64 binops overwrite their left operand, copy it first if it is still needed */
+        if(this->get_next_use(left_value, position) != NO_NEXT_USE)
+        {
+            reg = this->allocate_register(this->_hints[value], position);
 
-                    break;
-                }
+            if(reg == INVALID_FP_REGISTER)
+            {
+                return false;
+            }
 
-                case SSAStmtTypeId_BinOp:
-                {
-                    auto binop = statement_cast<SSAStmtBinOp>(stmt.get());
+            left = this->emit_load(left, reg);
+        }
 
-                    if(binop == nullptr)
-                    {
-                        log_error("Internal error during register allocation. Expected binop, got: {}",
-                                  stmt->type_id());
-                        return false;
-                    }
+        /* The right operand can be used from a register, its home memory or its stack slot */
+        stmt.a = left;
+        stmt.b = this->_current[right_value];
 
-                    if(binop->get_left()->type_id() == SSAStmtTypeId_Literal ||
-                       binop->get_left()->type_id() == SSAStmtTypeId_Variable)
-                    {
-                        to_load.insert(binop->get_left());
-                    }
+        this->define(value, stmt, reg);
 
-                    break;
-                }
+        this->release_if_dead(left_value, position);
+        this->release_if_dead(right_value, position);
+
+        return true;
+    }
+
+    bool allocate_storeop(SSAStmt stmt, uint32_t value) noexcept
+    {
+        const uint64_t position = value;
+        const uint32_t operand_value = stmt.a;
+
+        this->_pinned.reset();
+
+        uint32_t operand = this->ensure_in_register(operand_value, INVALID_FP_REGISTER, position);
+
+        if(operand == INVALID_STMT_INDEX)
+        {
+            return false;
+        }
+
+        /* Accumulating adds the slot to the operand register before storing it */
+        if(stmt.is_accumulate() && this->get_next_use(operand_value, position) != NO_NEXT_USE)
+        {
+            this->_pinned.set(this->get_register(operand_value));
+
+            const RegisterId reg = this->allocate_register(INVALID_FP_REGISTER, position);
+
+            if(reg == INVALID_FP_REGISTER)
+            {
+                return false;
             }
 
-            if(this->_mapping.contains(stmt))
+            operand = this->emit_load(operand, reg);
+        }
+
+        stmt.a = operand;
+
+        this->set_memloc(this->emit(stmt),
+                         std::make_shared<Memory>(this->_platform_abi->get_output_base_ptr(),
+                                                  stmt.b * this->_symtable.get_value_size()));
+
+        this->release_if_dead(operand_value, position);
+
+        return true;
+    }
+
+    bool allocate_funcop(SSAStmt stmt, uint32_t value) noexcept
+    {
+        const uint64_t position = value;
+        const size_t num_arguments = stmt.get_num_arguments();
+        uint32_t* arguments = stmt.get_arguments();
+        auto& args_registers = this->_platform_abi->get_call_args_fp_registers();
+
+        if(num_arguments > this->_platform_abi->get_call_max_args_fp_registers())
+        {
+            log_error("Function \"{}\" is called with {} arguments, only {} are supported",
+                      this->_ssa->get_name(stmt.op),
+                      num_arguments,
+                      this->_platform_abi->get_call_max_args_fp_registers());
+            return false;
+        }
+
+        uint32_t values[SSA_MAX_FUNCTION_ARGUMENTS];
+
+        std::copy(arguments, arguments + num_arguments, values);
+
+        const uint64_t num_registers = this->get_num_registers();
+
+        /* All fp registers are clobbered by the call, values needed after it go to the stack */
+        for(RegisterId reg = 0; reg < num_registers; reg++)
+        {
+            const uint32_t owner = this->_owners[reg];
+
+            if(owner == NO_VALUE || this->get_next_use(owner, position) == NO_NEXT_USE)
             {
                 continue;
             }
 
-            /* Check if we can reuse a register used in the op to store the result */
-            MemLocPtr reusable_register = this->get_reusable_register(stmt);
-
-            if(reusable_register != nullptr &&
-               reusable_register->type_id() == MemLocTypeId_Register)
+            if(std::find(values, values + num_arguments, owner) != values + num_arguments)
+            {
+                this->store(reg);
+            }
+            else
             {
-                auto reg = memloc_cast<Register>(reusable_register.get());
+                this->evict(reg);
+            }
+        }
+
+        /* Move the arguments to their registers, breaking cycles through a free register */
+        std::vector<size_t> pending(num_arguments);
+        std::iota(pending.begin(), pending.end(), 0);
 
-                if(reg == nullptr)
+        this->_pinned.reset();
+
+        auto is_pending_source = [&](RegisterId reg, size_t except) -> bool {
+            for(const size_t k : pending)
+            {
+                if(k != except && this->get_register(values[k]) == reg)
                 {
-                    log_error("Internal error during register allocation. Expected register, got: {}",
-                              reusable_register->type_id());
-                    return false;
+                    return true;
                 }
+            }
 
-                this->_mapping[stmt] = std::make_shared<Register>(reg->get_id());
-                actives.emplace_back(stmt, reg->get_id());
-                continue;
+            return false;
+        };
+
+        auto is_pending_target = [&](RegisterId reg) -> bool {
+            for(const size_t k : pending)
+            {
+                if(args_registers[k] == reg)
+                {
+                    return true;
+                }
             }
 
-            if(stmt->type_id() == SSAStmtTypeId_SpillOp)
+            return false;
+        };
+
+        while(!pending.empty())
+        {
+            bool progress = false;
+
+            for(auto it = pending.begin(); it != pending.end();)
             {
-                auto spill = statement_cast<SSAStmtSpillOp>(stmt.get());
+                const size_t j = *it;
+                const RegisterId target = args_registers[j];
 
-                this->_mapping[stmt] = std::make_shared<Stack>(stack_offset);
-                stack_offset += 8;
+                if(this->get_register(values[j]) == target && !this->_pinned.get(target))
+                {
+                    arguments[j] = this->_current[values[j]];
+                }
+                else if(is_pending_source(target, j))
+                {
+                    ++it;
+                    continue;
+                }
+                else
+                {
+                    const uint32_t previous = this->_owners[target];
 
-                needed_stack_size = std::max(needed_stack_size, stack_offset);
+                    if(previous != NO_VALUE &&
+                       previous != values[j] &&
+                       this->get_memory_copy(previous) != INVALID_STMT_INDEX)
+                    {
+                        this->_current[previous] = this->get_memory_copy(previous);
+                    }
 
-                auto remove_result = std::remove_if(actives.begin(),
-                                                    actives.end(),
-                                                    [&](const Active& active) -> bool {
-                    return active.first == spill->get_operand();
-                });
+                    arguments[j] = this->emit_load(this->_current[values[j]], target);
+                    this->_owners[target] = values[j];
+                }
 
-                actives.erase(remove_result, actives.end());
+                this->_pinned.set(target);
+                it = pending.erase(it);
+                progress = true;
+            }
 
+            if(progress || pending.empty())
+            {
                 continue;
             }
 
-            BitVector used_registers;
+            /* Cycle: move the value blocking the first pending argument out of the way */
+            const RegisterId blocked = args_registers[pending.front()];
+            const uint32_t blocking_value = this->_owners[blocked];
 
-            for(const auto& [_, reg] : actives)
+            RegisterId scratch = INVALID_FP_REGISTER;
+
+            for(RegisterId reg = 0; reg < num_registers && scratch == INVALID_FP_REGISTER; reg++)
             {
-                used_registers.set(reg);
+                if(this->_owners[reg] == NO_VALUE && !this->_pinned.get(reg) && !is_pending_target(reg))
+                {
+                    scratch = reg;
+                }
             }
 
-            RegisterId available_register = used_registers.ffz();
-
-            max_pressure = std::max(max_pressure, static_cast<uint32_t>(available_register));
-
-            /* Handle spilling */
-            if(available_register >= this->_platform_abi->get_max_available_fp_registers())
+            if(scratch != INVALID_FP_REGISTER)
             {
-                auto [stmt_to_spill, free_reg] = select_spill_candidate(actives);
+                this->_current[blocking_value] = this->emit_load(this->_current[blocking_value], scratch);
+                this->_owners[scratch] = blocking_value;
+                this->_owners[blocked] = NO_VALUE;
+            }
+            else
+            {
+                this->evict(blocked);
+            }
+        }
 
-                to_spill.insert(stmt_to_spill);
+        /* Nothing survives the call in registers */
+        for(RegisterId reg = 0; reg < num_registers; reg++)
+        {
+            const uint32_t owner = this->_owners[reg];
 
-                available_register = free_reg;
+            if(owner != NO_VALUE && this->get_memory_copy(owner) != INVALID_STMT_INDEX)
+            {
+                this->_current[owner] = this->get_memory_copy(owner);
             }
 
-            this->_mapping[stmt] = std::make_shared<Register>(available_register);
-            actives.emplace_back(stmt, available_register);
+            this->_owners[reg] = NO_VALUE;
         }
 
-        /* register allocation is successful */
-        if(to_spill.size() == 0 && to_load.size() == 0)
+        this->define(value, stmt, this->_platform_abi->get_call_return_value_fp_register());
+
+        for(size_t j = 0; j < num_arguments; j++)
         {
-            break;
+            this->release_if_dead(values[j], position);
         }
 
-        std::vector<SSAStmtPtr> new_statements;
-        new_statements.reserve(statements.size() + to_spill.size() * 2);
+        return true;
+    }
 
-        uint64_t version = statements.size();
+public:
+    LinearScan(PlatformABIPtr platform_abi,
+               const SymbolTable& symtable,
+               std::vector<MemLocPtr>& mapping) : _platform_abi(platform_abi),
+                                                  _symtable(symtable),
+                                                  _mapping(mapping),
+                                                  _ssa(nullptr),
+                                                  _num_slots(0),
+                                                  _frame_pointer(KEEP_FRAME_POINTER),
+                                                  _max_pressure(0),
+                                                  _num_spills(0) {}
 
-        for(auto stmt : statements)
-        {
-            /* Check if we need to add loads */
-            switch(stmt->type_id())
-            {
-                case SSAStmtTypeId_UnOp:
-                {
-                    auto unop = statement_cast<SSAStmtUnOp>(stmt.get());
+    uint64_t get_stack_size() const noexcept { return this->_num_slots * 8; }
 
-                    if(unop == nullptr)
-                    {
-                        log_error("Error during load op insertion. Expected unop, got: {}",
-                                  stmt->type_id());
-                        return false;
-                    }
+    bool has_frame_pointer() const noexcept { return this->_frame_pointer; }
 
-                    auto& operand = unop->get_operand();
+    uint64_t get_max_pressure() const noexcept { return this->_max_pressure; }
 
-                    if(to_spill.contains(operand))
-                    {
-                        if(!spilled.contains(operand))
-                        {
-                            log_error("Error during spilled search. Cannot find spill statement for op: {}",
-                                      operand->get_version());
-                            return false;
-                        }
-
-                        SSAStmtPtr load = std::make_shared<SSAStmtLoadOp>(spilled[operand], version++);
-                        unop->set_operand(load);
-                        new_statements.emplace_back(load);
-
-                        log_debug("Inserted load op for ssa var: {}{}",
-                                  VERSION_CHAR,
-                                  operand->get_version());
-                    }
+    uint64_t get_num_spills() const noexcept { return this->_num_spills; }
 
-                    if(to_load.contains(operand))
-                    {
-                        SSAStmtPtr load = std::make_shared<SSAStmtLoadOp>(operand, version++);
-                        unop->set_operand(load);
-                        new_statements.emplace_back(load);
+    bool run(SSA& ssa) noexcept
+    {
+        const std::vector<SSAStmt>& statements = ssa.get_statements();
 
-                        log_debug("Inserted load op for ssa var: {}{}",
-                                  VERSION_CHAR,
-                                  operand->get_version());
-                    }
+        if(statements.empty())
+        {
+            log_error("Cannot allocate registers for an empty SSA");
+            return false;
+        }
+
+        const size_t num_values = statements.size();
+
+        this->_ssa = &ssa;
+        this->_mapping.clear();
+        this->_mapping.reserve(num_values * 2);
+        this->_uses.assign(num_values, {});
+        this->_use_cursors.assign(num_values, 0);
+        this->_definitions.assign(num_values, INVALID_STMT_INDEX);
+        this->_current.assign(num_values, INVALID_STMT_INDEX);
+        this->_spills.assign(num_values, INVALID_STMT_INDEX);
+        this->_spill_slots.assign(num_values, 0);
+        this->_hints.assign(num_values, INVALID_FP_REGISTER);
+        this->_owners.assign(this->get_num_registers(), NO_VALUE);
+        this->_statements.reserve(num_values * 2);
+
+        this->compute_uses_and_hints(statements);
+
+        for(uint32_t value = 0; value < num_values; value++)
+        {
+            const SSAStmt& stmt = statements[value];
+
+            switch(stmt.type)
+            {
+                case SSAStmtTypeId_Variable:
+                case SSAStmtTypeId_Literal:
+                {
+                    /* Loaded on demand from their home location */
+                    const uint32_t index = this->emit(stmt);
+
+                    this->set_memloc(index, this->get_home_memloc(stmt));
+                    this->_definitions[value] = index;
+                    this->_current[value] = index;
 
                     break;
                 }
 
-                case SSAStmtTypeId_BinOp:
+                case SSAStmtTypeId_UnOp:
                 {
-                    auto binop = statement_cast<SSAStmtBinOp>(stmt.get());
-
-                    if(binop == nullptr)
+                    if(!this->allocate_unop(stmt, value))
                     {
-                        log_error("Error during load op insertion. Expected binop, got: {}",
-                                  stmt->type_id());
                         return false;
                     }
 
-                    auto& left = binop->get_left();
-                    auto& right = binop->get_right();
-
-                    auto it = to_spill.find(left);
-
-                    if(it != to_spill.end())
-                    {
-                        if(!spilled.contains(left))
-                        {
-                            log_error("Error during spilled search. Cannot find spill statement for op: {}",
-                                      left->get_version());
-                            return false;
-                        }
-
-                        SSAStmtPtr load = std::make_shared<SSAStmtLoadOp>(spilled[left], version++);
-                        binop->set_left(load);
-                        new_statements.emplace_back(load);
-
-                        log_debug("Inserted load op for ssa var: {}{}",
-                                  VERSION_CHAR,
-                                  left->get_version());
-                    }
+                    break;
+                }
 
-                    if(to_load.contains(left))
+                case SSAStmtTypeId_BinOp:
+                {
+                    if(!this->allocate_binop(stmt, value))
                     {
-                        SSAStmtPtr load = std::make_shared<SSAStmtLoadOp>(left, version++);
-                        binop->set_left(load);
-                        new_statements.emplace_back(load);
-
-                        log_debug("Inserted load op for ssa var: {}{}",
-                                  VERSION_CHAR,
-                                  left->get_version());
+                        return false;
                     }
 
-                    /*
-                        We don't need to load the right operand because it can be used in
-                        immediate mode
-                        We take care of that below, once all registers have been allocated
-                    */
-
                     break;
                 }
 
                 case SSAStmtTypeId_FuncOp:
                 {
-                    auto funcop = statement_cast<SSAStmtFunctionOp>(stmt.get());
-
-                    if(funcop == nullptr)
+                    if(!this->allocate_funcop(stmt, value))
                     {
-                        log_error("Error during load op insertion. Expected funcop, got: {}",
-                                  stmt->type_id());
                         return false;
                     }
 
-                    for(auto [i, arg] : std::ranges::enumerate_view(funcop->get_arguments()))
+                    break;
+                }
+
+                case SSAStmtTypeId_StoreOp:
+                {
+                    if(!this->allocate_storeop(stmt, value))
                     {
-                        if(to_spill.contains(arg))
-                        {
-                            SSAStmtPtr load = std::make_shared<SSAStmtLoadOp>(arg, version++);
-                            funcop->get_arguments()[i] = load;
-                            new_statements.emplace_back(load);
-
-                            log_debug("Inserted load op for ssa var: {}{}",
-                                      VERSION_CHAR,
-                                      arg->get_version());
-                        }
+                        return false;
                     }
 
                     break;
                 }
+
+                default:
+                {
+                    log_error("Internal error during register allocation. Unexpected statement: {}",
+                              stmt.type);
+                    return false;
+                }
             }
+        }
 
-            new_statements.emplace_back(stmt);
+        if(has_return_value(statements))
+        {
+            /* The return value is expected in the return register */
+            const RegisterId rv_reg = this->_platform_abi->get_call_return_value_fp_register();
+            const uint32_t return_value = static_cast<uint32_t>(num_values - 1);
 
-            /* Check if we need to add a spill */
-            if(to_spill.contains(stmt))
+            if(this->get_register(return_value) != rv_reg)
             {
-                SSAStmtPtr spill = std::make_shared<SSAStmtSpillOp>(stmt, version++);
-                new_statements.emplace_back(spill);
-
-                spilled[stmt] = spill;
+                if(this->_owners[rv_reg] != NO_VALUE)
+                {
+                    log_error("Internal error during register allocation. Return register is not free");
+                    return false;
+                }
 
-                log_debug("Inserted spill op for ssa var: {}{}",
-                          VERSION_CHAR,
-                          stmt->get_version());
+                this->emit_load(this->_current[return_value], rv_reg);
             }
         }
 
-        ssa.get_statements() = std::move(new_statements);
+        this->_mapping.resize(this->_statements.size());
+
+        ssa.get_statements() = std::move(this->_statements);
+
+        return true;
+    }
+};
+
+bool RegisterAllocator::allocate(SSA& ssa,
+                                 const SymbolTable& symtable) noexcept
+{
+    if(this->_platform_abi->get_call_return_value_fp_register() == INVALID_FP_REGISTER)
+    {
+        return false;
+    }
+
+    if(!RegisterAllocator::prepass_commutative_operand_swap(ssa))
+    {
+        return false;
     }
 
-    log_debug("Allocated registers in {} pass{} (max pressure: {})",
-              num_passes,
-              num_passes > 1 ? "es" : "",
-              max_pressure + 1);
+    LinearScan linear_scan(this->_platform_abi, symtable, this->_mapping);
+
+    if(!linear_scan.run(ssa))
+    {
+        return false;
+    }
+
+    log_debug("Allocated registers in a single pass (max pressure: {}, spills: {})",
+              linear_scan.get_max_pressure(),
+              linear_scan.get_num_spills());
+
+    uint64_t needed_stack_size = linear_scan.get_stack_size();
 
     if(needed_stack_size > 0)
     {
@@ -809,11 +1176,11 @@ bool RegisterAllocator::allocate(SSA& ssa,
         needed_stack_size = ((needed_stack_size + 15) & ~15);
 
         log_debug("Adding stackalloc op (needed space: {})", needed_stack_size);
-
-        ssa.get_statements().emplace(ssa.get_statements().begin(),
-                                     std::make_shared<SSAStmtAllocateStackOp>(needed_stack_size));
     }
 
+    ssa.set_stack_allocation(needed_stack_size, linear_scan.has_frame_pointer());
+    ssa.calculate_live_ranges();
+
     return true;
 }
 
@@ -10,251 +10,348 @@
 #include <unordered_map>
 #include <algorithm>
 #include <format>
+#include <cmath>
 
 MATHEXPR_NAMESPACE_BEGIN
 
-void SSAStmtVariable::print(std::ostream_iterator<char>& out) const noexcept
+void SSA::clear() noexcept
 {
-    std::format_to(out, "{}{} = load {} ({}->{})\n", 
-                   VERSION_CHAR, 
-                   this->get_version(),
-                   this->_name,
-                   this->get_live_range().start,
-                   this->get_live_range().end);
+    this->_statements.clear();
+    this->_names.clear();
+    this->_name_ids.clear();
+    this->_live_ranges.clear();
+    this->_stack_size = 0;
+    this->_frame_pointer = false;
 }
 
-void SSAStmtLiteral::print(std::ostream_iterator<char>& out) const noexcept
+uint32_t SSA::add_name(std::string_view name) noexcept
 {
-    std::format_to(out, 
-                   "{}{} = loadi {} ({}->{})\n",
-                   VERSION_CHAR,
-                   this->get_version(),
-                   this->_name,
-                   this->get_live_range().start,
-                   this->get_live_range().end);
-}
+    auto [it, inserted] = this->_name_ids.try_emplace(name, static_cast<uint32_t>(this->_names.size()));
 
-void SSAStmtUnOp::print(std::ostream_iterator<char>& out) const noexcept
-{
-    std::format_to(out, 
-                   "{}{} = {}{}{} ({}->{})\n",
-                   VERSION_CHAR,
-                   this->get_version(),
-                   op_unary_to_string(this->_op),
-                   VERSION_CHAR,
-                   this->_operand->get_version(),
-                   this->get_live_range().start,
-                   this->get_live_range().end);
-}
+    if(inserted)
+    {
+        this->_names.push_back(name);
+    }
 
-void SSAStmtBinOp::print(std::ostream_iterator<char>& out) const noexcept
-{
-    std::format_to(out, 
-                   "{}{} = {}{} {} {}{} ({}->{})\n",
-                   VERSION_CHAR,
-                   this->get_version(),
-                   VERSION_CHAR,
-                   this->_left->get_version(),
-                   op_binary_to_string(this->_op),
-                   VERSION_CHAR,
-                   this->_right->get_version(),
-                   this->get_live_range().start,
-                   this->get_live_range().end);
+    return it->second;
 }
 
-void SSAStmtFunctionOp::print(std::ostream_iterator<char>& out) const noexcept
+void SSA::print() const noexcept
 {
-    std::string arguments;
+    static std::ostream_iterator<char> out(std::cout);
 
-    for(const auto [i, arg] : std::views::enumerate(this->_arguments))
+    std::format_to(out, "SSA\n");
+
+    if(this->_stack_size > 0)
     {
-        std::format_to(std::back_inserter(arguments), 
-                       "{}{}{}",
-                       i == 0 ? "" : ", ",
-                       VERSION_CHAR,
-                       arg->get_version());
+        std::format_to(out,
+                       "stackalloc ({} bytes{})\n",
+                       this->_stack_size,
+                       this->_frame_pointer ? ", frame pointer" : "");
     }
 
-    std::format_to(out,
-                   "{}{} = {}({}) ({}->{})\n", 
-                   VERSION_CHAR,
-                   this->get_version(),
-                   this->_name,
-                   arguments,
-                   this->get_live_range().start,
-                   this->get_live_range().end);
-}
+    const bool has_live_ranges = this->_live_ranges.size() == this->_statements.size();
 
-void SSAStmtAllocateStackOp::print(std::ostream_iterator<char>& out) const noexcept
-{
-    std::format_to(out, "stackalloc ({} bytes)\n", this->_size);
-}
+    for(const auto [i, stmt] : std::views::enumerate(this->_statements))
+    {
+        std::string live_range;
 
-void SSAStmtSpillOp::print(std::ostream_iterator<char>& out) const noexcept
-{
-    std::format_to(out,
-                   "{}{} = spill {}{}\n",
-                   VERSION_CHAR,
-                   this->get_version(),
-                   VERSION_CHAR,
-                   this->_operand->get_version());
-}
+        if(has_live_ranges)
+        {
+            std::format_to(std::back_inserter(live_range),
+                           " ({}->{})",
+                           this->_live_ranges[i].start,
+                           this->_live_ranges[i].end);
+        }
 
-void SSAStmtLoadOp::print(std::ostream_iterator<char>& out) const noexcept
-{
-    std::format_to(out,
-                   "{}{} = load {}{}\n",
-                   VERSION_CHAR,
-                   this->get_version(),
-                   VERSION_CHAR,
-                   this->_spill->get_version());
-}
+        switch(stmt.type)
+        {
+            case SSAStmtTypeId_Variable:
+            {
+                if(stmt.is_column_element())
+                {
+                    std::format_to(out, "{}{} = load {}[{}]{}\n", VERSION_CHAR, i, this->_names[stmt.op], stmt.a, live_range);
+                }
+                else
+                {
+                    std::format_to(out, "{}{} = load {}{}\n", VERSION_CHAR, i, this->_names[stmt.op], live_range);
+                }
 
-void SSA::print() const noexcept
-{
-    static std::ostream_iterator<char> out(std::cout);
+                break;
+            }
+            case SSAStmtTypeId_Literal:
+            {
+                std::format_to(out, "{}{} = loadi {}{}\n", VERSION_CHAR, i, this->_names[stmt.op], live_range);
+                break;
+            }
+            case SSAStmtTypeId_UnOp:
+            {
+                std::format_to(out,
+                               "{}{} = {}{}{}{}\n",
+                               VERSION_CHAR,
+                               i,
+                               op_unary_to_string(stmt.op),
+                               VERSION_CHAR,
+                               stmt.a,
+                               live_range);
+                break;
+            }
+            case SSAStmtTypeId_BinOp:
+            {
+                std::format_to(out,
+                               "{}{} = {}{} {} {}{}{}\n",
+                               VERSION_CHAR,
+                               i,
+                               VERSION_CHAR,
+                               stmt.a,
+                               op_binary_to_string(stmt.op),
+                               VERSION_CHAR,
+                               stmt.b,
+                               live_range);
+                break;
+            }
+            case SSAStmtTypeId_FuncOp:
+            {
+                std::string arguments;
 
-    std::format_to(out, "SSA\n");
+                for(size_t j = 0; j < stmt.get_num_arguments(); j++)
+                {
+                    std::format_to(std::back_inserter(arguments),
+                                   "{}{}{}",
+                                   j == 0 ? "" : ", ",
+                                   VERSION_CHAR,
+                                   stmt.get_arguments()[j]);
+                }
 
-    for(const auto& stmt : this->_statements)
-    {
-        stmt->print(out);
+                std::format_to(out,
+                               "{}{} = {}({}){}\n",
+                               VERSION_CHAR,
+                               i,
+                               this->_names[stmt.op],
+                               arguments,
+                               live_range);
+                break;
+            }
+            case SSAStmtTypeId_SpillOp:
+            {
+                std::format_to(out, "{}{} = spill {}{}\n", VERSION_CHAR, i, VERSION_CHAR, stmt.a);
+                break;
+            }
+            case SSAStmtTypeId_LoadOp:
+            {
+                std::format_to(out, "{}{} = load {}{}\n", VERSION_CHAR, i, VERSION_CHAR, stmt.a);
+                break;
+            }
+            case SSAStmtTypeId_StoreOp:
+            {
+                std::format_to(out,
+                               "{} {}{} -> out[{}]\n",
+                               stmt.is_accumulate() ? "accumulate" : "store",
+                               VERSION_CHAR,
+                               stmt.a,
+                               stmt.b);
+                break;
+            }
+        }
     }
 
     std::format_to(out, "\n");
 }
 
-uint64_t SSAStmtVariable::canonicalize() const noexcept
-{
-    return 0;
-}
-
-uint64_t SSAStmtLiteral::canonicalize() const noexcept
-{
-    return 0;
-}
+/*
+    Canonical hashes, equivalent statements have the same hash. Names are interned and operands are
+    indices, so statements are hashed and compared field by field. Commutative binops hash their
+    operands in order
+*/
 
-uint64_t SSAStmtUnOp::canonicalize() const noexcept
+static uint64_t hash_combine(uint64_t seed, uint64_t value) noexcept
 {
-    return 0;
+    return seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
 }
 
-uint64_t SSAStmtBinOp::canonicalize() const noexcept
+static uint64_t ssa_statement_hash(const SSAStmt& stmt) noexcept
 {
-    return 0;
-}
+    uint32_t a = stmt.a;
+    uint32_t b = stmt.b;
 
-uint64_t SSAStmtFunctionOp::canonicalize() const noexcept
-{
-    return 0;
-}
+    if(stmt.type == SSAStmtTypeId_BinOp && op_binary_is_commutative(stmt.op) && a > b)
+    {
+        std::swap(a, b);
+    }
 
-uint64_t SSAStmtAllocateStackOp::canonicalize() const noexcept
-{
-    return 0;
+    return hash_combine(hash_combine(hash_combine(hash_combine(stmt.type, stmt.op), a), b), stmt.c);
 }
 
-uint64_t SSAStmtSpillOp::canonicalize() const noexcept
+/* Returns true if both statements compute the same value */
+static bool ssa_statements_equivalent(const SSAStmt& a, const SSAStmt& b) noexcept
 {
-    return 0;
-}
+    if(a == b)
+    {
+        return true;
+    }
 
-uint64_t SSAStmtLoadOp::canonicalize() const noexcept
-{
-    return 0;
+    return a.type == SSAStmtTypeId_BinOp &&
+           b.type == SSAStmtTypeId_BinOp &&
+           a.op == b.op &&
+           op_binary_is_commutative(a.op) &&
+           a.a == b.b &&
+           a.b == b.a;
 }
 
 /* SSA */
 
-bool SSA::calculate_live_ranges() noexcept
+void SSA::calculate_live_ranges() noexcept
 {
-    for(auto [i, statement]: std::ranges::enumerate_view(this->_statements))
+    this->_live_ranges.clear();
+    this->_live_ranges.reserve(this->_statements.size());
+
+    for(const auto [i, stmt] : std::views::enumerate(this->_statements))
     {
-        statement->get_live_range().start = i;
-        statement->get_live_range().end = i + 1;
+        this->_live_ranges.emplace_back(i, i + 1);
 
-        switch(statement->type_id())
+        switch(stmt.type)
         {
             case SSAStmtTypeId_UnOp:
+            case SSAStmtTypeId_SpillOp:
+            case SSAStmtTypeId_StoreOp:
             {
-                auto unop = statement_cast<SSAStmtUnOp>(statement.get());
-
-                if(unop == nullptr)
-                {
-                    log_error("Internal error during live ranges calculation. Expected unop, got: {}",
-                              statement->type_id());
-                    return false;
-                }
-
-                unop->get_operand()->get_live_range().set_end(i);
-
+                this->_live_ranges[stmt.a].set_end(i);
                 break;
             }
 
             case SSAStmtTypeId_BinOp:
             {
-                auto binop = statement_cast<SSAStmtBinOp>(statement.get());
-
-                if(binop == nullptr)
-                {
-                    log_error("Internal error during live ranges calculation. Expected binop, got: {}",
-                              statement->type_id());
-                    return false;
-                }
-
-                binop->get_left()->get_live_range().set_end(i);
-                binop->get_right()->get_live_range().set_end(i);
-
+                this->_live_ranges[stmt.a].set_end(i);
+                this->_live_ranges[stmt.b].set_end(i);
                 break;
             }
 
             case SSAStmtTypeId_FuncOp:
             {
-                auto funcop = statement_cast<SSAStmtFunctionOp>(statement.get());
-
-                if(funcop == nullptr)
-                {
-                    log_error("Internal error during live ranges calculation. Expected funcop, got: {}",
-                              statement->type_id());
-                    return false;
-                }
-
-                for(auto arg : funcop->get_arguments())
+                for(size_t j = 0; j < stmt.get_num_arguments(); j++)
                 {
-                    arg->get_live_range().set_end(i);
+                    this->_live_ranges[stmt.get_arguments()[j]].set_end(i);
                 }
 
                 break;
             }
+        }
+    }
+}
 
-            case SSAStmtTypeId_SpillOp:
-            {
-                auto spillop = statement_cast<SSAStmtSpillOp>(statement.get());
+/*
+    Literal exponents that are positive integers or half-integers (up to MAX_SPECIALIZED_EXPONENT) are
+    specialized into multiplications and a sqrtsd, other exponents call pow
+*/
+static constexpr double MAX_SPECIALIZED_EXPONENT = 64.0;
 
-                if(spillop == nullptr)
-                {
-                    log_error("Internal error during live ranges calculation. Expected spillop, got: {}",
-                              statement->type_id());
-                    return false;
-                }
+bool can_specialize_power(double exponent) noexcept
+{
+    return exponent > 0.0 &&
+           exponent <= MAX_SPECIALIZED_EXPONENT &&
+           exponent * 2.0 == std::floor(exponent * 2.0);
+}
 
-                spillop->get_operand()->get_live_range().set_end(i);
+/*
+    Statements equivalent to one already built (same variable, same operation on the same operands)
+    are not added again, the existing statement is reused instead (common subexpression elimination)
+*/
+uint32_t SSA::add_statement(const SSAStmt& stmt, SSAValueTable& values) noexcept
+{
+    const uint64_t hash = ssa_statement_hash(stmt);
 
-                break;
-            }
+    auto [begin, end] = values.equal_range(hash);
+
+    for(auto it = begin; it != end; ++it)
+    {
+        if(ssa_statements_equivalent(this->_statements[it->second], stmt))
+        {
+            return it->second;
         }
     }
 
-    return true;
+    const uint32_t index = static_cast<uint32_t>(this->_statements.size());
+
+    this->_statements.push_back(stmt);
+    values.emplace(hash, index);
+
+    return index;
 }
 
-bool SSA::build_from_ast(const AST& ast) noexcept
+/* x ^ n by squaring, x ^ (n + 0.5) multiplies it by sqrt(x) */
+uint32_t SSA::add_power(uint32_t base, double exponent, SSAValueTable& values) noexcept
+{
+    uint32_t result = INVALID_STMT_INDEX;
+    uint32_t square = base;
+
+    for(uint64_t n = static_cast<uint64_t>(exponent); n > 0; n >>= 1)
+    {
+        if(n & 1)
+        {
+            result = result == INVALID_STMT_INDEX ?
+                         square :
+                         this->add_statement({ SSAStmtTypeId_BinOp, BinaryOpType_Mul, result, square, 0 }, values);
+        }
+
+        if(n > 1)
+        {
+            square = this->add_statement({ SSAStmtTypeId_BinOp, BinaryOpType_Mul, square, square, 0 }, values);
+        }
+    }
+
+    if(exponent != std::floor(exponent))
+    {
+        const uint32_t root = this->add_statement({ SSAStmtTypeId_UnOp, UnaryOpType_Sqrt, base, 0, 0 }, values);
+
+        result = result == INVALID_STMT_INDEX ?
+                     root :
+                     this->add_statement({ SSAStmtTypeId_BinOp, BinaryOpType_Mul, result, root, 0 }, values);
+    }
+
+    return result;
+}
+
+uint32_t SSA::build_expression(const ASTNode* root, SSAValueTable& values, uint32_t row) noexcept
 {
-    this->_statements.clear();
-    uint64_t version = 0;
     bool no_error = true;
 
-    std::unordered_map<const ASTNode*, SSAStmtPtr> mapping;
+    std::unordered_map<const ASTNode*, uint32_t> mapping;
+
+    auto add_statement = [&](const SSAStmt& stmt) -> uint32_t {
+        return this->add_statement(stmt, values);
+    };
+
+    auto add_unop = [&](uint32_t op, uint32_t operand) -> uint32_t {
+        return add_statement({ SSAStmtTypeId_UnOp, op, operand, 0, 0 });
+    };
+
+    auto add_binop = [&](uint32_t op, uint32_t left, uint32_t right) -> uint32_t {
+        return add_statement({ SSAStmtTypeId_BinOp, op, left, right, 0 });
+    };
+
+    auto add_call = [&](std::string_view name, const std::vector<uint32_t>& arguments) -> uint32_t {
+        SSAStmt call = { SSAStmtTypeId_FuncOp, this->add_name(name), INVALID_STMT_INDEX, INVALID_STMT_INDEX, INVALID_STMT_INDEX };
+
+        std::copy(arguments.begin(), arguments.end(), call.get_arguments());
+
+        return add_statement(call);
+    };
+
+    /* x86_64 can only compare for (in)equality and less than, a > b is lowered as b < a */
+    auto add_comparison = [&](const ASTNodeBinaryOp* comparison) -> uint32_t {
+        const uint32_t left = mapping[comparison->get_left()];
+        const uint32_t right = mapping[comparison->get_right()];
+
+        switch(comparison->get_op())
+        {
+            case BinaryOpType_Gt:
+                return add_binop(BinaryOpType_Lt, right, left);
+            case BinaryOpType_Ge:
+                return add_binop(BinaryOpType_Le, right, left);
+            default:
+                return add_binop(comparison->get_op(), left, right);
+        }
+    };
 
     auto traverse = [&](auto&& self, const ASTNode* node) {
         if(node == nullptr)
@@ -268,12 +365,11 @@ bool SSA::build_from_ast(const AST& ast) noexcept
             {
                 const ASTNodeVariable* variable_node = node_cast<ASTNodeVariable>(node);
 
-                SSAStmtPtr variable = std::make_shared<SSAStmtVariable>(variable_node->get_name(),
-                                                                        version++,
-                                                                        this->get_statement_number());
-
-                this->_statements.push_back(variable);
-                mapping[variable_node] = variable;
+                mapping[variable_node] = add_statement({ SSAStmtTypeId_Variable,
+                                                         this->add_name(variable_node->get_name()),
+                                                         row,
+                                                         0,
+                                                         0 });
 
                 break;
             }
@@ -281,12 +377,11 @@ bool SSA::build_from_ast(const AST& ast) noexcept
             {
                 const ASTNodeLiteral* literal_node = node_cast<ASTNodeLiteral>(node);
 
-                SSAStmtPtr literal = std::make_shared<SSAStmtLiteral>(literal_node->get_name(),
-                                                                      version++,
-                                                                      this->get_statement_number());
-
-                this->_statements.push_back(literal);
-                mapping[literal_node] = literal;
+                mapping[literal_node] = add_statement({ SSAStmtTypeId_Literal,
+                                                        this->add_name(literal_node->get_name()),
+                                                        0,
+                                                        0,
+                                                        0 });
 
                 break;
             }
@@ -303,15 +398,7 @@ bool SSA::build_from_ast(const AST& ast) noexcept
                     return;
                 }
 
-                mapping[unop_node->get_operand()]->get_live_range().end = this->get_statement_number();
-
-                SSAStmtPtr unop = std::make_shared<SSAStmtUnOp>(mapping[unop_node->get_operand()],
-                                                                unop_node->get_op(),
-                                                                version++,
-                                                                this->get_statement_number());
-
-                this->_statements.push_back(unop);
-                mapping[unop_node] = unop;
+                mapping[unop_node] = add_unop(unop_node->get_op(), mapping[unop_node->get_operand()]);
 
                 break;
             }
@@ -319,6 +406,38 @@ bool SSA::build_from_ast(const AST& ast) noexcept
             {
                 const ASTNodeBinaryOp* binop_node = node_cast<ASTNodeBinaryOp>(node);
 
+                if(binop_node->get_op() == BinaryOpType_Pow)
+                {
+                    self(self, binop_node->get_left());
+
+                    if(!mapping.contains(binop_node->get_left()))
+                    {
+                        no_error = false;
+                        return;
+                    }
+
+                    auto exponent = node_cast<ASTNodeLiteral>(binop_node->get_right());
+
+                    if(exponent != nullptr && can_specialize_power(exponent->get_value()))
+                    {
+                        mapping[binop_node] = this->add_power(mapping[binop_node->get_left()], exponent->get_value(), values);
+                        break;
+                    }
+
+                    self(self, binop_node->get_right());
+
+                    if(!mapping.contains(binop_node->get_right()))
+                    {
+                        no_error = false;
+                        return;
+                    }
+
+                    mapping[binop_node] = add_call(POW_FUNCTION_NAME,
+                                                   { mapping[binop_node->get_left()], mapping[binop_node->get_right()] });
+
+                    break;
+                }
+
                 self(self, binop_node->get_left());
                 self(self, binop_node->get_right());
 
@@ -328,17 +447,16 @@ bool SSA::build_from_ast(const AST& ast) noexcept
                     return;
                 }
 
-                mapping[binop_node->get_left()]->get_live_range().end = this->get_statement_number();
-                mapping[binop_node->get_right()]->get_live_range().end = this->get_statement_number();
-
-                SSAStmtPtr binop = std::make_shared<SSAStmtBinOp>(mapping[binop_node->get_left()],
-                                                                  mapping[binop_node->get_right()],
-                                                                  binop_node->get_op(),
-                                                                  version++,
-                                                                  this->get_statement_number());
+                /* Comparisons produce a mask, used as a value it becomes 1.0 or 0.0 */
+                if(op_binary_is_comparison(binop_node->get_op()))
+                {
+                    mapping[binop_node] = add_unop(UnaryOpType_MaskToBool, add_comparison(binop_node));
+                    break;
+                }
 
-                this->_statements.push_back(binop);
-                mapping[binop_node] = binop;
+                mapping[binop_node] = add_binop(binop_node->get_op(),
+                                                mapping[binop_node->get_left()],
+                                                mapping[binop_node->get_right()]);
 
                 break;
             }
@@ -346,12 +464,55 @@ bool SSA::build_from_ast(const AST& ast) noexcept
             {
                 const ASTNodeFunctionOp* funccall_node = node_cast<ASTNodeFunctionOp>(node);
 
+                /*
+                    select(a < b, c, d) is lowered without branches: (mask & c) | (~mask & d), with
+                    mask = a < b. The parser makes sure the condition is a comparison
+                */
+                if(funccall_node->get_function_name() == SELECT_FUNCTION_NAME)
+                {
+                    const auto& arguments = funccall_node->get_arguments();
+                    const ASTNodeBinaryOp* condition = node_cast<ASTNodeBinaryOp>(arguments[0].get());
+
+                    self(self, condition->get_left());
+                    self(self, condition->get_right());
+                    self(self, arguments[1].get());
+                    self(self, arguments[2].get());
+
+                    if(!mapping.contains(condition->get_left()) ||
+                       !mapping.contains(condition->get_right()) ||
+                       !mapping.contains(arguments[1].get()) ||
+                       !mapping.contains(arguments[2].get()))
+                    {
+                        no_error = false;
+                        return;
+                    }
+
+                    const uint32_t mask = add_comparison(condition);
+                    const uint32_t if_true = add_binop(BinaryOpType_And, mask, mapping[arguments[1].get()]);
+                    const uint32_t if_false = add_binop(BinaryOpType_AndNot, mask, mapping[arguments[2].get()]);
+
+                    mapping[funccall_node] = add_binop(BinaryOpType_Or, if_true, if_false);
+
+                    break;
+                }
+
+                if(funccall_node->get_arguments().size() > SSA_MAX_FUNCTION_ARGUMENTS)
+                {
+                    log_error("Function \"{}\" is called with {} arguments, at most {} are supported",
+                              funccall_node->get_function_name(),
+                              funccall_node->get_arguments().size(),
+                              SSA_MAX_FUNCTION_ARGUMENTS);
+
+                    no_error = false;
+                    return;
+                }
+
                 for(const auto& argument : funccall_node->get_arguments())
                 {
                     self(self, argument.get());
                 }
 
-                std::vector<SSAStmtPtr> arguments;
+                std::vector<uint32_t> arguments;
 
                 for(const auto& argument : funccall_node->get_arguments())
                 {
@@ -364,28 +525,153 @@ bool SSA::build_from_ast(const AST& ast) noexcept
                     arguments.push_back(mapping[argument.get()]);
                 }
 
-                for(auto& argument : arguments)
+                mapping[funccall_node] = add_call(funccall_node->get_function_name(), arguments);
+
+                break;
+            }
+            case ASTNodeTypeId_BindingRef:
+            {
+                const ASTNodeBindingRef* ref_node = node_cast<ASTNodeBindingRef>(node);
+
+                /* The bound expression is lowered once, on its first use, and shared by all references */
+                if(!mapping.contains(ref_node->get_value()))
                 {
-                    argument->get_live_range().end = this->get_statement_number();
+                    self(self, ref_node->get_value());
+
+                    if(!mapping.contains(ref_node->get_value()))
+                    {
+                        no_error = false;
+                        return;
+                    }
                 }
 
-                SSAStmtPtr funccall = std::make_shared<SSAStmtFunctionOp>(funccall_node->get_function_name(),
-                                                                          std::move(arguments),
-                                                                          version++,
-                                                                          this->get_statement_number());
+                mapping[ref_node] = mapping[ref_node->get_value()];
 
-                this->_statements.push_back(funccall);
-                mapping[funccall_node] = funccall;
+                break;
             }
-            
             default:
                 break;
         }
     };
 
-    traverse(traverse, ast.get_root());
+    traverse(traverse, root);
+
+    if(!no_error || !mapping.contains(root))
+    {
+        return INVALID_STMT_INDEX;
+    }
+
+    return mapping[root];
+}
+
+bool SSA::build_from_ast(const AST& ast) noexcept
+{
+    this->clear();
+
+    SSAValueTable values;
+
+    const uint32_t result = this->build_expression(ast.get_root(), values);
+
+    if(result == INVALID_STMT_INDEX)
+    {
+        return false;
+    }
+
+    /* The result of a single expression is its last statement */
+    if(result != this->_statements.size() - 1)
+    {
+        this->_statements.push_back(this->_statements[result]);
+    }
+
+    this->calculate_live_ranges();
+
+    return true;
+}
+
+bool SSA::build_from_asts(const std::vector<AST>& asts) noexcept
+{
+    this->clear();
+
+    SSAValueTable values;
+
+    for(const auto [i, ast] : std::views::enumerate(asts))
+    {
+        const uint32_t result = this->build_expression(ast.get_root(), values);
+
+        if(result == INVALID_STMT_INDEX)
+        {
+            log_error("Error while building SSA for expression {} of the group", i);
+            return false;
+        }
+
+        this->_statements.push_back({ SSAStmtTypeId_StoreOp, 0, result, static_cast<uint32_t>(i), 0 });
+    }
+
+    this->calculate_live_ranges();
+
+    return true;
+}
+
+bool SSA::build_reduction_from_ast(const AST& ast, uint32_t unroll) noexcept
+{
+    this->clear();
+
+    auto reduction = node_cast<ASTNodeFunctionOp>(ast.get_root());
+
+    if(reduction == nullptr)
+    {
+        log_error("Expected a reduction (sum, mean or dot) at the root of the expression");
+        return false;
+    }
+
+    const std::string_view name = reduction->get_function_name();
+    const auto& arguments = reduction->get_arguments();
+
+    if(name != SUM_FUNCTION_NAME && name != MEAN_FUNCTION_NAME && name != DOT_FUNCTION_NAME)
+    {
+        log_error("Unknown reduction \"{}\", expected sum, mean or dot", name);
+        return false;
+    }
+
+    const size_t arity = name == DOT_FUNCTION_NAME ? 2 : 1;
+
+    if(arguments.size() != arity)
+    {
+        log_error("Reduction \"{}\" takes {} argument(s), got {}", name, arity, arguments.size());
+        return false;
+    }
+
+    /* Literals and the subexpressions that don't depend on the row are shared by all the rows */
+    SSAValueTable values;
 
-    return no_error;
+    for(uint32_t row = 0; row < unroll; row++)
+    {
+        uint32_t result = this->build_expression(arguments[0].get(), values, row);
+
+        if(result != INVALID_STMT_INDEX && name == DOT_FUNCTION_NAME)
+        {
+            const uint32_t right = this->build_expression(arguments[1].get(), values, row);
+
+            if(right == INVALID_STMT_INDEX)
+            {
+                return false;
+            }
+
+            result = this->add_statement({ SSAStmtTypeId_BinOp, BinaryOpType_Mul, result, right, 0 }, values);
+        }
+
+        if(result == INVALID_STMT_INDEX)
+        {
+            log_error("Error while building SSA for row {} of the reduction", row);
+            return false;
+        }
+
+        this->_statements.push_back({ SSAStmtTypeId_StoreOp, 0, result, row, 1 });
+    }
+
+    this->calculate_live_ranges();
+
+    return true;
 }
 
 MATHEXPR_NAMESPACE_END
\ No newline at end of file
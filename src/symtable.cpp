@@ -4,10 +4,27 @@
 
 #include "mathexpr/symtable.hpp"
 
-#include <queue>
+#include <algorithm>
+#include <bit>
 
 MATHEXPR_NAMESPACE_BEGIN
 
+template<typename T>
+std::vector<const T*> get_symbols_by_id(const std::unordered_map<std::string_view, T>& symbols) noexcept
+{
+    std::vector<const T*> sorted;
+    sorted.reserve(symbols.size());
+
+    for(const auto& [_, symbol] : symbols)
+    {
+        sorted.push_back(&symbol);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const T* a, const T* b) { return a->get_id() < b->get_id(); });
+
+    return sorted;
+}
+
 void SymbolTable::print() const noexcept
 {
     static std::ostream_iterator<char> out(std::cout);
@@ -16,27 +33,27 @@ void SymbolTable::print() const noexcept
 
     std::format_to(out, "VARIABLES ({}):\n", this->_variables.size());
 
-    for(const auto& [name, variable] : this->_variables)
+    for(const SymbolVariable* variable : get_symbols_by_id(this->_variables))
     {
-        std::format_to(out, "    - {} (offset: {})\n", name, variable.get_id() * VALUE_OFFSET);
+        std::format_to(out, "    - {} (offset: {})\n", variable->get_name(), variable->get_offset(this->_value_size));
     }
 
-    std::format_to(out, "LITERALS ({}):\n", this->_literals.size());
+    std::format_to(out, "LITERALS ({}, {} slots):\n", this->_literals.size(), this->get_num_literals());
 
-    for(const auto& [name, value] : this->_literals)
+    for(const SymbolLiteral* literal : get_symbols_by_id(this->_literals))
     {
         std::format_to(out,
                        "    - {} (={}, offset: {}))\n",
-                       name,
-                       value.get_value(),
-                       value.get_id() * VALUE_OFFSET);
+                       literal->get_name(),
+                       literal->get_value(),
+                       literal->get_offset(this->_value_size));
     }
 
     std::format_to(out, "FUNCTIONS ({}):\n", this->_functions.size());
 
-    for(const auto& [name, nodes] : this->_functions)
+    for(const auto& [name, num_calls] : this->_functions)
     {
-        std::format_to(out, "    - {} ({} calls)\n", name, nodes.size());
+        std::format_to(out, "    - {} ({} calls)\n", name, num_calls);
     }
 
     std::format_to(out, "\n");
@@ -46,19 +63,31 @@ void SymbolTable::clear() noexcept
 {
     this->_variables.clear();
     this->_literals.clear();
+    this->_literal_ids.clear();
+    this->_internal_literal_ids.clear();
 }
 
 void SymbolTable::collect(const AST& ast) noexcept
 {
-    size_t variable_id = 0;
-    size_t literal_id = 0;
+    /* Bindings the root expression doesn't reference, even through other bindings, are not compiled */
+    std::unordered_set<const ASTNode*> used_bindings;
 
-    auto pre_order_trav = [&](auto&& self, const ASTNode* current) -> void {
+    auto find_used_bindings = [&](auto&& self, const ASTNode* current) -> void {
         if(current == nullptr)
         {
             return;
         }
 
+        if(auto current_binding_ref = node_cast<ASTNodeBindingRef>(current))
+        {
+            if(used_bindings.insert(current_binding_ref->get_value()).second)
+            {
+                self(self, current_binding_ref->get_value());
+            }
+
+            return;
+        }
+
         auto children = current->get_children();
 
         if(children.has_value())
@@ -68,33 +97,125 @@ void SymbolTable::collect(const AST& ast) noexcept
                 self(self, child);
             }
         }
+    };
 
-        if(auto current_variable = node_cast<ASTNodeVariable>(current))
+    find_used_bindings(find_used_bindings, ast.get_root());
+
+    /* Collecting several expressions (i.e an expression group) keeps numbering their symbols */
+    auto pre_order_trav = [&](auto&& self, const ASTNode* current) -> void {
+        if(current == nullptr)
         {
-            if(!this->_variables.contains(current_variable->get_name()))
+            return;
+        }
+
+        auto children = current->get_children();
+
+        if(children.has_value())
+        {
+            for(auto& child : children.value())
             {
-                this->_variables[current_variable->get_name()] = SymbolVariable(current_variable->get_name(),
-                                                                                variable_id++);
+                self(self, child);
             }
         }
+
+        if(auto current_variable = node_cast<ASTNodeVariable>(current))
+        {
+            this->add_variable(current_variable->get_name());
+        }
         else if(auto current_literal = node_cast<ASTNodeLiteral>(current))
         {
-            if(!this->_literals.contains(current_literal->get_name()))
-            {
-                this->_literals[current_literal->get_name()] = SymbolLiteral(current_literal->get_value(),
-                                                                             current_literal->get_name(),
-                                                                             literal_id++);
-            }
+            this->add_literal(current_literal->get_name(), current_literal->get_value());
         }
         else if(auto current_function_call = node_cast<ASTNodeFunctionOp>(current))
         {
-            this->_functions[current_function_call->get_function_name()].push_back(current_function_call);
+            this->add_function_call(current_function_call->get_function_name());
         }
     };
 
+    for(const auto& binding : ast.get_bindings())
+    {
+        if(used_bindings.contains(binding.value.get()))
+        {
+            pre_order_trav(pre_order_trav, binding.value.get());
+        }
+    }
+
     pre_order_trav(pre_order_trav, ast.get_root());
 }
 
+void SymbolTable::add_variable(std::string_view name) noexcept
+{
+    this->_variables.try_emplace(name, name, this->_variables.size());
+}
+
+void SymbolTable::add_literal(std::string_view name, double value) noexcept
+{
+    const uint64_t bits = std::bit_cast<uint64_t>(value);
+
+    if(name.starts_with(INTERNAL_LITERAL_PREFIX))
+    {
+        const auto [it, _] = this->_internal_literal_ids.try_emplace(bits, this->_internal_literal_ids.size());
+
+        this->_literals.try_emplace(name, value, name, this->_literal_ids.size() + it->second);
+
+        return;
+    }
+
+    const auto [it, inserted] = this->_literal_ids.try_emplace(bits, this->_literal_ids.size());
+
+    /* A new slot for the expression literals moves the internal ones after it */
+    if(inserted)
+    {
+        for(auto& [_, literal] : this->_literals)
+        {
+            if(literal.is_internal())
+            {
+                literal = SymbolLiteral(literal.get_value(), literal.get_name(), literal.get_id() + 1);
+            }
+        }
+    }
+
+    this->_literals.try_emplace(name, value, name, it->second);
+}
+
+void SymbolTable::remove_unused_symbols(const std::unordered_set<std::string_view>& used_names) noexcept
+{
+    std::vector<std::string_view> variables;
+
+    for(const SymbolVariable* variable : get_symbols_by_id(this->_variables))
+    {
+        if(used_names.contains(variable->get_name()))
+        {
+            variables.push_back(variable->get_name());
+        }
+    }
+
+    std::vector<std::pair<std::string_view, double>> literals;
+
+    for(const SymbolLiteral* literal : get_symbols_by_id(this->_literals))
+    {
+        if(used_names.contains(literal->get_name()))
+        {
+            literals.emplace_back(literal->get_name(), literal->get_value());
+        }
+    }
+
+    this->_variables.clear();
+    this->_literals.clear();
+    this->_literal_ids.clear();
+    this->_internal_literal_ids.clear();
+
+    for(const std::string_view name : variables)
+    {
+        this->add_variable(name);
+    }
+
+    for(const auto& [name, value] : literals)
+    {
+        this->add_literal(name, value);
+    }
+}
+
 size_t SymbolTable::get_variable_offset(std::string_view variable_name) const noexcept
 {
     auto it = this->_variables.find(variable_name);
@@ -104,7 +225,7 @@ size_t SymbolTable::get_variable_offset(std::string_view variable_name) const no
         return INVALID_OFFSET;
     }
 
-    return it->second.get_offset();
+    return it->second.get_offset(this->_value_size);
 }
 
 size_t SymbolTable::get_literal_offset(std::string_view literal_name) const noexcept
@@ -116,7 +237,7 @@ size_t SymbolTable::get_literal_offset(std::string_view literal_name) const noex
         return INVALID_OFFSET;
     }
 
-    return it->second.get_offset();
+    return it->second.get_offset(this->_value_size);
 }
 
 MATHEXPR_NAMESPACE_END
\ No newline at end of file
@@ -3,8 +3,13 @@
 // All rights reserved.
 
 #include "mathexpr/x86_64.hpp"
+#include "mathexpr/op.hpp"
 #include "mathexpr/log.hpp"
 
+#include <ranges>
+#include <algorithm>
+#include <cstdlib>
+
 MATHEXPR_NAMESPACE_BEGIN
 
 REGISTER_TARGET(ISA_x86_64, X86_64_CodeGenerator);
@@ -117,14 +122,13 @@ void memloc_as_string(std::string& out,
 
         case MemLocTypeId_Stack:
         {
-            RegisterId stack_register = GpRegisters_x86_64_RBP;
-
             auto stack = memloc_const_cast<Stack>(memloc.get());
 
             std::format_to(std::back_inserter(out),
-                           "[{} - {}]",
-                           gp_register_as_string(stack_register, ISA_x86_64),
-                           stack->get_offset());
+                           "[{} {} {}]",
+                           gp_register_as_string(stack->get_base_ptr_register(), ISA_x86_64),
+                           stack->get_offset() < 0 ? "-" : "+",
+                           std::abs(stack->get_offset()));
 
             break;
         }
@@ -142,6 +146,28 @@ void memloc_as_string(std::string& out,
 
             break;
         }
+
+        case MemLocTypeId_Constant:
+        {
+            auto constant = memloc_const_cast<Constant>(memloc.get());
+
+            std::format_to(std::back_inserter(out), "[rip + constants + {}]", constant->get_offset());
+
+            break;
+        }
+
+        case MemLocTypeId_Column:
+        {
+            auto column = memloc_const_cast<Column>(memloc.get());
+
+            std::format_to(std::back_inserter(out),
+                           "[[{} + {}] + {}]",
+                           gp_register_as_string(column->get_base_ptr_register(), ISA_x86_64),
+                           column->get_pointer_offset(),
+                           column->get_element_offset());
+
+            break;
+        }
     }
 }
 
@@ -175,7 +201,9 @@ std::byte memloc_as_m_byte(const MemLocPtr& memloc) noexcept
 
         case MemLocTypeId_Stack:
         {
-            return RBP;
+            auto stack = memloc_const_cast<Stack>(memloc.get());
+
+            return encode_platform_gp_register(stack->get_base_ptr_register());
         }
 
         case MemLocTypeId_Memory:
@@ -185,6 +213,12 @@ std::byte memloc_as_m_byte(const MemLocPtr& memloc) noexcept
             return encode_platform_gp_register(mem->get_base_ptr_register());
         }
 
+        /* rbp as base without a displacement means rip-relative */
+        case MemLocTypeId_Constant:
+        {
+            return RBP;
+        }
+
         default:
             return BYTE(0);
     }
@@ -195,234 +229,376 @@ std::byte encode_sib(uint8_t scale, uint8_t index, uint8_t base) noexcept
     return BYTE(((scale & 0x3) << 6) | ((index & 0x7) << 3) | (base & 0x7));
 }
 
-using ModRmSibOffset = std::tuple<std::byte, std::optional<std::byte>, std::byte>;
-
-ModRmSibOffset memloc_as_modrm_sib_offset(MemLocPtr from,
-                                          MemLocPtr to) noexcept
+/*
+    Encodes the ModR/M byte, the optional SIB byte and the displacement of an instruction working on
+    an xmm register (reg field) and a register or memory operand (r/m field). Displacements are
+    encoded on 8 bits when they fit, on 32 bits otherwise
+*/
+void encode_modrm_sib_disp(ByteCode& out,
+                           const MemLocPtr& reg,
+                           const MemLocPtr& rm) noexcept
 {
-    switch(from->type_id())
+    const std::byte r_byte = memloc_as_r_byte(reg);
+    const std::byte m_byte = memloc_as_m_byte(rm);
+
+    int64_t displacement = 0;
+
+    switch(rm->type_id())
     {
         case MemLocTypeId_Register:
         {
-            switch(to->type_id())
-            {
-                case MemLocTypeId_Register:
-                {
-                    const std::byte modrm = x86_64::MOD_DIRECT |
-                                            memloc_as_r_byte(to) |
-                                            memloc_as_m_byte(from);
-
-                    return std::make_tuple(modrm, std::nullopt, BYTE(0));
-                }
-
-                case MemLocTypeId_Stack:
-                {
-                    auto stack = memloc_cast<Stack>(to.get());
-
-                    const std::byte m_byte = memloc_as_m_byte(to);
-
-                    const std::byte modrm = x86_64::MOD_INDIRECT_DISP8 |
-                                            memloc_as_r_byte(from) |
-                                            m_byte;
-
-                    /* We need to add the sib byte when using RSP as the base register */
-                    if(m_byte == RSP)
-                    {
-                        /* scale=1, index=none (100), base=RSP (100) = 0x24 */
-                        const std::byte sib = encode_sib(0, 4, 4);
-
-                        return std::make_tuple(modrm, sib, BYTE(stack->get_offset() - 8));
-                    }
-
-                    return std::make_tuple(modrm, std::nullopt, BYTE(stack->get_signed_offset()));
-                }
+            out.push_back(x86_64::MOD_DIRECT | r_byte | m_byte);
+            return;
+        }
 
-                case MemLocTypeId_Memory:
-                {
-                    auto memory = memloc_cast<Memory>(to.get());
+        /* Displacement is patched by the code generator once the constant pool is placed */
+        case MemLocTypeId_Constant:
+        {
+            out.push_back(x86_64::MOD_INDIRECT | r_byte | m_byte);
 
-                    const std::byte mod = memory->get_offset() > 0 ? x86_64::MOD_INDIRECT_DISP8 :
-                                                                     x86_64::MOD_INDIRECT;
-                    const std::byte modrm = mod |
-                                            memloc_as_r_byte(from) |
-                                            memloc_as_m_byte(to);
+            for(uint8_t i = 0; i < 4; i++)
+                out.push_back(BYTE(0));
 
-                    return std::make_tuple(modrm, std::nullopt, BYTE(memory->get_offset()));
-                }
-            }
+            return;
+        }
 
+        case MemLocTypeId_Stack:
+        {
+            displacement = memloc_const_cast<Stack>(rm.get())->get_offset();
             break;
         }
 
-        case MemLocTypeId_Stack:
+        case MemLocTypeId_Memory:
         {
-            switch(to->type_id())
-            {
-                case MemLocTypeId_Register:
-                {
-                    auto stack = memloc_cast<Stack>(from.get());
+            displacement = static_cast<int64_t>(memloc_const_cast<Memory>(rm.get())->get_offset());
+            break;
+        }
+    }
 
-                    const std::byte m_byte = memloc_as_m_byte(from);
+    std::byte mod = x86_64::MOD_INDIRECT_DISP32;
 
-                    const std::byte modrm = x86_64::MOD_INDIRECT_DISP8 |
-                                            memloc_as_r_byte(to) |
-                                            m_byte;
+    /* [rbp] and [r13] without displacement mean rip-relative addressing, they need a disp8 of 0 */
+    if(displacement == 0 && m_byte != RBP)
+        mod = x86_64::MOD_INDIRECT;
+    else if(displacement >= INT8_MIN && displacement <= INT8_MAX)
+        mod = x86_64::MOD_INDIRECT_DISP8;
 
-                    /* We need to add the sib byte when using RSP as the base register */
-                    if(m_byte == RSP)
-                    {
-                        /* scale=1, index=none (100), base=RSP (100) = 0x24 */
-                        const std::byte sib = encode_sib(0, 4, 4);
+    out.push_back(mod | r_byte | m_byte);
 
-                        return std::make_tuple(modrm, sib, BYTE(stack->get_offset() - 8));
-                    }
+    /* We need to add the sib byte when using RSP (or R12) as the base register */
+    if(m_byte == RSP)
+    {
+        /* scale=1, index=none (100), base=RSP (100) = 0x24 */
+        out.push_back(encode_sib(0, 4, 4));
+    }
 
-                    return std::make_tuple(modrm, std::nullopt, BYTE(stack->get_signed_offset()));
-                }
-            }
+    if(mod == x86_64::MOD_INDIRECT_DISP8)
+    {
+        out.push_back(BYTE(displacement & 0xFF));
+    }
+    else if(mod == x86_64::MOD_INDIRECT_DISP32)
+    {
+        for(uint8_t i = 0; i < 4; i++)
+            out.push_back(BYTE((displacement >> (i * 8)) & 0xFF));
+    }
+}
 
-            break;
-        }
+/*
+    Instructions reading a constant end with its 32 bits displacement, followed by immediate_size
+    bytes of immediate. The code generator computes it relative to the end of the instruction
+*/
+RelocInfo constant_link_info(const MemLocPtr& rm,
+                             std::size_t bytecode_end,
+                             std::size_t immediate_size = 0) noexcept
+{
+    RelocInfo info;
+    info.bytecode_offset = bytecode_end - immediate_size - 4;
+    info.instruction_end = bytecode_end;
+    info.reloc_type = RelocType_Constant32;
+    info.constant_offset = memloc_const_cast<Constant>(rm.get())->get_offset();
 
-        case MemLocTypeId_Memory:
-        {
-            switch(to->type_id())
-            {
-                case MemLocTypeId_Register:
-                {
-                    auto memory = memloc_cast<Memory>(from.get());
+    return info;
+}
+
+/*
+    Encodes the ModR/M byte, the optional SIB byte and the displacement of an instruction working on
+    a general purpose register or an opcode extension (reg field) and a [base + displacement] operand
+*/
+void encode_gp_modrm_disp(ByteCode& out,
+                          std::byte reg,
+                          std::byte base,
+                          int64_t displacement) noexcept
+{
+    std::byte mod = x86_64::MOD_INDIRECT_DISP32;
 
-                    const std::byte mod = memory->get_offset() > 0 ? x86_64::MOD_INDIRECT_DISP8 :
-                                                                     x86_64::MOD_INDIRECT;
-                    const std::byte modrm = mod |
-                                            memloc_as_r_byte(to) |
-                                            memloc_as_m_byte(from);
+    if(displacement == 0 && base != RBP)
+        mod = x86_64::MOD_INDIRECT;
+    else if(displacement >= INT8_MIN && displacement <= INT8_MAX)
+        mod = x86_64::MOD_INDIRECT_DISP8;
 
-                    return std::make_tuple(modrm, std::nullopt, BYTE(memory->get_offset()));
-                }
-            }
+    out.push_back(mod | (reg << 3) | base);
 
-            break;
-        }
+    if(base == RSP)
+        out.push_back(encode_sib(0, 4, 4));
+
+    if(mod == x86_64::MOD_INDIRECT_DISP8)
+    {
+        out.push_back(BYTE(displacement & 0xFF));
+    }
+    else if(mod == x86_64::MOD_INDIRECT_DISP32)
+    {
+        for(uint8_t i = 0; i < 4; i++)
+            out.push_back(BYTE((displacement >> (i * 8)) & 0xFF));
     }
+}
 
-    return std::make_tuple(BYTE(0), std::nullopt, BYTE(0));
+/* Encodes an immediate on 8 bits when it fits (opcode 0x83), on 32 bits otherwise (opcode 0x81) */
+bool is_imm8(uint64_t immediate) noexcept
+{
+    return immediate <= static_cast<uint64_t>(INT8_MAX);
 }
 
-bool modrm_has_displace(const std::byte modrm_byte) noexcept
+void encode_imm(ByteCode& out, uint64_t immediate) noexcept
 {
-    const std::byte mod = modrm_byte & BYTE(0xC0);
+    const uint8_t size = is_imm8(immediate) ? 1 : 4;
+
+    for(uint8_t i = 0; i < size; i++)
+        out.push_back(BYTE((immediate >> (i * 8)) & 0xFF));
+}
 
-    return mod == x86_64::MOD_INDIRECT_DISP8 || mod == x86_64::MOD_INDIRECT_DISP32;
+/* Column elements are read from their column pointer, loaded in rax (only used by calls otherwise) */
+MemLocPtr load_column_pointer(ByteCode& out, const Column* column) noexcept
+{
+    out.push_back(REX_BASE | REX_W);
+    out.push_back(BYTE(0x8B));
+    encode_gp_modrm_disp(out,
+                         RAX,
+                         encode_platform_gp_register(column->get_base_ptr_register()),
+                         static_cast<int64_t>(column->get_pointer_offset()));
+
+    return std::make_shared<Memory>(GpRegisters_x86_64_RAX, column->get_element_offset());
 }
 
 /* Memory instructions */
 
 void InstrMov::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "movsd ");
+    MemLocPtr from = this->_mem_loc_from;
+
+    if(auto column = memloc_const_cast<Column>(from.get()))
+    {
+        std::format_to(std::back_inserter(out),
+                       "mov rax, [{} + {}]\n",
+                       gp_register_as_string(column->get_base_ptr_register(), ISA_x86_64),
+                       column->get_pointer_offset());
+
+        from = std::make_shared<Memory>(GpRegisters_x86_64_RAX, column->get_element_offset());
+    }
+
+    std::format_to(std::back_inserter(out), "mov{} ", this->get_scalar_suffix());
     memloc_as_string(out, this->_mem_loc_to);
     std::format_to(std::back_inserter(out), ", ");
-    memloc_as_string(out, this->_mem_loc_from);
+    memloc_as_string(out, from);
 }
 
 void InstrMov::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xF2)); /* Prefix */
+    MemLocPtr from = this->_mem_loc_from;
+
+    if(auto column = memloc_const_cast<Column>(from.get()))
+        from = load_column_pointer(out, column);
+
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
     out.push_back(BYTE(0x0F));
 
     if(this->_mem_loc_to->type_id() == MemLocTypeId_Register)
     {
         out.push_back(BYTE(0x10));
+        encode_modrm_sib_disp(out, this->_mem_loc_to, from);
     }
     else
     {
         out.push_back(BYTE(0x11));
+        encode_modrm_sib_disp(out, from, this->_mem_loc_to);
     }
+}
 
-    auto [mod_rm_byte, sib, offset] = memloc_as_modrm_sib_offset(this->_mem_loc_from,
-                                                                 this->_mem_loc_to);
+RelocInfo InstrMov::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    return constant_link_info(this->_mem_loc_from, bytecode_end);
+}
+
+/* Encodes add/sub rsp, imm with the shortest immediate, opcode_ext is 0 for add and 5 for sub */
+void encode_rsp_adjust(ByteCode& out, std::byte opcode_ext, uint32_t size) noexcept
+{
+    out.push_back(x86_64::REX_BASE | x86_64::REX_W); /* REX.W prefix */
+
+    if(size > 127)
+        out.push_back(BYTE(0x81)); /* imm32 */
+    else
+        out.push_back(BYTE(0x83)); /* imm8 */
 
-    out.push_back(mod_rm_byte);
+    out.push_back(x86_64::MOD_DIRECT | (opcode_ext << 3) | RSP);
 
-    if(sib.has_value())
+    if(size > 127)
     {
-        out.push_back(sib.value());
+        out.push_back(BYTE(size & 0xFF));
+        out.push_back(BYTE((size >> 8) & 0xFF));
+        out.push_back(BYTE((size >> 16) & 0xFF));
+        out.push_back(BYTE((size >> 24) & 0xFF));
     }
-
-    if(modrm_has_displace(mod_rm_byte))
+    else
     {
-        out.push_back(offset);
+        out.push_back(BYTE(size));
     }
 }
 
 void InstrPrologue::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "push rbp\n");
-    std::format_to(std::back_inserter(out), "mov rbp, rsp\n");
-    std::format_to(std::back_inserter(out), "sub rsp, {}", this->_stack_size);
+    if(this->_frame_pointer)
+    {
+        std::format_to(std::back_inserter(out), "push rbp\n");
+        std::format_to(std::back_inserter(out), "mov rbp, rsp\n");
+        std::format_to(std::back_inserter(out), "sub rsp, {}", this->_stack_size + 8);
+    }
+    else
+    {
+        std::format_to(std::back_inserter(out), "sub rsp, {}", this->_stack_size);
+    }
 }
 
 void InstrPrologue::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0x55)); /* push rbp */
-
-    out.push_back(BYTE(0x48)); /* mov rbp, rsp */
-    out.push_back(BYTE(0x89));
-    out.push_back(BYTE(0xE5));
-
-    out.push_back(x86_64::REX_BASE | x86_64::REX_W); /* REX.W prefix */
-
-    if(this->_stack_size > 127)
-        out.push_back(BYTE(0x81)); /* sub with single-byte immediate (imm32) */
-    else
-        out.push_back(BYTE(0x83)); /* sub with single-byte immediate (imm8) */
-
-    out.push_back(BYTE(0xEC)); /* rsp */
+    if(this->_frame_pointer)
+    {
+        out.push_back(BYTE(0x55)); /* push rbp */
 
-    /* push rbp adds 8 bytes to rsp and misaligns the stack (we need it to be 16 bytes aligned) */
-    const uint32_t stack_size = static_cast<uint32_t>(this->_stack_size) + 8;
+        out.push_back(BYTE(0x48)); /* mov rbp, rsp */
+        out.push_back(BYTE(0x89));
+        out.push_back(BYTE(0xE5));
 
-    if(this->_stack_size > 127)
-    {
-        out.push_back(BYTE(stack_size & 0xFF));
-        out.push_back(BYTE((stack_size >> 8) & 0xFF));
-        out.push_back(BYTE((stack_size >> 16) & 0xFF));
-        out.push_back(BYTE((stack_size >> 24) & 0xFF));
+        /* push rbp adds 8 bytes to rsp and misaligns the stack (we need it to be 16 bytes aligned) */
+        encode_rsp_adjust(out, BYTE(5), static_cast<uint32_t>(this->_stack_size) + 8);
     }
     else
     {
-        out.push_back(BYTE(stack_size));
+        /* stack size is a multiple of 16, rsp keeps the alignment it had on entry */
+        encode_rsp_adjust(out, BYTE(5), static_cast<uint32_t>(this->_stack_size));
     }
 }
 
 void InstrEpilogue::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "leave");
+    if(this->_frame_pointer)
+        std::format_to(std::back_inserter(out), "leave");
+    else
+        std::format_to(std::back_inserter(out), "add rsp, {}", this->_stack_size);
 }
 
 void InstrEpilogue::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xC9));
+    if(this->_frame_pointer)
+        out.push_back(BYTE(0xC9)); /* leave */
+    else
+        encode_rsp_adjust(out, BYTE(0), static_cast<uint32_t>(this->_stack_size));
 }
 
 /* Unary ops instructions */
 
 void InstrNeg::as_string(std::string& out) const noexcept
 {
-
+    std::format_to(std::back_inserter(out), "xor{} ", this->get_packed_suffix());
+    memloc_as_string(out, this->_operand);
+    std::format_to(std::back_inserter(out), ", [rip + sign_mask]");
 }
 
 void InstrNeg::as_bytecode(ByteCode& out) const noexcept
 {
+    /* The displacement to the sign mask is patched like the ones to the constant pool */
+    static const MemLocPtr sign_mask = std::make_shared<Constant>(0);
+
+    /* xorpd/xorps xmm, m128 */
+    this->encode_packed_prefix(out);
+    out.push_back(BYTE(0x0F));
+    out.push_back(BYTE(0x57));
+
+    encode_modrm_sib_disp(out, this->_operand, sign_mask);
+}
+
+RelocInfo InstrNeg::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    RelocInfo info;
+    info.bytecode_offset = bytecode_end - 4;
+    info.instruction_end = bytecode_end;
+    info.reloc_type = RelocType_SignMask32;
+
+    return info;
+}
+
+/* Shift amounts turning an all-ones mask into 1.0: sign and exponent bits minus one, then mantissa bits */
+std::tuple<uint8_t, uint8_t> mask_to_bool_shifts(uint32_t value_type) noexcept
+{
+    return value_type == ValueType_Float32 ? std::tuple<uint8_t, uint8_t>(25, 23) :
+                                             std::tuple<uint8_t, uint8_t>(54, 52);
+}
+
+void InstrMaskToBool::as_string(std::string& out) const noexcept
+{
+    const auto [right_shift, left_shift] = mask_to_bool_shifts(this->get_value_type());
+    const char element = this->get_value_type() == ValueType_Float32 ? 'd' : 'q';
+
+    std::format_to(std::back_inserter(out), "psrl{} ", element);
+    memloc_as_string(out, this->_operand);
+    std::format_to(std::back_inserter(out), ", {}\npsll{} ", right_shift, element);
+    memloc_as_string(out, this->_operand);
+    std::format_to(std::back_inserter(out), ", {}", left_shift);
+}
+
+void InstrMaskToBool::as_bytecode(ByteCode& out) const noexcept
+{
+    const std::byte reg = memloc_as_m_byte(this->_operand);
+    const auto [right_shift, left_shift] = mask_to_bool_shifts(this->get_value_type());
+
+    /* psrlq and psllq on 64 bits elements, psrld and pslld on 32 bits elements */
+    const std::byte opcode = this->get_value_type() == ValueType_Float32 ? BYTE(0x72) : BYTE(0x73);
+
+    /* psrl xmm, imm8 */
+    out.push_back(BYTE(0x66)); /* Prefix */
+    out.push_back(BYTE(0x0F));
+    out.push_back(opcode);
+    out.push_back(x86_64::MOD_DIRECT | (BYTE(2) << 3) | reg);
+    out.push_back(BYTE(right_shift));
+
+    /* psll xmm, imm8 */
+    out.push_back(BYTE(0x66));
+    out.push_back(BYTE(0x0F));
+    out.push_back(opcode);
+    out.push_back(x86_64::MOD_DIRECT | (BYTE(6) << 3) | reg);
+    out.push_back(BYTE(left_shift));
+}
+
+void InstrSqrt::as_string(std::string& out) const noexcept
+{
+    std::format_to(std::back_inserter(out), "sqrt{} ", this->get_scalar_suffix());
+    memloc_as_string(out, this->_operand);
+    std::format_to(std::back_inserter(out), ", ");
+    memloc_as_string(out, this->_operand);
+}
+
+void InstrSqrt::as_bytecode(ByteCode& out) const noexcept
+{
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
+    out.push_back(BYTE(0x0F));
+    out.push_back(BYTE(0x51));
 
+    encode_modrm_sib_disp(out, this->_operand, this->_operand);
 }
 
 /* Binary ops instructions */
 
 void InstrAdd::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "addsd ");
+    std::format_to(std::back_inserter(out), "add{} ", this->get_scalar_suffix());
     memloc_as_string(out, this->_left);
     std::format_to(std::back_inserter(out), ", ");
     memloc_as_string(out, this->_right);
@@ -430,29 +606,21 @@ void InstrAdd::as_string(std::string& out) const noexcept
 
 void InstrAdd::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xF2)); /* Prefix */
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
     out.push_back(BYTE(0x0F));
     out.push_back(BYTE(0x58));
 
-    auto [mod_reg_rm_byte, sib, offset] = memloc_as_modrm_sib_offset(this->_right,
-                                                                     this->_left);
-
-    out.push_back(mod_reg_rm_byte);
-
-    if(sib.has_value())
-    {
-        out.push_back(sib.value());
-    }
+    encode_modrm_sib_disp(out, this->_left, this->_right);
+}
 
-    if(offset > BYTE(0) || modrm_has_displace(mod_reg_rm_byte))
-    {
-        out.push_back(offset);
-    }
+RelocInfo InstrAdd::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    return constant_link_info(this->_right, bytecode_end);
 }
 
 void InstrSub::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "subsd ");
+    std::format_to(std::back_inserter(out), "sub{} ", this->get_scalar_suffix());
     memloc_as_string(out, this->_left);
     std::format_to(std::back_inserter(out), ", ");
     memloc_as_string(out, this->_right);
@@ -460,29 +628,21 @@ void InstrSub::as_string(std::string& out) const noexcept
 
 void InstrSub::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xF2)); /* Prefix */
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
     out.push_back(BYTE(0x0F));
     out.push_back(BYTE(0x5C));
 
-    auto [mod_reg_rm_byte, sib, offset] = memloc_as_modrm_sib_offset(this->_right,
-                                                                     this->_left);
-
-    out.push_back(mod_reg_rm_byte);
-
-    if(sib.has_value())
-    {
-        out.push_back(sib.value());
-    }
+    encode_modrm_sib_disp(out, this->_left, this->_right);
+}
 
-    if(offset > BYTE(0) || modrm_has_displace(mod_reg_rm_byte))
-    {
-        out.push_back(offset);
-    }
+RelocInfo InstrSub::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    return constant_link_info(this->_right, bytecode_end);
 }
 
 void InstrMul::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "mulsd ");
+    std::format_to(std::back_inserter(out), "mul{} ", this->get_scalar_suffix());
     memloc_as_string(out, this->_left);
     std::format_to(std::back_inserter(out), ", ");
     memloc_as_string(out, this->_right);
@@ -490,29 +650,21 @@ void InstrMul::as_string(std::string& out) const noexcept
 
 void InstrMul::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xF2)); /* Prefix */
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
     out.push_back(BYTE(0x0F));
     out.push_back(BYTE(0x59));
 
-    auto [mod_reg_rm_byte, sib, offset] = memloc_as_modrm_sib_offset(this->_right,
-                                                                     this->_left);
-
-    out.push_back(mod_reg_rm_byte);
-
-    if(sib.has_value())
-    {
-        out.push_back(sib.value());
-    }
+    encode_modrm_sib_disp(out, this->_left, this->_right);
+}
 
-    if(offset > BYTE(0) || modrm_has_displace(mod_reg_rm_byte))
-    {
-        out.push_back(offset);
-    }
+RelocInfo InstrMul::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    return constant_link_info(this->_right, bytecode_end);
 }
 
 void InstrDiv::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "divsd ");
+    std::format_to(std::back_inserter(out), "div{} ", this->get_scalar_suffix());
     memloc_as_string(out, this->_left);
     std::format_to(std::back_inserter(out), ", ");
     memloc_as_string(out, this->_right);
@@ -520,125 +672,1078 @@ void InstrDiv::as_string(std::string& out) const noexcept
 
 void InstrDiv::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xF2)); /* Prefix */
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
     out.push_back(BYTE(0x0F));
     out.push_back(BYTE(0x5E));
 
-    auto [mod_reg_rm_byte, sib, offset] = memloc_as_modrm_sib_offset(this->_right,
-                                                                     this->_left);
+    encode_modrm_sib_disp(out, this->_left, this->_right);
+}
 
-    out.push_back(mod_reg_rm_byte);
+RelocInfo InstrDiv::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    return constant_link_info(this->_right, bytecode_end);
+}
 
-    if(sib.has_value())
+/* Comparison predicate encoded in the imm8 of cmpsd and cmpss */
+uint8_t cmp_predicate(uint32_t op) noexcept
+{
+    switch(op)
     {
-        out.push_back(sib.value());
+        case BinaryOpType_Eq:
+            return 0;
+        case BinaryOpType_Lt:
+            return 1;
+        case BinaryOpType_Le:
+            return 2;
+        case BinaryOpType_Neq:
+            return 4;
+        default:
+            return 0;
     }
+}
 
-    if(offset > BYTE(0) || modrm_has_displace(mod_reg_rm_byte))
+const char* cmp_predicate_as_string(uint32_t op) noexcept
+{
+    switch(op)
     {
-        out.push_back(offset);
+        case BinaryOpType_Eq:
+            return "eq";
+        case BinaryOpType_Lt:
+            return "lt";
+        case BinaryOpType_Le:
+            return "le";
+        case BinaryOpType_Neq:
+            return "neq";
+        default:
+            return "?";
     }
 }
 
-/* Func ops instructions */
-
-void InstrCall::as_string(std::string& out) const noexcept
+void InstrCmp::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "call {}", this->_call_name);
+    std::format_to(std::back_inserter(out),
+                   "cmp{}{} ",
+                   cmp_predicate_as_string(this->_op),
+                   this->get_scalar_suffix());
+    memloc_as_string(out, this->_left);
+    std::format_to(std::back_inserter(out), ", ");
+    memloc_as_string(out, this->_right);
 }
 
-void InstrCall::as_bytecode(ByteCode& out) const noexcept
+void InstrCmp::as_bytecode(ByteCode& out) const noexcept
 {
-    /* MEMO: On Windows, we need to allocate 32 bytes of shadow space on the stack */
-    /* mov rax, imm64 */
-    out.push_back(BYTE(0x48));
-    out.push_back(BYTE(0xB8));
+    out.push_back(this->get_scalar_prefix()); /* Prefix */
+    out.push_back(BYTE(0x0F));
+    out.push_back(BYTE(0xC2));
 
-    for(uint8_t i = 0; i < 8; i++)
-        out.push_back(BYTE(0x00));
+    encode_modrm_sib_disp(out, this->_left, this->_right);
 
-    /* call rax */
-    out.push_back(BYTE(0xFF));
-    out.push_back(BYTE(0xD0));
+    out.push_back(BYTE(cmp_predicate(this->_op)));
 }
 
-RelocInfo InstrCall::get_link_info(std::size_t bytecode_start) const noexcept
+RelocInfo InstrCmp::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
 {
-    RelocInfo info;
-    info.symbol_name = this->_call_name;
-    info.bytecode_offset = bytecode_start + 2;
-    info.reloc_type = RelocType_Abs64;
-
-    return info;
+    return constant_link_info(this->_right, bytecode_end, 1);
 }
 
-/* Terminator instructions */
-
-void InstrRet::as_string(std::string& out) const noexcept
+void InstrAnd::as_string(std::string& out) const noexcept
 {
-    std::format_to(std::back_inserter(out), "ret");
+    std::format_to(std::back_inserter(out), "and{} ", this->get_packed_suffix());
+    memloc_as_string(out, this->_left);
+    std::format_to(std::back_inserter(out), ", ");
+    memloc_as_string(out, this->_right);
 }
 
-void InstrRet::as_bytecode(ByteCode& out) const noexcept
+void InstrAnd::as_bytecode(ByteCode& out) const noexcept
 {
-    out.push_back(BYTE(0xC3));
-}
-
-X86_64_NAMESPACE_END
+    this->encode_packed_prefix(out);
+    out.push_back(BYTE(0x0F));
+    out.push_back(BYTE(0x54));
 
-InstrPtr X86_64_CodeGenerator::create_mov(MemLocPtr& from, MemLocPtr& to)
-{
-    return std::make_shared<x86_64::InstrMov>(from, to);
+    encode_modrm_sib_disp(out, this->_left, this->_right);
 }
 
-InstrPtr X86_64_CodeGenerator::create_prologue(uint64_t stack_size)
+void InstrAndNot::as_string(std::string& out) const noexcept
 {
-    return std::make_shared<x86_64::InstrPrologue>(stack_size);
+    std::format_to(std::back_inserter(out), "andn{} ", this->get_packed_suffix());
+    memloc_as_string(out, this->_left);
+    std::format_to(std::back_inserter(out), ", ");
+    memloc_as_string(out, this->_right);
 }
 
-InstrPtr X86_64_CodeGenerator::create_epilogue(uint64_t stack_size)
+void InstrAndNot::as_bytecode(ByteCode& out) const noexcept
 {
-    return std::make_shared<x86_64::InstrEpilogue>(stack_size);
-}
+    this->encode_packed_prefix(out);
+    out.push_back(BYTE(0x0F));
+    out.push_back(BYTE(0x55));
 
-InstrPtr X86_64_CodeGenerator::create_neg(MemLocPtr& operand)
-{
-    return std::make_shared<x86_64::InstrNeg>(operand);
+    encode_modrm_sib_disp(out, this->_left, this->_right);
 }
 
-InstrPtr X86_64_CodeGenerator::create_add(MemLocPtr& left, MemLocPtr& right)
+void InstrOr::as_string(std::string& out) const noexcept
 {
-    return std::make_shared<x86_64::InstrAdd>(left, right);
+    std::format_to(std::back_inserter(out), "or{} ", this->get_packed_suffix());
+    memloc_as_string(out, this->_left);
+    std::format_to(std::back_inserter(out), ", ");
+    memloc_as_string(out, this->_right);
 }
 
-InstrPtr X86_64_CodeGenerator::create_sub(MemLocPtr& left, MemLocPtr& right)
+void InstrOr::as_bytecode(ByteCode& out) const noexcept
 {
-    return std::make_shared<x86_64::InstrSub>(left, right);
-}
+    this->encode_packed_prefix(out);
+    out.push_back(BYTE(0x0F));
+    out.push_back(BYTE(0x56));
 
-InstrPtr X86_64_CodeGenerator::create_mul(MemLocPtr& left, MemLocPtr& right)
-{
-    return std::make_shared<x86_64::InstrMul>(left, right);
+    encode_modrm_sib_disp(out, this->_left, this->_right);
 }
 
-InstrPtr X86_64_CodeGenerator::create_div(MemLocPtr& left, MemLocPtr& right)
-{
-    return std::make_shared<x86_64::InstrDiv>(left, right);
-}
+/* Func ops instructions */
 
-InstrPtr X86_64_CodeGenerator::create_call(std::string_view call_name)
+std::size_t InstrCall::get_preserved_registers_size() const noexcept
 {
-    return std::make_shared<x86_64::InstrCall>(call_name);
+    std::size_t size = 0;
+
+    for(const RegisterId reg : this->_preserved_registers)
+    {
+        size += reg >= GpRegisters_x86_64_R8 ? 2 : 1;
+    }
+
+    return size;
 }
 
-InstrPtr X86_64_CodeGenerator::create_ret()
+void InstrCall::as_string(std::string& out) const noexcept
+{
+    if(this->_save)
+    {
+        for(const RegisterId reg : this->_preserved_registers)
+        {
+            std::format_to(std::back_inserter(out), "push {}\n", gp_register_as_string(reg, ISA_x86_64));
+        }
+
+        if(this->_stack_adjust > 0)
+        {
+            std::format_to(std::back_inserter(out), "sub rsp, {}\n", this->_stack_adjust);
+        }
+    }
+
+    std::format_to(std::back_inserter(out), "call {}", this->_call_name);
+
+    if(this->_restore)
+    {
+        if(this->_stack_adjust > 0)
+        {
+            std::format_to(std::back_inserter(out), "\nadd rsp, {}", this->_stack_adjust);
+        }
+
+        for(const RegisterId reg : std::views::reverse(this->_preserved_registers))
+        {
+            std::format_to(std::back_inserter(out), "\npop {}", gp_register_as_string(reg, ISA_x86_64));
+        }
+    }
+}
+
+void InstrCall::as_bytecode(ByteCode& out) const noexcept
+{
+    if(this->_save)
+    {
+        /* push r64 */
+        for(const RegisterId reg : this->_preserved_registers)
+        {
+            if(reg >= GpRegisters_x86_64_R8)
+                out.push_back(REX_BASE | REX_B);
+
+            out.push_back(BYTE(0x50) | encode_platform_gp_register(reg));
+        }
+
+        /* sub rsp, imm8 */
+        if(this->_stack_adjust > 0)
+        {
+            out.push_back(REX_BASE | REX_W);
+            out.push_back(BYTE(0x83));
+            out.push_back(BYTE(0xEC));
+            out.push_back(BYTE(this->_stack_adjust));
+        }
+    }
+
+    /* mov rax, imm64 */
+    out.push_back(BYTE(0x48));
+    out.push_back(BYTE(0xB8));
+
+    for(uint8_t i = 0; i < 8; i++)
+        out.push_back(BYTE(0x00));
+
+    /* call rax */
+    out.push_back(BYTE(0xFF));
+    out.push_back(BYTE(0xD0));
+
+    if(this->_restore)
+    {
+        /* add rsp, imm8 */
+        if(this->_stack_adjust > 0)
+        {
+            out.push_back(REX_BASE | REX_W);
+            out.push_back(BYTE(0x83));
+            out.push_back(BYTE(0xC4));
+            out.push_back(BYTE(this->_stack_adjust));
+        }
+
+        /* pop r64 */
+        for(const RegisterId reg : std::views::reverse(this->_preserved_registers))
+        {
+            if(reg >= GpRegisters_x86_64_R8)
+                out.push_back(REX_BASE | REX_B);
+
+            out.push_back(BYTE(0x58) | encode_platform_gp_register(reg));
+        }
+    }
+}
+
+RelocInfo InstrCall::get_link_info(std::size_t bytecode_start, std::size_t bytecode_end) const noexcept
+{
+    std::size_t save_size = 0;
+
+    if(this->_save)
+    {
+        save_size = this->get_preserved_registers_size() + (this->_stack_adjust > 0 ? 4 : 0);
+    }
+
+    RelocInfo info;
+    info.symbol_name = this->_call_name;
+    info.bytecode_offset = bytecode_start + save_size + 2;
+    info.reloc_type = RelocType_Abs64;
+
+    return info;
+}
+
+/* Reduction loops instructions */
+
+/* Offsets in the block of the reduction, relative to the stack pointer, see InstrReductionBegin */
+uint64_t reduction_remaining_rows_offset(uint64_t num_columns) noexcept
+{
+    return num_columns * 8;
+}
+
+uint64_t reduction_row_count_offset(uint64_t num_columns) noexcept
+{
+    return num_columns * 8 + 8;
+}
+
+uint64_t reduction_accumulators_offset(uint64_t num_columns) noexcept
+{
+    return num_columns * 8 + 16;
+}
+
+/* Multiple of 16, rsp keeps the alignment it had on entry */
+uint64_t reduction_block_size(uint64_t num_columns, uint64_t num_accumulators) noexcept
+{
+    return (reduction_accumulators_offset(num_columns) + num_accumulators * 8 + 15) & ~uint64_t(15);
+}
+
+void InstrReductionBegin::as_string(std::string& out) const noexcept
+{
+    const std::string_view variable_base = gp_register_as_string(this->_variable_base_ptr, ISA_x86_64);
+    const std::string_view output_base = gp_register_as_string(this->_output_base_ptr, ISA_x86_64);
+
+    std::format_to(std::back_inserter(out),
+                   "sub rsp, {}\n",
+                   reduction_block_size(this->_num_columns, this->_num_accumulators));
+
+    for(uint64_t i = 0; i < this->_num_columns; i++)
+    {
+        std::format_to(std::back_inserter(out), "mov rax, [{} + {}]\n", variable_base, i * 8);
+        std::format_to(std::back_inserter(out), "mov [rsp + {}], rax\n", i * 8);
+    }
+
+    std::format_to(std::back_inserter(out),
+                   "mov [rsp + {}], {}\n",
+                   reduction_remaining_rows_offset(this->_num_columns),
+                   output_base);
+    std::format_to(std::back_inserter(out),
+                   "mov [rsp + {}], {}\n",
+                   reduction_row_count_offset(this->_num_columns),
+                   output_base);
+    std::format_to(std::back_inserter(out), "xorps xmm0, xmm0\n");
+
+    for(uint64_t i = 0; i < this->_num_accumulators; i++)
+    {
+        std::format_to(std::back_inserter(out),
+                       "movsd [rsp + {}], xmm0\n",
+                       reduction_accumulators_offset(this->_num_columns) + i * 8);
+    }
+
+    std::format_to(std::back_inserter(out), "mov {}, rsp\n", variable_base);
+    std::format_to(std::back_inserter(out),
+                   "lea {}, [rsp + {}]",
+                   output_base,
+                   reduction_accumulators_offset(this->_num_columns));
+}
+
+void InstrReductionBegin::as_bytecode(ByteCode& out) const noexcept
+{
+    const std::byte variable_base = encode_platform_gp_register(this->_variable_base_ptr);
+    const std::byte output_base = encode_platform_gp_register(this->_output_base_ptr);
+
+    encode_rsp_adjust(out,
+                      BYTE(5),
+                      static_cast<uint32_t>(reduction_block_size(this->_num_columns, this->_num_accumulators)));
+
+    /* The columns array is only read here, the loops move the copies of the pointers */
+    for(uint64_t i = 0; i < this->_num_columns; i++)
+    {
+        const int64_t offset = static_cast<int64_t>(i * 8);
+
+        out.push_back(REX_BASE | REX_W); /* mov rax, [variables base + offset] */
+        out.push_back(BYTE(0x8B));
+        encode_gp_modrm_disp(out, RAX, variable_base, offset);
+
+        out.push_back(REX_BASE | REX_W); /* mov [rsp + offset], rax */
+        out.push_back(BYTE(0x89));
+        encode_gp_modrm_disp(out, RAX, RSP, offset);
+    }
+
+    /* The row count is passed in place of the outputs base pointer */
+    for(const uint64_t offset : { reduction_remaining_rows_offset(this->_num_columns),
+                                  reduction_row_count_offset(this->_num_columns) })
+    {
+        out.push_back(REX_BASE | REX_W); /* mov [rsp + offset], outputs base */
+        out.push_back(BYTE(0x89));
+        encode_gp_modrm_disp(out, output_base, RSP, static_cast<int64_t>(offset));
+    }
+
+    out.push_back(BYTE(0x0F)); /* xorps xmm0, xmm0 */
+    out.push_back(BYTE(0x57));
+    out.push_back(x86_64::MOD_DIRECT | (XMM0 << 3) | XMM0);
+
+    for(uint64_t i = 0; i < this->_num_accumulators; i++)
+    {
+        out.push_back(BYTE(0xF2)); /* movsd [rsp + offset], xmm0 */
+        out.push_back(BYTE(0x0F));
+        out.push_back(BYTE(0x11));
+        encode_gp_modrm_disp(out,
+                             XMM0,
+                             RSP,
+                             static_cast<int64_t>(reduction_accumulators_offset(this->_num_columns) + i * 8));
+    }
+
+    out.push_back(REX_BASE | REX_W); /* mov variables base, rsp */
+    out.push_back(BYTE(0x89));
+    out.push_back(x86_64::MOD_DIRECT | (RSP << 3) | variable_base);
+
+    out.push_back(REX_BASE | REX_W); /* lea outputs base, [rsp + offset] */
+    out.push_back(BYTE(0x8D));
+    encode_gp_modrm_disp(out,
+                         output_base,
+                         RSP,
+                         static_cast<int64_t>(reduction_accumulators_offset(this->_num_columns)));
+}
+
+void InstrLoopBegin::as_string(std::string& out) const noexcept
+{
+    std::format_to(std::back_inserter(out),
+                   "loop_{}:\n",
+                   this->_step);
+    std::format_to(std::back_inserter(out),
+                   "cmp qword [{} + {}], {}\n",
+                   gp_register_as_string(this->_variable_base_ptr, ISA_x86_64),
+                   reduction_remaining_rows_offset(this->_num_columns),
+                   this->_step);
+    std::format_to(std::back_inserter(out), "jb loop_{}_end", this->_step);
+}
+
+void InstrLoopBegin::as_bytecode(ByteCode& out) const noexcept
+{
+    this->_bytecode = &out;
+    this->_head_offset = out.size();
+
+    out.push_back(REX_BASE | REX_W); /* cmp qword [variables base + offset], step */
+    out.push_back(BYTE(is_imm8(this->_step) ? 0x83 : 0x81));
+    encode_gp_modrm_disp(out,
+                         BYTE(7),
+                         encode_platform_gp_register(this->_variable_base_ptr),
+                         static_cast<int64_t>(reduction_remaining_rows_offset(this->_num_columns)));
+    encode_imm(out, this->_step);
+
+    out.push_back(BYTE(0x0F)); /* jb rel32, patched by the loop end */
+    out.push_back(BYTE(0x82));
+
+    this->_exit_displacement_offset = out.size();
+
+    for(uint8_t i = 0; i < 4; i++)
+        out.push_back(BYTE(0));
+}
+
+void InstrLoopEnd::as_string(std::string& out) const noexcept
+{
+    const std::string_view variable_base = gp_register_as_string(this->_begin->_variable_base_ptr, ISA_x86_64);
+
+    for(uint64_t i = 0; i < this->_begin->_num_columns; i++)
+    {
+        std::format_to(std::back_inserter(out),
+                       "add qword [{} + {}], {}\n",
+                       variable_base,
+                       i * 8,
+                       this->_begin->_step * 8);
+    }
+
+    std::format_to(std::back_inserter(out),
+                   "sub qword [{} + {}], {}\n",
+                   variable_base,
+                   reduction_remaining_rows_offset(this->_begin->_num_columns),
+                   this->_begin->_step);
+    std::format_to(std::back_inserter(out), "jmp loop_{}\n", this->_begin->_step);
+    std::format_to(std::back_inserter(out), "loop_{}_end:", this->_begin->_step);
+}
+
+void InstrLoopEnd::as_bytecode(ByteCode& out) const noexcept
+{
+    const std::byte variable_base = encode_platform_gp_register(this->_begin->_variable_base_ptr);
+    const uint64_t stride = this->_begin->_step * 8;
+
+    /*
+        Jumps are only encoded when the loop begin has been emitted before in the same bytecode, not
+        when the instructions are dumped one by one
+    */
+    const bool linked = this->_begin->_bytecode == &out &&
+                        this->_begin->_exit_displacement_offset + 4 <= out.size();
+
+    for(uint64_t i = 0; i < this->_begin->_num_columns; i++)
+    {
+        out.push_back(REX_BASE | REX_W); /* add qword [variables base + offset], stride */
+        out.push_back(BYTE(is_imm8(stride) ? 0x83 : 0x81));
+        encode_gp_modrm_disp(out, BYTE(0), variable_base, static_cast<int64_t>(i * 8));
+        encode_imm(out, stride);
+    }
+
+    out.push_back(REX_BASE | REX_W); /* sub qword [variables base + offset], step */
+    out.push_back(BYTE(is_imm8(this->_begin->_step) ? 0x83 : 0x81));
+    encode_gp_modrm_disp(out,
+                         BYTE(5),
+                         variable_base,
+                         static_cast<int64_t>(reduction_remaining_rows_offset(this->_begin->_num_columns)));
+    encode_imm(out, this->_begin->_step);
+
+    const int64_t head_displacement = linked ? static_cast<int64_t>(this->_begin->_head_offset) -
+                                               static_cast<int64_t>(out.size() + 5) : 0;
+
+    out.push_back(BYTE(0xE9)); /* jmp rel32 */
+
+    for(uint8_t i = 0; i < 4; i++)
+        out.push_back(BYTE((head_displacement >> (i * 8)) & 0xFF));
+
+    if(linked)
+    {
+        const std::size_t patch_offset = this->_begin->_exit_displacement_offset;
+        const int64_t exit_displacement = static_cast<int64_t>(out.size()) - static_cast<int64_t>(patch_offset + 4);
+
+        for(uint8_t i = 0; i < 4; i++)
+            out[patch_offset + i] = BYTE((exit_displacement >> (i * 8)) & 0xFF);
+    }
+}
+
+void InstrReductionEnd::as_string(std::string& out) const noexcept
+{
+    const uint64_t accumulators = reduction_accumulators_offset(this->_num_columns);
+
+    std::format_to(std::back_inserter(out), "movsd xmm0, [rsp + {}]\n", accumulators);
+
+    if(this->_num_accumulators > 1)
+        std::format_to(std::back_inserter(out), "movsd xmm1, [rsp + {}]\n", accumulators + 8);
+
+    for(uint64_t i = 2; i < this->_num_accumulators; i++)
+        std::format_to(std::back_inserter(out), "addsd xmm{}, [rsp + {}]\n", i % 2, accumulators + i * 8);
+
+    if(this->_num_accumulators > 1)
+        std::format_to(std::back_inserter(out), "addsd xmm0, xmm1\n");
+
+    if(this->_mean)
+    {
+        std::format_to(std::back_inserter(out),
+                       "cvtsi2sd xmm1, qword [rsp + {}]\n",
+                       reduction_row_count_offset(this->_num_columns));
+        std::format_to(std::back_inserter(out), "divsd xmm0, xmm1\n");
+    }
+
+    std::format_to(std::back_inserter(out),
+                   "add rsp, {}",
+                   reduction_block_size(this->_num_columns, this->_num_accumulators));
+}
+
+void InstrReductionEnd::as_bytecode(ByteCode& out) const noexcept
+{
+    const uint64_t accumulators = reduction_accumulators_offset(this->_num_columns);
+
+    /* Pairwise: even accumulators in xmm0, odd ones in xmm1 */
+    for(uint64_t i = 0; i < this->_num_accumulators; i++)
+    {
+        out.push_back(BYTE(0xF2)); /* movsd xmm, [rsp + offset] or addsd xmm, [rsp + offset] */
+        out.push_back(BYTE(0x0F));
+        out.push_back(BYTE(i < 2 ? 0x10 : 0x58));
+        encode_gp_modrm_disp(out, BYTE(i % 2), RSP, static_cast<int64_t>(accumulators + i * 8));
+    }
+
+    if(this->_num_accumulators > 1)
+    {
+        out.push_back(BYTE(0xF2)); /* addsd xmm0, xmm1 */
+        out.push_back(BYTE(0x0F));
+        out.push_back(BYTE(0x58));
+        out.push_back(x86_64::MOD_DIRECT | (XMM0 << 3) | XMM1);
+    }
+
+    if(this->_mean)
+    {
+        out.push_back(BYTE(0xF2)); /* cvtsi2sd xmm1, qword [rsp + offset] */
+        out.push_back(REX_BASE | REX_W);
+        out.push_back(BYTE(0x0F));
+        out.push_back(BYTE(0x2A));
+        encode_gp_modrm_disp(out, XMM1, RSP, static_cast<int64_t>(reduction_row_count_offset(this->_num_columns)));
+
+        out.push_back(BYTE(0xF2)); /* divsd xmm0, xmm1 */
+        out.push_back(BYTE(0x0F));
+        out.push_back(BYTE(0x5E));
+        out.push_back(x86_64::MOD_DIRECT | (XMM0 << 3) | XMM1);
+    }
+
+    encode_rsp_adjust(out,
+                      BYTE(0),
+                      static_cast<uint32_t>(reduction_block_size(this->_num_columns, this->_num_accumulators)));
+}
+
+/* Terminator instructions */
+
+void InstrRet::as_string(std::string& out) const noexcept
+{
+    std::format_to(std::back_inserter(out), "ret");
+}
+
+void InstrRet::as_bytecode(ByteCode& out) const noexcept
+{
+    out.push_back(BYTE(0xC3));
+}
+
+/* Peephole helpers */
+
+/*
+    Calls, returns and frame setup/teardown read and clobber registers we can't track. Nothing is
+    forwarded across the boundaries of loops either
+*/
+bool instr_is_barrier(const Instr* instr) noexcept
+{
+    switch(instr->type_id())
+    {
+        case InstrTypeId_Prologue:
+        case InstrTypeId_Epilogue:
+        case InstrTypeId_Call:
+        case InstrTypeId_Ret:
+        case InstrTypeId_ReductionBegin:
+        case InstrTypeId_LoopBegin:
+        case InstrTypeId_LoopEnd:
+        case InstrTypeId_ReductionEnd:
+            return true;
+    }
+
+    return false;
+}
+
+std::tuple<const MemLoc*, const MemLoc*> instr_binop_operands(const Instr* instr) noexcept
+{
+    switch(instr->type_id())
+    {
+        case InstrTypeId_Add:
+        {
+            auto add = instr_const_cast<InstrAdd>(instr);
+            return std::make_tuple(add->get_left().get(), add->get_right().get());
+        }
+        case InstrTypeId_Sub:
+        {
+            auto sub = instr_const_cast<InstrSub>(instr);
+            return std::make_tuple(sub->get_left().get(), sub->get_right().get());
+        }
+        case InstrTypeId_Mul:
+        {
+            auto mul = instr_const_cast<InstrMul>(instr);
+            return std::make_tuple(mul->get_left().get(), mul->get_right().get());
+        }
+        case InstrTypeId_Div:
+        {
+            auto div = instr_const_cast<InstrDiv>(instr);
+            return std::make_tuple(div->get_left().get(), div->get_right().get());
+        }
+        case InstrTypeId_Cmp:
+        {
+            auto cmp = instr_const_cast<InstrCmp>(instr);
+            return std::make_tuple(cmp->get_left().get(), cmp->get_right().get());
+        }
+        case InstrTypeId_And:
+        {
+            auto andpd = instr_const_cast<InstrAnd>(instr);
+            return std::make_tuple(andpd->get_left().get(), andpd->get_right().get());
+        }
+        case InstrTypeId_AndNot:
+        {
+            auto andnpd = instr_const_cast<InstrAndNot>(instr);
+            return std::make_tuple(andnpd->get_left().get(), andnpd->get_right().get());
+        }
+        case InstrTypeId_Or:
+        {
+            auto orpd = instr_const_cast<InstrOr>(instr);
+            return std::make_tuple(orpd->get_left().get(), orpd->get_right().get());
+        }
+    }
+
+    return std::make_tuple(nullptr, nullptr);
+}
+
+/* Unary ops work in place, their operand is read and written */
+const MemLoc* instr_unop_operand(const Instr* instr) noexcept
+{
+    switch(instr->type_id())
+    {
+        case InstrTypeId_Neg:
+            return instr_const_cast<InstrNeg>(instr)->get_operand().get();
+        case InstrTypeId_MaskToBool:
+            return instr_const_cast<InstrMaskToBool>(instr)->get_operand().get();
+        case InstrTypeId_Sqrt:
+            return instr_const_cast<InstrSqrt>(instr)->get_operand().get();
+    }
+
+    return nullptr;
+}
+
+/* Returns the location written by the instruction, nullptr for barriers */
+const MemLoc* instr_written_memloc(const Instr* instr) noexcept
+{
+    if(auto mov = instr_const_cast<InstrMov>(instr))
+    {
+        return mov->get_to().get();
+    }
+
+    if(auto operand = instr_unop_operand(instr))
+    {
+        return operand;
+    }
+
+    return std::get<0>(instr_binop_operands(instr));
+}
+
+/* Our stack slots can't be read by callees, everything else is considered read by barriers */
+bool instr_reads_memloc(const Instr* instr, const MemLoc* loc) noexcept
+{
+    if(instr_is_barrier(instr))
+    {
+        return loc->type_id() != MemLocTypeId_Stack;
+    }
+
+    if(auto mov = instr_const_cast<InstrMov>(instr))
+    {
+        return memloc_equals(mov->get_from().get(), loc);
+    }
+
+    if(auto operand = instr_unop_operand(instr))
+    {
+        return memloc_equals(operand, loc);
+    }
+
+    auto [left, right] = instr_binop_operands(instr);
+
+    return memloc_equals(left, loc) || memloc_equals(right, loc);
+}
+
+bool instr_writes_memloc(const Instr* instr, const MemLoc* loc) noexcept
+{
+    if(instr->type_id() == InstrTypeId_Call)
+    {
+        return loc->type_id() == MemLocTypeId_Register;
+    }
+
+    return memloc_equals(instr_written_memloc(instr), loc);
+}
+
+/* Constants are ip-relative and don't depend on any register, they are not counted as memory accesses */
+bool instr_accesses_memory(const Instr* instr) noexcept
+{
+    auto is_memory = [](const MemLoc* loc) {
+        return loc != nullptr &&
+               loc->type_id() != MemLocTypeId_Register &&
+               loc->type_id() != MemLocTypeId_Constant;
+    };
+
+    if(auto mov = instr_const_cast<InstrMov>(instr))
+    {
+        return is_memory(mov->get_from().get()) || is_memory(mov->get_to().get());
+    }
+
+    if(auto operand = instr_unop_operand(instr))
+    {
+        return is_memory(operand);
+    }
+
+    auto [left, right] = instr_binop_operands(instr);
+
+    return is_memory(left) || is_memory(right);
+}
+
+/* Returns a copy of a binop instruction reading its right operand from another location */
+InstrPtr instr_binop_with_right(const Instr* instr, MemLocPtr right) noexcept
+{
+    switch(instr->type_id())
+    {
+        case InstrTypeId_Add:
+        {
+            auto binop = instr_const_cast<InstrAdd>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrAdd>(left, right, binop->get_value_type());
+        }
+        case InstrTypeId_Sub:
+        {
+            auto binop = instr_const_cast<InstrSub>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrSub>(left, right, binop->get_value_type());
+        }
+        case InstrTypeId_Mul:
+        {
+            auto binop = instr_const_cast<InstrMul>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrMul>(left, right, binop->get_value_type());
+        }
+        case InstrTypeId_Div:
+        {
+            auto binop = instr_const_cast<InstrDiv>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrDiv>(left, right, binop->get_value_type());
+        }
+        case InstrTypeId_Cmp:
+        {
+            auto cmp = instr_const_cast<InstrCmp>(instr);
+            MemLocPtr left = cmp->get_left();
+            return std::make_shared<InstrCmp>(left, right, cmp->get_op(), cmp->get_value_type());
+        }
+        case InstrTypeId_And:
+        {
+            auto binop = instr_const_cast<InstrAnd>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrAnd>(left, right, binop->get_value_type());
+        }
+        case InstrTypeId_AndNot:
+        {
+            auto binop = instr_const_cast<InstrAndNot>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrAndNot>(left, right, binop->get_value_type());
+        }
+        case InstrTypeId_Or:
+        {
+            auto binop = instr_const_cast<InstrOr>(instr);
+            MemLocPtr left = binop->get_left();
+            return std::make_shared<InstrOr>(left, right, binop->get_value_type());
+        }
+    }
+
+    return nullptr;
+}
+
+/* Returns the size in bytes and the number of machine instructions of an instruction sequence */
+std::tuple<size_t, size_t> instr_sequence_size(const std::vector<InstrPtr>& instructions) noexcept
+{
+    ByteCode code;
+    std::string asm_code;
+
+    for(const auto& instruction : instructions)
+    {
+        instruction->as_bytecode(code);
+        instruction->as_string(asm_code);
+        asm_code.push_back('\n');
+    }
+
+    return std::make_tuple(code.size(), std::ranges::count(asm_code, '\n'));
+}
+
+X86_64_NAMESPACE_END
+
+InstrPtr X86_64_CodeGenerator::create_mov(MemLocPtr& from, MemLocPtr& to)
+{
+    return std::make_shared<x86_64::InstrMov>(from, to, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_prologue(uint64_t stack_size, bool frame_pointer)
+{
+    return std::make_shared<x86_64::InstrPrologue>(stack_size, frame_pointer);
+}
+
+InstrPtr X86_64_CodeGenerator::create_epilogue(uint64_t stack_size, bool frame_pointer)
+{
+    return std::make_shared<x86_64::InstrEpilogue>(stack_size, frame_pointer);
+}
+
+InstrPtr X86_64_CodeGenerator::create_neg(MemLocPtr& operand)
+{
+    return std::make_shared<x86_64::InstrNeg>(operand, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_add(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrAdd>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_sub(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrSub>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_mul(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrMul>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_div(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrDiv>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_cmp(MemLocPtr& left, MemLocPtr& right, uint32_t op)
+{
+    return std::make_shared<x86_64::InstrCmp>(left, right, op, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_and(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrAnd>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_andnot(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrAndNot>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_or(MemLocPtr& left, MemLocPtr& right)
+{
+    return std::make_shared<x86_64::InstrOr>(left, right, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_mask_to_bool(MemLocPtr& operand)
+{
+    return std::make_shared<x86_64::InstrMaskToBool>(operand, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_sqrt(MemLocPtr& operand)
+{
+    return std::make_shared<x86_64::InstrSqrt>(operand, this->get_value_type());
+}
+
+InstrPtr X86_64_CodeGenerator::create_call(std::string_view call_name, bool preserve_outputs)
+{
+    PlatformABIPtr platform_abi = this->get_platform_abi();
+
+    /* Base pointers live in caller-saved registers and are still needed after the call */
+    std::vector<RegisterId> preserved_registers = { platform_abi->get_variable_base_ptr() };
+
+    if(preserve_outputs)
+        preserved_registers.push_back(platform_abi->get_output_base_ptr());
+
+    /*
+        The function body runs with rsp = 8 (mod 16) (return address, or push rbp + sub rsp, size + 8),
+        the pushes and the adjustment must bring it back to 16 bytes alignment at the call
+    */
+    uint64_t stack_adjust = platform_abi->get_fcall_shadow_space();
+
+    if(preserved_registers.size() % 2 == 0)
+        stack_adjust += 8;
+
+    return std::make_shared<x86_64::InstrCall>(call_name, std::move(preserved_registers), stack_adjust);
+}
+
+InstrPtr X86_64_CodeGenerator::create_ret()
 {
     return std::make_shared<x86_64::InstrRet>();
 }
 
-void X86_64_CodeGenerator::optimize_instr_sequence(std::vector<InstrPtr>& instructions) noexcept
+InstrPtr X86_64_CodeGenerator::create_reduction_begin(uint64_t num_columns, uint64_t num_accumulators)
+{
+    return std::make_shared<x86_64::InstrReductionBegin>(this->get_platform_abi()->get_variable_base_ptr(),
+                                                         this->get_platform_abi()->get_output_base_ptr(),
+                                                         num_columns,
+                                                         num_accumulators);
+}
+
+InstrPtr X86_64_CodeGenerator::create_loop_begin(uint64_t num_columns, uint64_t step)
+{
+    return std::make_shared<x86_64::InstrLoopBegin>(this->get_platform_abi()->get_variable_base_ptr(),
+                                                    num_columns,
+                                                    step);
+}
+
+InstrPtr X86_64_CodeGenerator::create_loop_end(const InstrPtr& loop_begin)
+{
+    MATHEXPR_ASSERT(instr_const_cast<x86_64::InstrLoopBegin>(loop_begin.get()) != nullptr,
+                    "Loop end expects a loop begin");
+
+    return std::make_shared<x86_64::InstrLoopEnd>(std::static_pointer_cast<const x86_64::InstrLoopBegin>(loop_begin));
+}
+
+InstrPtr X86_64_CodeGenerator::create_reduction_end(uint64_t num_columns, uint64_t num_accumulators, bool mean)
+{
+    return std::make_shared<x86_64::InstrReductionEnd>(num_columns, num_accumulators, mean);
+}
+
+/*
+    Peephole optimizer. Runs the following rewrites until nothing changes:
+    - movsd xmm, xmm with the same register is removed
+    - a reload of a stack slot that still holds the same value in a register is replaced by a
+      register move (or removed), binops reading the slot read the register instead
+    - a store to a stack slot that is never read afterwards is removed
+    - a move to a register overwritten before being read is removed
+    - consecutive calls only separated by register operations keep the base pointers saved and
+      the stack adjusted in between, instead of restoring and saving them again
+*/
+PeepholeStats X86_64_CodeGenerator::optimize_instr_sequence(std::vector<InstrPtr>& instructions) noexcept
 {
+    using namespace x86_64;
+
+    PeepholeStats stats;
+
+    const auto [bytes_before, instructions_before] = instr_sequence_size(instructions);
+
+    bool changed = true;
+
+    while(changed)
+    {
+        changed = false;
+
+        for(size_t i = 0; i < instructions.size(); i++)
+        {
+            auto mov = instr_const_cast<InstrMov>(instructions[i].get());
+
+            if(mov == nullptr)
+            {
+                continue;
+            }
+
+            const MemLocPtr from = mov->get_from();
+            const MemLocPtr to = mov->get_to();
+
+            if(memloc_equals(from.get(), to.get()))
+            {
+                instructions.erase(instructions.begin() + i--);
+                changed = true;
+                continue;
+            }
+
+            /* Store: forward the register to the following reads of the slot */
+            if(from->type_id() == MemLocTypeId_Register && to->type_id() == MemLocTypeId_Stack)
+            {
+                bool slot_read = false;
+                bool slot_overwritten = false;
+                bool forwarding = true;
+
+                for(size_t j = i + 1; j < instructions.size() && !slot_read && !slot_overwritten; j++)
+                {
+                    Instr* instr = instructions[j].get();
+
+                    if(forwarding && instr_is_barrier(instr))
+                    {
+                        forwarding = false;
+                    }
+
+                    if(forwarding && instr_reads_memloc(instr, to.get()))
+                    {
+                        if(auto reload = instr_const_cast<InstrMov>(instr))
+                        {
+                            MemLocPtr reload_to = reload->get_to();
+                            MemLocPtr reload_from = from;
+
+                            instructions[j] = std::make_shared<InstrMov>(reload_from, reload_to, reload->get_value_type());
+                            changed = true;
+                        }
+                        else if(auto binop = instr_binop_with_right(instr, from))
+                        {
+                            auto [left, right] = instr_binop_operands(instr);
+
+                            if(!memloc_equals(left, to.get()))
+                            {
+                                instructions[j] = binop;
+                                changed = true;
+                            }
+                        }
+
+                        instr = instructions[j].get();
+                    }
+
+                    slot_read = instr_reads_memloc(instr, to.get());
+                    slot_overwritten = instr_writes_memloc(instr, to.get());
+
+                    if(instr_writes_memloc(instr, from.get()))
+                    {
+                        forwarding = false;
+                    }
+                }
+
+                if(!slot_read)
+                {
+                    instructions.erase(instructions.begin() + i--);
+                    changed = true;
+                }
+
+                continue;
+            }
+
+            /* Move to a register: removed if the register is overwritten before being read */
+            if(to->type_id() == MemLocTypeId_Register)
+            {
+                for(size_t j = i + 1; j < instructions.size(); j++)
+                {
+                    const Instr* instr = instructions[j].get();
+
+                    if(instr_reads_memloc(instr, to.get()))
+                    {
+                        break;
+                    }
+
+                    if(instr_writes_memloc(instr, to.get()))
+                    {
+                        instructions.erase(instructions.begin() + i--);
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    for(size_t i = 0; i < instructions.size(); i++)
+    {
+        auto call = instr_cast<InstrCall>(instructions[i].get());
+
+        if(call == nullptr)
+        {
+            continue;
+        }
+
+        /*
+            Between the calls, the variables base pointer is clobbered and the stack pointer is moved,
+            only register operations and constant loads can be kept in between
+        */
+        for(size_t j = i + 1; j < instructions.size(); j++)
+        {
+            Instr* instr = instructions[j].get();
+
+            if(auto next_call = instr_cast<InstrCall>(instr))
+            {
+                call->set_restore(false);
+                next_call->set_save(false);
+                break;
+            }
+
+            if(instr_is_barrier(instr) || instr_accesses_memory(instr))
+            {
+                break;
+            }
+        }
+    }
+
+    const auto [bytes_after, instructions_after] = instr_sequence_size(instructions);
+
+    stats.removed_instructions = instructions_before - instructions_after;
+    stats.removed_bytes = bytes_before - bytes_after;
 
+    return stats;
 }
 
 MATHEXPR_NAMESPACE_END
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+#include <vector>
+
+bool is_valid(const uint8_t* validity, size_t bit)
+{
+    return (validity[bit / 8] >> (bit % 8)) & 1;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting arrow test");
+
+    mathexpr::Expr expr("sqrt(x) * y - 1.5");
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    constexpr size_t num_rows = 21;
+    constexpr size_t x_offset = 3;
+
+    /* x is a slice starting at row 3 of a column with nulls, y has no nulls */
+    std::vector<double> xs(x_offset + num_rows);
+    std::vector<double> ys(num_rows);
+    std::vector<uint8_t> x_validity((x_offset + num_rows + 7) / 8, 0);
+
+    for(size_t i = 0; i < xs.size(); i++)
+    {
+        xs[i] = static_cast<double>(i);
+
+        /* Null values are garbage, they must not matter */
+        if(i % 3 == 0)
+            xs[i] = -1.0;
+        else
+            x_validity[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+    }
+
+    for(size_t i = 0; i < num_rows; i++)
+        ys[i] = 0.5 * static_cast<double>(i);
+
+    mathexpr::ArrowColumns columns;
+    columns["x"] = mathexpr::ArrowColumn{ xs.data(), x_validity.data(), x_offset };
+    columns["y"] = mathexpr::ArrowColumn{ ys.data(), nullptr, 0 };
+    columns["unused"] = mathexpr::ArrowColumn{ ys.data(), nullptr, 0 };
+
+    std::vector<double> outputs(num_rows);
+    std::vector<uint8_t> validity((num_rows + 7) / 8, 0xFF);
+
+    if(!expr.evaluate_batch(columns, outputs, validity))
+        return 1;
+
+    for(size_t i = 0; i < num_rows; i++)
+    {
+        const bool expected_valid = is_valid(x_validity.data(), x_offset + i);
+
+        if(is_valid(validity.data(), i) != expected_valid)
+        {
+            mathexpr::log_error("Row {} has the wrong validity", i);
+            return 1;
+        }
+
+        const double expected = std::sqrt(xs[x_offset + i]) * ys[i] - 1.5;
+
+        if(expected_valid && !DOUBLE_EQ(outputs[i], expected))
+        {
+            mathexpr::log_error("Row {} evaluated to {} (expected {})", i, outputs[i], expected);
+            return 1;
+        }
+    }
+
+    /* Padding bits of the last byte are cleared */
+    if((validity.back() >> (num_rows % 8)) != 0)
+        return 1;
+
+    /* Every variable needs a column, and the bitmap must cover all the rows */
+    columns.erase("y");
+
+    if(expr.evaluate_batch(columns, outputs, validity))
+        return 1;
+
+    columns["y"] = mathexpr::ArrowColumn{ ys.data(), nullptr, 0 };
+
+    if(expr.evaluate_batch(columns, outputs, std::span<uint8_t>(validity.data(), 2)))
+        return 1;
+
+    mathexpr::log_info("Finished arrow test");
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting batch test");
+
+    const char* expression = "x * y - sin(x) / (y + 1.0)";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    const size_t x = expr.get_variable_layout().get_slot("x");
+    const size_t y = expr.get_variable_layout().get_slot("y");
+
+    constexpr size_t num_rows = 37;
+
+    std::vector<double> xs(num_rows);
+    std::vector<double> ys(num_rows);
+
+    for(size_t i = 0; i < num_rows; i++)
+    {
+        xs[i] = 0.25 * static_cast<double>(i);
+        ys[i] = 3.0 - 0.1 * static_cast<double>(i);
+    }
+
+    std::array<const double*, 2> columns;
+    columns[x] = xs.data();
+    columns[y] = ys.data();
+
+    std::vector<double> outputs(num_rows);
+
+    if(!expr.evaluate_batch(columns, outputs))
+        return 1;
+
+    for(size_t i = 0; i < num_rows; i++)
+    {
+        const double expected = xs[i] * ys[i] - std::sin(xs[i]) / (ys[i] + 1.0);
+
+        if(!DOUBLE_EQ(outputs[i], expected))
+        {
+            mathexpr::log_error("Row {} evaluated to {} (expected {})", i, outputs[i], expected);
+            return 1;
+        }
+    }
+
+    /* Same rows read from an array of structs, with a member the expression does not use */
+    struct Row
+    {
+        double y;
+        double unused;
+        double x;
+    };
+
+    std::vector<Row> rows(num_rows);
+
+    for(size_t i = 0; i < num_rows; i++)
+        rows[i] = Row{ ys[i], -1.0, xs[i] };
+
+    std::array<mathexpr::StridedColumn, 2> strided_columns;
+    strided_columns[x] = mathexpr::StridedColumn{ &rows[0].x, sizeof(Row) };
+    strided_columns[y] = mathexpr::StridedColumn{ &rows[0].y, sizeof(Row) };
+
+    std::vector<double> strided_outputs(num_rows);
+
+    if(!expr.evaluate_batch(strided_columns, strided_outputs) || strided_outputs != outputs)
+        return 1;
+
+    /* Columns must match the variables of the expression */
+    if(expr.evaluate_batch(std::span<const double* const>(columns.data(), 1), outputs))
+        return 1;
+
+    mathexpr::log_info("Finished batch test");
+
+    return 0;
+}
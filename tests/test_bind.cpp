@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting bind test");
+
+    const char* expression = "a * 2.5 + b / 4.0 - c";
+
+    mathexpr::Expr expr(expression);
+
+    if(expr.bind<3>())
+    {
+        mathexpr::log_error("Binding an expression that has not been compiled should fail");
+        return 1;
+    }
+
+    if(!expr.compile())
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    if(expr.bind<2>())
+    {
+        mathexpr::log_error("Binding with the wrong number of arguments should fail");
+        return 1;
+    }
+
+    auto func = expr.bind<3>();
+
+    if(!func)
+    {
+        mathexpr::log_error("Error while binding expression");
+        return 1;
+    }
+
+    double res = func(4.0, 8.0, 1.5);
+
+    mathexpr::log_info("expr \"{}\" evaluated: (4, 8, 1.5) = {}", expression, res);
+
+    if(!DOUBLE_EQ(res, 10.5))
+        return 1;
+
+    auto [success, expected] = expr.evaluate(-2.0, 3.0, 0.25);
+
+    if(!success || !DOUBLE_EQ(func(-2.0, 3.0, 0.25), expected))
+        return 1;
+
+    mathexpr::log_info("Finished bind test");
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting call_spill test");
+
+    const char* expression = "a * b + sqrt(c) * abs(d - e) + pow(a, b)";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    double a = 2.0;
+    double b = 3.0;
+    double c = 16.0;
+    double d = 1.0;
+    double e = 5.0;
+
+    auto [success, res] = expr.evaluate(a, b, c, d, e);
+
+    if(!success)
+    {
+        mathexpr::log_error("Error during expression evaluation");
+        return 1;
+    }
+
+    mathexpr::log_info("expr \"{}\" evaluated: ({}, {}, {}, {}, {}) = {}",
+                        expression,
+                        a,
+                        b,
+                        c,
+                        d,
+                        e,
+                        res);
+
+    if(!DOUBLE_EQ(res, 30.0))
+        return 1;
+
+    mathexpr::log_info("Finished call_spill test");
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+#include "mathexpr/column_file.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+bool check_column_file(const std::string& path)
+{
+    constexpr size_t num_rows = 1000;
+
+    std::vector<double> xs(num_rows);
+    std::vector<double> ys(num_rows);
+    std::vector<double> zs(num_rows);
+
+    for(size_t i = 0; i < num_rows; i++)
+    {
+        xs[i] = 0.01 * static_cast<double>(i);
+        ys[i] = 2.0 + static_cast<double>(i % 7);
+        zs[i] = -1.0;
+    }
+
+    /* An extra column the expression does not use, and not in the order of the variables */
+    const std::array<std::string_view, 3> names = { "y", "z", "x" };
+    const std::array<const double*, 3> columns = { ys.data(), zs.data(), xs.data() };
+
+    if(!mathexpr::write_column_file(path.c_str(), names, columns, num_rows))
+        return false;
+
+    mathexpr::ColumnFile file;
+
+    if(!file.open(path.c_str()))
+        return false;
+
+    if(file.get_num_rows() != num_rows || file.get_num_columns() != 3 || file.get_column_name(2) != "x")
+        return false;
+
+    for(size_t i = 0; i < file.get_num_columns(); i++)
+    {
+        if((reinterpret_cast<uintptr_t>(file.get_column(file.get_column_name(i))) % mathexpr::COLUMN_FILE_ALIGNMENT) != 0)
+        {
+            mathexpr::log_error("Column \"{}\" is not aligned", file.get_column_name(i));
+            return false;
+        }
+    }
+
+    mathexpr::Expr expr("x * y + cos(x) / y");
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+        return false;
+
+    std::vector<const double*> bound_columns;
+
+    if(!file.bind(expr.get_variable_layout(), bound_columns))
+        return false;
+
+    std::vector<double> outputs(num_rows);
+
+    if(!expr.evaluate_batch(bound_columns, outputs))
+        return false;
+
+    for(size_t i = 0; i < num_rows; i++)
+    {
+        const double expected = xs[i] * ys[i] + std::cos(xs[i]) / ys[i];
+
+        if(!DOUBLE_EQ(outputs[i], expected))
+        {
+            mathexpr::log_error("Row {} evaluated to {} (expected {})", i, outputs[i], expected);
+            return false;
+        }
+    }
+
+    /* Variables without a column of the same name cannot be bound */
+    mathexpr::Expr missing("x + w");
+
+    if(!missing.compile() || file.bind(missing.get_variable_layout(), bound_columns))
+        return false;
+
+    file.release_rows(0, num_rows);
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting column file test");
+
+    const std::string path = (std::filesystem::temp_directory_path() / "mathexpr_test_column_file.mxc").string();
+
+    const bool success = check_column_file(path);
+
+    std::remove(path.c_str());
+
+    if(!success)
+        return 1;
+
+    /* Files that are not column files are rejected */
+    mathexpr::ColumnFile file;
+
+    if(file.open(__FILE__))
+        return 1;
+
+    mathexpr::log_info("Finished column file test");
+
+    return 0;
+}
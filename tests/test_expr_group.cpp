@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting expr_group test");
+
+    mathexpr::ExprGroup group({ "sqrt(x * x + y * y)",
+                                "atan2(y, x)",
+                                "x * x + y * y - 1.5",
+                                "y" });
+
+    if(!group.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression group");
+        return 1;
+    }
+
+    const mathexpr::VariableLayout& layout = group.get_variable_layout();
+
+    if(layout.size() != 2 || group.get_num_outputs() != 4)
+        return 1;
+
+    std::array<double, 2> values;
+    values[layout.get_slot("x")] = 3.0;
+    values[layout.get_slot("y")] = 4.0;
+
+    std::array<double, 4> outputs = { 0.0, 0.0, 0.0, 0.0 };
+
+    if(!group.evaluate(values, outputs))
+    {
+        mathexpr::log_error("Error during expression group evaluation");
+        return 1;
+    }
+
+    mathexpr::log_info("expr group evaluated: (3, 4) = ({}, {}, {}, {})",
+                       outputs[0],
+                       outputs[1],
+                       outputs[2],
+                       outputs[3]);
+
+    if(!DOUBLE_EQ(outputs[0], 5.0) ||
+       !DOUBLE_EQ(outputs[1], ::atan2(4.0, 3.0)) ||
+       !DOUBLE_EQ(outputs[2], 23.5) ||
+       !DOUBLE_EQ(outputs[3], 4.0))
+    {
+        return 1;
+    }
+
+    /* Single token expressions */
+    mathexpr::ExprGroup single_token_group({ "x", "2" });
+
+    if(!single_token_group.compile() ||
+       single_token_group.get_variable_layout().size() != 1 ||
+       single_token_group.get_num_outputs() != 2)
+    {
+        mathexpr::log_error("Error while compiling single token expression group");
+        return 1;
+    }
+
+    const double x = 3.0;
+    std::array<double, 2> single_token_outputs = { 0.0, 0.0 };
+
+    if(!single_token_group.evaluate(std::span<const double>(&x, 1), single_token_outputs) ||
+       !DOUBLE_EQ(single_token_outputs[0], 3.0) ||
+       !DOUBLE_EQ(single_token_outputs[1], 2.0))
+    {
+        mathexpr::log_error("Error during single token expression group evaluation");
+        return 1;
+    }
+
+    mathexpr::log_info("Finished expr_group test");
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting float32 test");
+
+    /* Literals, function calls, comparisons and powers in single precision */
+    const char* expression = "sin(x) * 2.5 + y ^ 2 + y ^ 0.5 + (x < y ? x : y) - pow(x, y) / 3.0";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll,
+                     mathexpr::ExprCompileFlags_Float32 | mathexpr::ExprCompileFlags_ParametricLiterals))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    if(expr.get_value_type() != mathexpr::ValueType_Float32)
+        return 1;
+
+    auto reference = [](float x, float y, float scale) {
+        return std::sin(x) * scale + y * y + std::sqrt(y) + (x < y ? x : y) - std::pow(x, y) / 3.0f;
+    };
+
+    const size_t x = expr.get_variable_layout().get_slot("x");
+    const size_t y = expr.get_variable_layout().get_slot("y");
+
+    const float inputs[][2] = {
+        { 0.5f, 1.5f },
+        { 2.0f, 1.25f },
+        { 1.0f, 1.0f },
+    };
+
+    for(const auto& [x_value, y_value] : inputs)
+    {
+        std::array<float, 2> values;
+        values[x] = x_value;
+        values[y] = y_value;
+
+        auto [success, res] = expr.evaluate(std::span<const float>(values));
+
+        mathexpr::log_info("expr \"{}\" evaluated: (x = {}, y = {}) = {}", expression, x_value, y_value, res);
+
+        if(!success || !DOUBLE_EQ(res, reference(x_value, y_value, 2.5f)))
+            return 1;
+    }
+
+    /* Parametric literals are stored as floats too */
+    if(!expr.set_literal("2.5", -1.0))
+        return 1;
+
+    mathexpr::Variables variables = { { "x", 0.5 }, { "y", 1.5 } };
+
+    auto [map_success, map_res] = expr.evaluate(variables);
+
+    mathexpr::log_info("expr \"{}\" with updated literal evaluated: (x = 0.5, y = 1.5) = {}", expression, map_res);
+
+    if(!map_success || !DOUBLE_EQ(map_res, reference(0.5f, 1.5f, -1.0f)))
+        return 1;
+
+    /* Double precision entry points reject single precision code */
+    const std::array<double, 2> double_values = { 0.5, 1.5 };
+
+    if(std::get<0>(expr.evaluate(std::span<const double>(double_values))) || expr.bind<2>())
+        return 1;
+
+    mathexpr::log_info("Finished float32 test");
+
+    return 0;
+}
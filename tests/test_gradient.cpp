@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+#include <functional>
+
+using Reference = std::function<double(double, double)>;
+
+/* Compares the jitted value and partial derivatives with central differences of the reference */
+bool check_gradient(const char* expression, const Reference& reference, const double (&inputs)[3][2])
+{
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile_gradient(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling gradient of expression \"{}\"", expression);
+        return false;
+    }
+
+    const size_t x = expr.get_gradient_variable_layout().get_slot("x");
+    const size_t y = expr.get_gradient_variable_layout().get_slot("y");
+
+    constexpr double h = 1e-6;
+
+    for(const auto& [x_value, y_value] : inputs)
+    {
+        std::array<double, 2> values;
+        values[x] = x_value;
+        values[y] = y_value;
+
+        std::array<double, 3> outputs;
+
+        if(!expr.evaluate_gradient(values, outputs))
+            return false;
+
+        const double dx = (reference(x_value + h, y_value) - reference(x_value - h, y_value)) / (2.0 * h);
+        const double dy = (reference(x_value, y_value + h) - reference(x_value, y_value - h)) / (2.0 * h);
+
+        mathexpr::log_info("gradient of \"{}\" evaluated: (x = {}, y = {}) = {}, d/dx = {} ({}), d/dy = {} ({})",
+                           expression,
+                           x_value,
+                           y_value,
+                           outputs[0],
+                           outputs[1 + x],
+                           dx,
+                           outputs[1 + y],
+                           dy);
+
+        if(!DOUBLE_EQ(outputs[0], reference(x_value, y_value)) ||
+           !DOUBLE_EQ(outputs[1 + x], dx) ||
+           !DOUBLE_EQ(outputs[1 + y], dy))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting gradient test");
+
+    const double inputs[3][2] = {
+        { 0.7, 1.3 },
+        { 2.0, 1.5 },
+        { 0.25, 0.5 },
+    };
+
+    /* Arithmetic, specialized powers, select and shared forward values */
+    if(!check_gradient("x * y - sin(x) / y + exp(0.5 * y) + x ^ 3 + x ^ 1.5 + (x < y ? x * x : y) + sin(x)",
+                       [](double x, double y) {
+                           return x * y - std::sin(x) / y + std::exp(0.5 * y) + x * x * x + std::pow(x, 1.5) +
+                                  (x < y ? x * x : y) + std::sin(x);
+                       },
+                       inputs))
+    {
+        return 1;
+    }
+
+    /* Derivatives of the libmaths functions */
+    if(!check_gradient("log(x) + log10(y) + log2(x) + log1p(y) + cos(x) + tan(y) + asin(x / 4) + "
+                       "acos(y / 4) + atan(x) + atan2(y, x) + sinh(y) + cosh(x) + tanh(y) + asinh(x) + "
+                       "acosh(y + 1) + atanh(x / 4) + sqrt(x) + cbrt(y) + expm1(x) + hypot(x, y) + "
+                       "pow(x, y) + abs(x - y) + fmod(x, y) + copysign(x, y) + floor(y)",
+                       [](double x, double y) {
+                           return std::log(x) + std::log10(y) + std::log2(x) + std::log1p(y) + std::cos(x) +
+                                  std::tan(y) + std::asin(x / 4) + std::acos(y / 4) + std::atan(x) +
+                                  std::atan2(y, x) + std::sinh(y) + std::cosh(x) + std::tanh(y) +
+                                  std::asinh(x) + std::acosh(y + 1) + std::atanh(x / 4) + std::sqrt(x) +
+                                  std::cbrt(y) + std::expm1(x) + std::hypot(x, y) + std::pow(x, y) +
+                                  std::abs(x - y) + std::fmod(x, y) + std::copysign(x, y) + std::floor(y);
+                       },
+                       inputs))
+    {
+        return 1;
+    }
+
+    /* Negated powers and non-literal negative exponents */
+    if(!check_gradient("-x ^ 2 + x ^ -y + -(x * y)",
+                       [](double x, double y) { return -x * x + std::pow(x, -y) - x * y; },
+                       inputs))
+    {
+        return 1;
+    }
+
+    /* y only reaches the result through a comparison */
+    if(!check_gradient("x * 2.0 + (y > 1.0)",
+                       [](double x, double y) { return x * 2.0 + (y > 1.0 ? 1.0 : 0.0); },
+                       inputs))
+    {
+        return 1;
+    }
+
+    /* Single token expression */
+    mathexpr::Expr single_token_expr("y");
+
+    if(!single_token_expr.compile_gradient() || single_token_expr.get_gradient_variable_layout().size() != 1)
+    {
+        mathexpr::log_error("Error while compiling gradient of expression \"y\"");
+        return 1;
+    }
+
+    const double y = 1.5;
+    std::array<double, 2> outputs = { 0.0, 0.0 };
+
+    if(!single_token_expr.evaluate_gradient(std::span<const double>(&y, 1), outputs) ||
+       !DOUBLE_EQ(outputs[0], 1.5) ||
+       !DOUBLE_EQ(outputs[1], 1.0))
+    {
+        mathexpr::log_error("Error during gradient evaluation of expression \"y\"");
+        return 1;
+    }
+
+    /* Compiling the gradient leaves the layout of the expression untouched */
+    mathexpr::Expr both_expr("x ^ 0 + y");
+
+    if(!both_expr.compile())
+        return 1;
+
+    const mathexpr::VariableLayout forward_layout = both_expr.get_variable_layout();
+
+    if(!both_expr.compile_gradient())
+        return 1;
+
+    const mathexpr::VariableLayout& layout = both_expr.get_variable_layout();
+
+    if(layout.size() != forward_layout.size())
+        return 1;
+
+    mathexpr::Variables variables;
+
+    for(size_t slot = 0; slot < layout.size(); slot++)
+    {
+        if(layout.get_name(slot) != forward_layout.get_name(slot))
+            return 1;
+
+        variables[layout.get_name(slot)] = layout.get_name(slot) == "y" ? 3.0 : 2.0;
+    }
+
+    auto [both_success, both_res] = both_expr.evaluate(variables);
+
+    if(!both_success || !DOUBLE_EQ(both_res, 4.0))
+    {
+        mathexpr::log_error("Error during evaluation of expression \"x ^ 0 + y\" after compiling its gradient");
+        return 1;
+    }
+
+    mathexpr::log_info("Finished gradient test");
+
+    return 0;
+}
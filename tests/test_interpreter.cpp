@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <bit>
+#include <cmath>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting interpreter test");
+
+    const char* expressions[] = {
+        "x * y + 1.0",
+        "t = x * x + y * y; sqrt(t) + log(t)",
+        "x < y ? x - y : y / x",
+        "(x >= 1.0) + (x == y) + (x != y)",
+        "x ^ 3 + y ^ 0.5 + pow(x, y) + exp(x) * sin(y)",
+        "atan2(y, x) + hypot(x, y) / 2.0 + abs(x - y)",
+        "-x + -(x * y) - -y",
+        "-x ^ 2 + x ^ -y + -sin(x) * -2.0",
+        "(-x < -y ? -x : y) + -(x >= y)",
+    };
+
+    for(const char* expression : expressions)
+    {
+        mathexpr::Expr jitted(expression);
+        mathexpr::Expr interpreted(expression);
+
+        if(!jitted.compile() ||
+           !interpreted.compile(mathexpr::ExprPrintFlags_PrintInterpreter, mathexpr::ExprCompileFlags_Interpreted))
+        {
+            mathexpr::log_error("Error while compiling expression: {}", expression);
+            return 1;
+        }
+
+        const size_t x = interpreted.get_variable_layout().get_slot("x");
+        const size_t y = interpreted.get_variable_layout().get_slot("y");
+
+        /* Interpreted expressions never get promoted to machine code */
+        for(size_t i = 0; i < mathexpr::EXPR_TIERED_JIT_THRESHOLD + 64; i++)
+        {
+            std::array<double, 2> values;
+            values[x] = 0.125 + 0.001 * static_cast<double>(i);
+            values[y] = 2.0 - 0.0005 * static_cast<double>(i);
+
+            auto [interpreted_success, interpreted_res] = interpreted.evaluate(std::span<const double>(values));
+            auto [jitted_success, jitted_res] = jitted.evaluate(std::span<const double>(values));
+
+            /* Both tiers give the same results, bit for bit */
+            if(!interpreted_success ||
+               !jitted_success ||
+               std::bit_cast<uint64_t>(interpreted_res) != std::bit_cast<uint64_t>(jitted_res))
+            {
+                mathexpr::log_error("Interpreted \"{}\" evaluated to {}, expected {}",
+                                    expression,
+                                    interpreted_res,
+                                    jitted_res);
+                return 1;
+            }
+        }
+
+        if(interpreted.is_jit_compiled())
+            return 1;
+    }
+
+    mathexpr::Expr expr("x * 2.0 + y");
+
+    if(!expr.compile(0, mathexpr::ExprCompileFlags_Interpreted | mathexpr::ExprCompileFlags_ParametricLiterals))
+        return 1;
+
+    /* Parametric literals update the interpreter constants */
+    if(!expr.set_literal("2.0", 3.0))
+        return 1;
+
+    auto [success, res] = expr.evaluate(1.0, 0.5);
+
+    if(!success || !DOUBLE_EQ(res, 3.5))
+        return 1;
+
+    /* Batches go through the interpreter row by row */
+    const double xs[] = { 1.0, 2.0, 3.0 };
+    const double ys[] = { 0.5, 0.25, 0.125 };
+    const double* columns[2];
+    columns[expr.get_variable_layout().get_slot("x")] = xs;
+    columns[expr.get_variable_layout().get_slot("y")] = ys;
+
+    double outputs[3];
+
+    if(!expr.evaluate_batch(columns, outputs))
+        return 1;
+
+    for(size_t i = 0; i < 3; i++)
+    {
+        if(!DOUBLE_EQ(outputs[i], xs[i] * 3.0 + ys[i]))
+            return 1;
+    }
+
+    /* There is no machine code to bind to */
+    if(expr.bind<2>())
+        return 1;
+
+    mathexpr::Expr single("x * 2.0");
+
+    if(single.compile(0, mathexpr::ExprCompileFlags_Interpreted | mathexpr::ExprCompileFlags_Float32))
+        return 1;
+
+    mathexpr::log_info("Finished interpreter test");
+
+    return 0;
+}
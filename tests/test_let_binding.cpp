@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting let_binding test");
+
+    const char* expression = "t = x * x + y * y; sqrt(t) + log(t)";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    /* Bound names are not variables of the expression */
+    const mathexpr::VariableLayout& layout = expr.get_variable_layout();
+
+    if(layout.size() != 2 || layout.get_slot("t") != mathexpr::INVALID_VARIABLE_SLOT)
+    {
+        mathexpr::log_error("Invalid variable layout");
+        return 1;
+    }
+
+    mathexpr::Variables variables = { { "x", 3.0 }, { "y", 4.0 } };
+
+    auto [success, res] = expr.evaluate(variables);
+
+    mathexpr::log_info("expr \"{}\" evaluated: (x = 3, y = 4) = {}", expression, res);
+
+    if(!success || !DOUBLE_EQ(res, 5.0 + std::log(25.0)))
+        return 1;
+
+    /* Rebinding a name refers to its previous value */
+    const char* rebound_expression = "u = x + 1.0; u = u * u; u - y;";
+
+    mathexpr::Expr rebound_expr(rebound_expression);
+
+    if(!rebound_expr.compile(mathexpr::ExprPrintFlags_PrintSSA))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    auto [rebound_success, rebound_res] = rebound_expr.evaluate(variables);
+
+    mathexpr::log_info("expr \"{}\" evaluated: (x = 3, y = 4) = {}", rebound_expression, rebound_res);
+
+    if(!rebound_success || !DOUBLE_EQ(rebound_res, 12.0))
+        return 1;
+
+    /* A binding must be terminated by a semicolon */
+    mathexpr::Expr invalid_expr("t = x * x t + 1.0");
+
+    if(invalid_expr.compile())
+    {
+        mathexpr::log_error("Expression with an unterminated binding should not compile");
+        return 1;
+    }
+
+    mathexpr::log_info("Finished let_binding test");
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+#include "mathexpr/lexer.hpp"
+#include "mathexpr/ast.hpp"
+#include "mathexpr/symtable.hpp"
+
+#include "utils.hpp"
+
+struct LiteralCase
+{
+    const char* literal;
+    double value;
+};
+
+bool check_literal(const LiteralCase& literal_case) noexcept
+{
+    const std::string_view literal = literal_case.literal;
+
+    bool well_formed;
+    const uint32_t size = mathexpr::lexer_consume_literal(literal, well_formed);
+
+    double value;
+
+    if(!well_formed || size != literal.size() || !mathexpr::lexer_parse_literal(literal, value))
+    {
+        mathexpr::log_error("Cannot parse literal \"{}\"", literal);
+        return false;
+    }
+
+    mathexpr::log_info("literal \"{}\" parsed: {}", literal, value);
+
+    return value == literal_case.value;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting literal_syntax test");
+
+    const LiteralCase literals[] = {
+        { "42", 42.0 },
+        { "0.5", 0.5 },
+        { "3.", 3.0 },
+        { "1e-9", 1e-9 },
+        { "6.02E+23", 6.02e23 },
+        { "1.e2", 100.0 },
+        { "2.5e0", 2.5 },
+        { "1e-310", 1e-310 },
+        { "0x1f", 31.0 },
+        { "0x1.8p3", 12.0 },
+        { "0X10P-4", 1.0 },
+        { "0x.8p1", 1.0 },
+        { "1_000_000", 1000000.0 },
+        { "1_000.000_5", 1000.0005 },
+        { "0xff_ff", 65535.0 },
+        { "1e1_0", 1e10 },
+    };
+
+    for(const LiteralCase& literal : literals)
+    {
+        if(!check_literal(literal))
+            return 1;
+    }
+
+    const char* ill_formed_literals[] = {
+        "1..2", "1.5.2", "1e", "1e+", "0x", "0x_1", "0x1p", "1__0", "1_", "1_.5", "2x", "1e5e5",
+    };
+
+    for(const char* literal : ill_formed_literals)
+    {
+        bool well_formed;
+        mathexpr::lexer_consume_literal(literal, well_formed);
+
+        if(well_formed)
+        {
+            mathexpr::log_error("Ill-formed literal \"{}\" should not be consumed", literal);
+            return 1;
+        }
+    }
+
+    /* Spans the rest of the literal, the sign only belongs to it right after the exponent mark */
+    bool well_formed;
+
+    if(mathexpr::lexer_consume_literal("2e-3-x", well_formed) != 4 || !well_formed ||
+       mathexpr::lexer_consume_literal("0x1fp+2*x", well_formed) != 7 || !well_formed ||
+       mathexpr::lexer_consume_literal("1.5e+x", well_formed) != 6 || well_formed)
+    {
+        mathexpr::log_error("Wrong literal size");
+        return 1;
+    }
+
+    double value;
+
+    if(mathexpr::lexer_parse_literal("1e400", value) || mathexpr::lexer_parse_literal("0x1p2000", value))
+    {
+        mathexpr::log_error("Out of range literals should not be parsed");
+        return 1;
+    }
+
+    /* Literals are deduplicated by value, whichever way they are written */
+    const char* expression = "x * 1 + y * 1.0 + 0x1p0 - 1_0 / 1e1 + 2.5e-1 * 0.25";
+
+    auto [lex_success, tokens] = mathexpr::lexer_lex_expression(expression);
+
+    mathexpr::AST ast;
+
+    if(!lex_success || !ast.build_from_tokens(tokens))
+    {
+        mathexpr::log_error("Error while parsing expression \"{}\"", expression);
+        return 1;
+    }
+
+    mathexpr::SymbolTable symtable;
+    symtable.collect(ast);
+    symtable.print();
+
+    if(symtable.get_num_literals() != 3 ||
+       symtable.get_literal_offset("1") != symtable.get_literal_offset("1.0") ||
+       symtable.get_literal_offset("1") != symtable.get_literal_offset("0x1p0") ||
+       symtable.get_literal_offset("1_0") != symtable.get_literal_offset("1e1") ||
+       symtable.get_literal_offset("2.5e-1") != symtable.get_literal_offset("0.25"))
+    {
+        mathexpr::log_error("Literals of the same value should share their slot");
+        return 1;
+    }
+
+    const uint64_t compile_flags_cases[] = { 0, mathexpr::ExprCompileFlags_ParametricLiterals };
+
+    for(const uint64_t compile_flags : compile_flags_cases)
+    {
+        mathexpr::Expr expr(expression);
+
+        if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll, compile_flags))
+        {
+            mathexpr::log_error("Error while compiling expression");
+            return 1;
+        }
+
+        auto [success, res] = expr.evaluate(2.0, 3.0);
+
+        mathexpr::log_info("expr \"{}\" evaluated: (2, 3) = {}", expression, res);
+
+        if(!success || !DOUBLE_EQ(res, 5.0625))
+            return 1;
+
+        if(compile_flags == 0)
+            continue;
+
+        /* Updating a literal updates all of its spellings */
+        if(expr.get_literal_layout().size() != 3 || !expr.set_literal("1.0", 2.0))
+        {
+            mathexpr::log_error("Error while updating literal 1.0");
+            return 1;
+        }
+
+        std::tie(success, res) = expr.evaluate(2.0, 3.0);
+
+        mathexpr::log_info("expr \"{}\" with updated literals evaluated: (2, 3) = {}", expression, res);
+
+        if(!success || !DOUBLE_EQ(res, 11.0625))
+            return 1;
+    }
+
+    mathexpr::log_info("Finished literal_syntax test");
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <array>
+#include <tuple>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting mem_operands test");
+
+    const char* expression = "a + b * c - d + e * f - g + h * i - j + k * l - m + n * o - p + q * r - s / t";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    /* 20 variables, offsets past 127 need a 32 bits displacement */
+    std::array<double, 20> values;
+
+    for(size_t i = 0; i < values.size(); i++)
+        values[i] = static_cast<double>(i + 1);
+
+    auto [success, res] = std::apply([&](auto... args) { return expr.evaluate(args...); }, values);
+
+    if(!success)
+    {
+        mathexpr::log_error("Error during expression evaluation");
+        return 1;
+    }
+
+    mathexpr::log_info("expr \"{}\" evaluated: {}", expression, res);
+
+    if(!DOUBLE_EQ(res, 706.05))
+        return 1;
+
+    mathexpr::log_info("Finished mem_operands test");
+
+    return 0;
+}
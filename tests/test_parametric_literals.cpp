@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting parametric_literals test");
+
+    const char* expression = "0.37 * x + 1.2 * y";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(0, mathexpr::ExprCompileFlags_ParametricLiterals))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    auto func = expr.bind<2>();
+
+    if(!func || !DOUBLE_EQ(func(10.0, 5.0), 9.7))
+        return 1;
+
+    const size_t slot = expr.get_literal_layout().get_slot("0.37");
+
+    if(slot == mathexpr::INVALID_VARIABLE_SLOT || !expr.set_literal(slot, 2.0))
+    {
+        mathexpr::log_error("Error while updating literal 0.37");
+        return 1;
+    }
+
+    if(!expr.set_literal("1.2", -1.0))
+    {
+        mathexpr::log_error("Error while updating literal 1.2");
+        return 1;
+    }
+
+    double res = func(10.0, 5.0);
+
+    mathexpr::log_info("expr \"{}\" with updated literals evaluated: (10, 5) = {}", expression, res);
+
+    if(!DOUBLE_EQ(res, 15.0))
+        return 1;
+
+    /* Literals are baked in the code without the flag */
+    mathexpr::Expr constant_expr(expression);
+
+    if(!constant_expr.compile() || constant_expr.set_literal("1.2", 2.0))
+        return 1;
+
+    /* The constants added for x ^ -n and x ^ 0 don't share the slot of the expression literal 1 */
+    struct InternalConstantCase
+    {
+        const char* expression;
+        double value;
+        double expected;
+    };
+
+    const InternalConstantCase internal_constant_cases[] = {
+        { "x ^ -2 + 1", 5.0, 5.25 },
+        { "x ^ 0 + 1", 10.0, 11.0 },
+    };
+
+    const uint64_t compile_flags_cases[] = {
+        mathexpr::ExprCompileFlags_ParametricLiterals,
+        mathexpr::ExprCompileFlags_ParametricLiterals | mathexpr::ExprCompileFlags_Interpreted,
+    };
+
+    for(const InternalConstantCase& internal_constant_case : internal_constant_cases)
+    {
+        for(const uint64_t compile_flags : compile_flags_cases)
+        {
+            mathexpr::Expr internal_constant_expr(internal_constant_case.expression);
+
+            if(!internal_constant_expr.compile(0, compile_flags) ||
+               internal_constant_expr.get_literal_layout().size() != 1 ||
+               !internal_constant_expr.set_literal(size_t(0), internal_constant_case.value))
+            {
+                mathexpr::log_error("Error while updating the literal of \"{}\"", internal_constant_case.expression);
+                return 1;
+            }
+
+            /* x ^ 0 doesn't use x */
+            const double x = 2.0;
+
+            auto [success, res] = internal_constant_expr.evaluate(
+                std::span<const double>(&x, internal_constant_expr.get_variable_layout().size()));
+
+            mathexpr::log_info("expr \"{}\" with updated literal evaluated: (2) = {}", internal_constant_case.expression, res);
+
+            if(!success || !DOUBLE_EQ(res, internal_constant_case.expected))
+                return 1;
+        }
+    }
+
+    mathexpr::log_info("Finished parametric_literals test");
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+#include "mathexpr/lexer.hpp"
+#include "mathexpr/ast.hpp"
+#include "mathexpr/interpreter.hpp"
+
+#include "utils.hpp"
+
+/* Evaluates the SSA built from the AST and the one parsed straight from the source */
+bool check_expression(const char* expression) noexcept
+{
+    static constexpr double VALUES[] = { 1.5, 2.25, -3.0, 4.5 };
+
+    auto [lex_success, tokens] = mathexpr::lexer_lex_expression(expression);
+
+    mathexpr::AST ast;
+
+    if(!lex_success || !ast.build_from_tokens(tokens))
+        return false;
+
+    mathexpr::SymbolTable ast_symtable;
+    ast_symtable.collect(ast);
+
+    mathexpr::SSA ast_ssa;
+
+    if(!ast_ssa.build_from_ast(ast))
+        return false;
+
+    mathexpr::SymbolTable source_symtable;
+    mathexpr::SSA source_ssa;
+
+    if(!source_ssa.build_from_source(expression, source_symtable))
+        return false;
+
+    source_ssa.print();
+
+    /* Literals are only emitted when used, unused bindings are dropped */
+    if(source_ssa.get_statements().size() > ast_ssa.get_statements().size())
+    {
+        mathexpr::log_error("Parsing \"{}\" built {} statements, the AST {}",
+                            expression,
+                            source_ssa.get_statements().size(),
+                            ast_ssa.get_statements().size());
+
+        return false;
+    }
+
+    if(source_symtable.get_variables().size() != ast_symtable.get_variables().size())
+        return false;
+
+    for(const auto& [name, variable] : ast_symtable.get_variables())
+    {
+        if(source_symtable.get_variable_offset(name) != variable.get_offset())
+            return false;
+    }
+
+    mathexpr::Interpreter ast_interpreter;
+    mathexpr::Interpreter source_interpreter;
+
+    if(!ast_interpreter.build(ast_ssa, ast_symtable) || !source_interpreter.build(source_ssa, source_symtable))
+        return false;
+
+    const double ast_res = ast_interpreter.evaluate(VALUES);
+    const double source_res = source_interpreter.evaluate(VALUES);
+
+    mathexpr::log_info("expr \"{}\" evaluated: {} (AST: {})", expression, source_res, ast_res);
+
+    return DOUBLE_EQ(ast_res, source_res);
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting parser test");
+
+    const char* expressions[] = {
+        "a + b * c - d / a",
+        "a - b - c + a * b / c",
+        "-a ^ 2 + a ^ -2 - 2 ^ 3 ^ 0.5",
+        "(a + b) ^ 0 + a ^ 2.5 + b ^ -(2) + -(3) * a",
+        "a ^ b + sqrt(abs(c)) + pow(a, 3) + atan2(b, a)",
+        "a < b ? c : d",
+        "select(a - 1.5, c, d) + select(b >= a, 1, 2) + (a == b) + (c != d) * 4",
+        "a < b < c",
+        "t = a * b; u = c * c; t + t * d",
+        "k = 2; m = a > b; a ^ k - k + select(m, c, d) + m",
+        "t = a + 1.0; t = t * t; t - b;",
+    };
+
+    for(const char* expression : expressions)
+    {
+        if(!check_expression(expression))
+        {
+            mathexpr::log_error("Error while checking expression \"{}\"", expression);
+            return 1;
+        }
+    }
+
+    const char* invalid_expressions[] = {
+        "sin(a",
+        "a + * b",
+        "1..2 + a",
+        "a b",
+        "t = a * a t + 1.0",
+        "a ? b",
+        "select(a, b)",
+        "",
+    };
+
+    for(const char* expression : invalid_expressions)
+    {
+        mathexpr::SymbolTable symtable;
+        mathexpr::SSA ssa;
+
+        if(ssa.build_from_source(expression, symtable))
+        {
+            mathexpr::log_error("Invalid expression \"{}\" should not be parsed", expression);
+            return 1;
+        }
+    }
+
+    mathexpr::log_info("Finished parser test");
+
+    return 0;
+}
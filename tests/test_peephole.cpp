@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+#include "mathexpr/lexer.hpp"
+#include "mathexpr/ast.hpp"
+#include "mathexpr/codegen.hpp"
+
+#include "utils.hpp"
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting peephole test");
+
+    const char* expression = "sqrt(abs(a)) * b";
+
+    /* Nested calls share the base pointers save/restore sequence */
+    auto [lex_success, tokens] = mathexpr::lexer_lex_expression(expression);
+
+    mathexpr::AST ast;
+
+    if(!lex_success || !ast.build_from_tokens(tokens))
+        return 1;
+
+    mathexpr::SymbolTable symtable;
+    symtable.collect(ast);
+
+    mathexpr::SSA ssa;
+
+    if(!ssa.build_from_ast(ast))
+        return 1;
+
+    mathexpr::PlatformABIPtr platform_abi = mathexpr::get_current_platform_abi(mathexpr::get_current_isa(),
+                                                                               mathexpr::get_current_platform());
+
+    mathexpr::RegisterAllocator reg_allocator(platform_abi);
+
+    if(!reg_allocator.allocate(ssa, symtable))
+        return 1;
+
+    mathexpr::CodeGenerator generator(mathexpr::get_current_isa(), platform_abi);
+
+    if(!generator.build(ssa, reg_allocator, symtable))
+        return 1;
+
+    const mathexpr::PeepholeStats& stats = generator.get_peephole_stats();
+
+    mathexpr::log_info("Peephole stats: {} instructions, {} bytes removed",
+                       stats.removed_instructions,
+                       stats.removed_bytes);
+
+    if(stats.removed_instructions == 0 || stats.removed_bytes == 0)
+        return 1;
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    double a = -16.0;
+    double b = 3.0;
+
+    auto [success, res] = expr.evaluate(a, b);
+
+    if(!success)
+    {
+        mathexpr::log_error("Error during expression evaluation");
+        return 1;
+    }
+
+    mathexpr::log_info("expr \"{}\" evaluated: ({}, {}) = {}",
+                        expression,
+                        a,
+                        b,
+                        res);
+
+    if(!DOUBLE_EQ(res, 12.0))
+        return 1;
+
+    mathexpr::log_info("Finished peephole test");
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting pow test");
+
+    /* Specialized exponents (integers, half-integers, negative, zero) and a pow call */
+    const char* expression = "x ^ 3 + x ^ 2.5 + y ^ -2 + y ^ 0 + x ^ y ^ 0.5 + 2 * x ^ 2";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    auto reference = [](double x, double y) {
+        return std::pow(x, 3.0) + std::pow(x, 2.5) + std::pow(y, -2.0) + 1.0 + std::pow(x, std::sqrt(y)) + 2.0 * x * x;
+    };
+
+    const double inputs[][2] = {
+        { 2.0, 4.0 },
+        { 1.5, 0.25 },
+        { 9.0, 2.0 },
+    };
+
+    for(const auto& [x, y] : inputs)
+    {
+        mathexpr::Variables variables = { { "x", x }, { "y", y } };
+
+        auto [success, res] = expr.evaluate(variables);
+
+        mathexpr::log_info("expr \"{}\" evaluated: (x = {}, y = {}) = {}", expression, x, y, res);
+
+        if(!success || !DOUBLE_EQ(res, reference(x, y)))
+            return 1;
+    }
+
+    /* Non-literal negative exponents and negated powers, -x ^ 2 is -(x ^ 2) */
+    const char* negative_expression = "x ^ -y + -x ^ 2 + 2 ^ -x + x ^ -(y + 1) + -2 ^ 2 - y ^ -x ^ 2";
+
+    auto negative_reference = [](double x, double y) {
+        return std::pow(x, -y) - x * x + std::pow(2.0, -x) + std::pow(x, -(y + 1.0)) - 4.0 - std::pow(y, -(x * x));
+    };
+
+    mathexpr::Expr negative_jitted(negative_expression);
+    mathexpr::Expr negative_interpreted(negative_expression);
+
+    if(!negative_jitted.compile(mathexpr::ExprPrintFlags_PrintAll) ||
+       !negative_interpreted.compile(0, mathexpr::ExprCompileFlags_Interpreted))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    for(const auto& [x, y] : inputs)
+    {
+        mathexpr::Variables variables = { { "x", x }, { "y", y } };
+
+        auto [jitted_success, jitted_res] = negative_jitted.evaluate(variables);
+        auto [interpreted_success, interpreted_res] = negative_interpreted.evaluate(variables);
+
+        mathexpr::log_info("expr \"{}\" evaluated: (x = {}, y = {}) = {} (interpreted {})",
+                           negative_expression,
+                           x,
+                           y,
+                           jitted_res,
+                           interpreted_res);
+
+        if(!jitted_success ||
+           !interpreted_success ||
+           !DOUBLE_EQ(jitted_res, negative_reference(x, y)) ||
+           !DOUBLE_EQ(interpreted_res, negative_reference(x, y)))
+        {
+            return 1;
+        }
+    }
+
+    mathexpr::log_info("Finished pow test");
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+using Reference = std::function<double(double, double)>;
+
+/* Compares the jitted reduction with a loop over the reference, for row counts around the unrolling */
+bool check_reduction(const char* expression, const Reference& reference, bool mean)
+{
+    mathexpr::ExprReduction reduction(expression);
+
+    if(!reduction.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling reduction \"{}\"", expression);
+        return false;
+    }
+
+    const size_t x = reduction.get_variable_layout().get_slot("x");
+    const size_t y = reduction.get_variable_layout().get_slot("y");
+
+    for(const size_t num_rows : { 1, 3, 4, 7, 64, 1001 })
+    {
+        std::vector<double> xs(num_rows);
+        std::vector<double> ys(num_rows);
+
+        double expected = 0.0;
+
+        for(size_t i = 0; i < num_rows; i++)
+        {
+            xs[i] = 0.5 + static_cast<double>(i % 17) * 0.25;
+            ys[i] = 1.0 + static_cast<double>(i % 5) * 0.5;
+
+            expected += reference(xs[i], ys[i]);
+        }
+
+        if(mean)
+            expected /= static_cast<double>(num_rows);
+
+        std::array<const double*, 2> columns;
+        columns[x] = xs.data();
+        columns[y] = ys.data();
+
+        auto [success, result] = reduction.evaluate(columns, num_rows);
+
+        mathexpr::log_info("reduction \"{}\" evaluated over {} rows: {} (expected {})",
+                           expression,
+                           num_rows,
+                           result,
+                           expected);
+
+        if(!success || !DOUBLE_EQ(result / expected, 1.0))
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting reduction test");
+
+    /* Function calls and literals in the body, shared by the unrolled rows */
+    if(!check_reduction("sum(x * y + sin(x) / y - 2.0)",
+                        [](double x, double y) { return x * y + std::sin(x) / y - 2.0; },
+                        false))
+    {
+        return 1;
+    }
+
+    if(!check_reduction("mean(x ^ 2 + (x < y ? x : y))",
+                        [](double x, double y) { return x * x + (x < y ? x : y); },
+                        true))
+    {
+        return 1;
+    }
+
+    if(!check_reduction("dot(x + 1.0, exp(y / 4.0))",
+                        [](double x, double y) { return (x + 1.0) * std::exp(y / 4.0); },
+                        false))
+    {
+        return 1;
+    }
+
+    /* Reductions are only valid at the root */
+    mathexpr::ExprReduction invalid("sum(x) + 1.0");
+
+    if(invalid.compile())
+        return 1;
+
+    mathexpr::log_info("Finished reduction test");
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <cmath>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting select test");
+
+    /* Piecewise function, both forms of select and comparisons used as values */
+    const char* expression = "(x < 0.0 ? 0.0 - x : x * 2.0) + select(y >= x, 10.0, 20.0) + (x == y) + select(z, 100.0, 200.0)";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile(mathexpr::ExprPrintFlags_PrintAll))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    auto reference = [](double x, double y, double z) {
+        return (x < 0.0 ? 0.0 - x : x * 2.0) + (y >= x ? 10.0 : 20.0) + (x == y ? 1.0 : 0.0) + (z != 0.0 ? 100.0 : 200.0);
+    };
+
+    const double inputs[][3] = {
+        { -3.0, 1.0, 0.0 },
+        { 3.0, 1.0, 1.0 },
+        { 2.0, 2.0, -1.0 },
+        { 0.0, -5.0, 0.0 },
+        { 1.0, NAN, 2.0 },
+    };
+
+    for(const auto& [x, y, z] : inputs)
+    {
+        mathexpr::Variables variables = { { "x", x }, { "y", y }, { "z", z } };
+
+        auto [success, res] = expr.evaluate(variables);
+
+        mathexpr::log_info("expr \"{}\" evaluated: (x = {}, y = {}, z = {}) = {}", expression, x, y, z, res);
+
+        if(!success || !DOUBLE_EQ(res, reference(x, y, z)))
+            return 1;
+    }
+
+    /* The branch not taken is computed but never leaks into the result, even when it is not finite */
+    mathexpr::Expr guarded_expr("x != 0.0 ? 1.0 / x : 0.0");
+
+    if(!guarded_expr.compile())
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    auto [guarded_success, guarded_res] = guarded_expr.evaluate({ { "x", 0.0 } });
+
+    if(!guarded_success || !DOUBLE_EQ(guarded_res, 0.0))
+        return 1;
+
+    mathexpr::Expr invalid_expr("select(x, 1.0)");
+
+    if(invalid_expr.compile())
+    {
+        mathexpr::log_error("select with 2 arguments should not compile");
+        return 1;
+    }
+
+    mathexpr::log_info("Finished select test");
+
+    return 0;
+}
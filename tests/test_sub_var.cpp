@@ -39,7 +39,7 @@ int main(int argc, char** argv)
                         b,
                         res);
 
-    if(!DOUBLE_EQ(res, -18.0))
+    if(!DOUBLE_EQ(res, -14.0))
     {
         return 1;
     }
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting tiered test");
+
+    /* Calls, specialized powers, comparisons, select and let-bindings in the interpreter */
+    const char* expression = "d = x - y; sin(x) * d ^ 3 + pow(y, 0.5) * (x < y ? d : y - x) + (x >= 1.0) + "
+                             "atan2(y, x) / 2.0 + x ^ 2.5";
+
+    auto reference = [](double x, double y) {
+        const double d = x - y;
+        return std::sin(x) * d * d * d + std::pow(y, 0.5) * (x < y ? d : y - x) + (x >= 1.0 ? 1.0 : 0.0) +
+               std::atan2(y, x) / 2.0 + std::pow(x, 2.5);
+    };
+
+    mathexpr::Expr jitted(expression);
+    mathexpr::Expr tiered(expression);
+
+    if(!jitted.compile() || !tiered.compile(mathexpr::ExprPrintFlags_PrintAll, mathexpr::ExprCompileFlags_Tiered))
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    if(tiered.is_jit_compiled())
+        return 1;
+
+    const size_t x = tiered.get_variable_layout().get_slot("x");
+    const size_t y = tiered.get_variable_layout().get_slot("y");
+
+    /* The interpreter and the generated code give the same results */
+    for(size_t i = 0; i < 64; i++)
+    {
+        std::array<double, 2> values;
+        values[x] = 0.125 * static_cast<double>(i);
+        values[y] = 0.25 + 0.0625 * static_cast<double>(i);
+
+        auto [tiered_success, tiered_res] = tiered.evaluate(std::span<const double>(values));
+        auto [jitted_success, jitted_res] = jitted.evaluate(std::span<const double>(values));
+
+        if(!tiered_success || !jitted_success || tiered_res != jitted_res ||
+           !DOUBLE_EQ(tiered_res, reference(values[x], values[y])))
+        {
+            mathexpr::log_error("Interpreted \"{}\" evaluated to {} (jitted {}, expected {})",
+                                expression,
+                                tiered_res,
+                                jitted_res,
+                                reference(values[x], values[y]));
+            return 1;
+        }
+    }
+
+    if(tiered.is_jit_compiled())
+        return 1;
+
+    /* Hot expressions get promoted to machine code in the background */
+    const auto start = std::chrono::steady_clock::now();
+
+    while(!tiered.is_jit_compiled())
+    {
+        if(std::chrono::steady_clock::now() - start > std::chrono::seconds(10))
+        {
+            mathexpr::log_error("Expression has not been promoted");
+            return 1;
+        }
+
+        auto [success, res] = tiered.evaluate(0.5, 1.5);
+
+        if(!success || !DOUBLE_EQ(res, reference(0.5, 1.5)))
+            return 1;
+
+        std::this_thread::yield();
+    }
+
+    auto [success, res] = tiered.evaluate(0.5, 1.5);
+
+    if(!success || !DOUBLE_EQ(res, reference(0.5, 1.5)))
+        return 1;
+
+    /* Negations give the same results before and after the promotion */
+    const char* negation_expression = "-x * y + -(x - y) / 2.0 + x ^ -y";
+
+    mathexpr::Expr negation(negation_expression);
+
+    if(!negation.compile(0, mathexpr::ExprCompileFlags_Tiered))
+        return 1;
+
+    const double negation_inputs[][2] = { { 1.3, 0.7 }, { -2.5, 1.0 }, { 0.5, 2.0 } };
+
+    std::array<double, 3> interpreted_results;
+
+    for(size_t i = 0; i < 3; i++)
+    {
+        auto [negation_success, negation_res] = negation.evaluate(negation_inputs[i][0], negation_inputs[i][1]);
+
+        if(!negation_success || negation.is_jit_compiled())
+            return 1;
+
+        interpreted_results[i] = negation_res;
+    }
+
+    if(!negation.bind<2>() || !negation.is_jit_compiled())
+        return 1;
+
+    for(size_t i = 0; i < 3; i++)
+    {
+        const auto [x_value, y_value] = negation_inputs[i];
+        const double expected = -x_value * y_value + -(x_value - y_value) / 2.0 + std::pow(x_value, -y_value);
+
+        auto [negation_success, negation_res] = negation.evaluate(x_value, y_value);
+
+        mathexpr::log_info("expr \"{}\" evaluated: ({}, {}) = {} (interpreted {}, expected {})",
+                           negation_expression,
+                           x_value,
+                           y_value,
+                           negation_res,
+                           interpreted_results[i],
+                           expected);
+
+        if(!negation_success || negation_res != interpreted_results[i] || !DOUBLE_EQ(negation_res, expected))
+            return 1;
+    }
+
+    /* Binding promotes the expression right away */
+    mathexpr::Expr bound("x * y + 1.0");
+
+    if(!bound.compile(0, mathexpr::ExprCompileFlags_Tiered))
+        return 1;
+
+    auto func = bound.bind<2>();
+
+    if(!func || !bound.is_jit_compiled() || !DOUBLE_EQ(func(2.0, 3.0), 7.0))
+        return 1;
+
+    mathexpr::log_info("Finished tiered test");
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+
+#include "utils.hpp"
+
+bool same_layout(const mathexpr::VariableLayout& a, const mathexpr::VariableLayout& b) noexcept
+{
+    if(a.size() != b.size())
+        return false;
+
+    for(size_t slot = 0; slot < a.size(); slot++)
+    {
+        if(a.get_name(slot) != b.get_name(slot))
+            return false;
+    }
+
+    return true;
+}
+
+/* Expressions, groups, reductions and gradients read the same variables, in the same order */
+bool check_layouts(const std::string& expression, bool reduction) noexcept
+{
+    mathexpr::Expr expr(expression);
+    mathexpr::ExprGroup group({ expression });
+
+    if(!expr.compile() || !expr.compile_gradient() || !group.compile())
+    {
+        mathexpr::log_error("Error while compiling expression \"{}\"", expression);
+        return false;
+    }
+
+    if(!same_layout(expr.get_variable_layout(), group.get_variable_layout()) ||
+       !same_layout(expr.get_variable_layout(), expr.get_gradient_variable_layout()))
+    {
+        mathexpr::log_error("Layouts of expression \"{}\" differ", expression);
+        return false;
+    }
+
+    if(!reduction)
+        return true;
+
+    mathexpr::ExprReduction sum(std::format("sum({})", expression));
+
+    return sum.compile() && same_layout(expr.get_variable_layout(), sum.get_variable_layout());
+}
+
+int main(int argc, char** argv)
+{
+    mathexpr::set_log_level(mathexpr::LogLevel::Debug);
+    mathexpr::log_info("Starting variable_layout test");
+
+    /* Variables appear in a different order than the alphabetical one */
+    const char* expression = "z * 2.0 + a - m / 4.0";
+
+    mathexpr::Expr expr(expression);
+
+    if(!expr.compile())
+    {
+        mathexpr::log_error("Error while compiling expression");
+        return 1;
+    }
+
+    const mathexpr::VariableLayout& layout = expr.get_variable_layout();
+
+    const size_t a = layout.get_slot("a");
+    const size_t m = layout.get_slot("m");
+    const size_t z = layout.get_slot("z");
+
+    if(layout.size() != 3 ||
+       a == mathexpr::INVALID_VARIABLE_SLOT ||
+       m == mathexpr::INVALID_VARIABLE_SLOT ||
+       z == mathexpr::INVALID_VARIABLE_SLOT ||
+       layout.get_slot("b") != mathexpr::INVALID_VARIABLE_SLOT)
+    {
+        mathexpr::log_error("Invalid variable layout");
+        return 1;
+    }
+
+    std::array<double, 3> values;
+    values[a] = 1.0;
+    values[m] = 8.0;
+    values[z] = 10.0;
+
+    auto [success, res] = expr.evaluate(std::span<const double>(values));
+
+    mathexpr::log_info("expr \"{}\" evaluated: (a = 1, m = 8, z = 10) = {}", expression, res);
+
+    if(!success || !DOUBLE_EQ(res, 19.0))
+        return 1;
+
+    mathexpr::Variables variables = { { "a", 1.0 }, { "m", 8.0 }, { "z", 10.0 } };
+
+    auto [map_success, map_res] = expr.evaluate(variables);
+
+    if(!map_success || !DOUBLE_EQ(map_res, 19.0))
+        return 1;
+
+    /* Expressions without variables take an empty layout */
+    mathexpr::Expr constant_expr("2 + 3");
+
+    if(!constant_expr.compile() || constant_expr.get_variable_layout().size() != 0)
+        return 1;
+
+    auto [constant_success, constant_res] = constant_expr.evaluate(std::span<const double>());
+
+    if(!constant_success || !DOUBLE_EQ(constant_res, 5.0))
+    {
+        mathexpr::log_error("Error while evaluating expression \"2 + 3\" with an empty span");
+        return 1;
+    }
+
+    /* Variables only used by removed code (x ^ 0, unused bindings) are not part of the layouts */
+    mathexpr::Expr unused_expr("x ^ 0 + y");
+
+    if(!unused_expr.compile() || unused_expr.get_variable_layout().size() != 1)
+        return 1;
+
+    auto [unused_success, unused_res] = unused_expr.evaluate(mathexpr::Variables{ { "y", 3.0 } });
+
+    if(!unused_success || !DOUBLE_EQ(unused_res, 4.0))
+        return 1;
+
+    if(!check_layouts("x ^ 0 + y", true) ||
+       !check_layouts("c * b ^ 0 - a + (b - b) ^ 0 * c", true) ||
+       !check_layouts("t = a * b; u = c * c; d - t", false) ||
+       !check_layouts("s = b ^ 0; w = s + a; w * d + c ^ 0", false))
+    {
+        return 1;
+    }
+
+    mathexpr::log_info("Finished variable_layout test");
+
+    return 0;
+}
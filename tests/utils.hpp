@@ -6,4 +6,4 @@
 
 static constexpr double EPSILON = 0.00001;
 
-#define DOUBLE_EQ(a, b) ((::fabs(a) - ::fabs(b)) < EPSILON)
\ No newline at end of file
+#define DOUBLE_EQ(a, b) (::fabs((a) - (b)) < EPSILON)
\ No newline at end of file
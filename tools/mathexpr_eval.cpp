@@ -0,0 +1,612 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2025 - Present Romain Augier
+// All rights reserved.
+
+/*
+    mathexpr-eval: evaluates an expression for every row of a CSV file or a column file (see
+    mathexpr/column_file.hpp) and writes the results, one per line, to an output file.
+
+    The variables of the expression are bound to the columns of the same name, named by the first
+    line of a CSV file. Other columns are ignored.
+
+    The input is memory-mapped and processed by windows. Each window is split into a chunk per thread,
+    at line boundaries for CSV files. Each thread parses its chunk into a column per variable (column
+    files are evaluated in place), evaluates them with Expr::evaluate_batch and formats the results.
+    The chunks are then written in order and the pages of the window released, so memory stays
+    bounded by the number of threads times the chunk size, whatever the size of the input.
+*/
+
+#include "mathexpr/log.hpp"
+#include "mathexpr/expr.hpp"
+#include "mathexpr/column_file.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t DEFAULT_CHUNK_SIZE_MB = 4;
+
+/* Enough for the shortest round-trip representation of any double, and the line feed */
+static constexpr size_t MAX_FORMATTED_VALUE_SIZE = 32;
+
+static constexpr size_t INVALID_ERROR_OFFSET = std::numeric_limits<size_t>::max();
+
+/* Part of a window processed by a single thread, the buffers are reused from one window to the next */
+struct Chunk
+{
+    /* Bytes of a CSV file, rows of a column file */
+    size_t begin = 0;
+    size_t end = 0;
+
+    std::vector<std::vector<double>> columns;
+    std::vector<const double*> column_ptrs;
+    std::vector<double> outputs;
+
+    std::string text;
+
+    size_t num_rows = 0;
+    size_t error_offset = INVALID_ERROR_OFFSET;
+};
+
+struct Options
+{
+    const char* expression = nullptr;
+    const char* input = nullptr;
+    const char* output = nullptr;
+
+    size_t num_threads = 0;
+    size_t chunk_size = DEFAULT_CHUNK_SIZE_MB * 1024 * 1024;
+    char delimiter = ',';
+    bool verbose = false;
+};
+
+void print_usage() noexcept
+{
+    std::cerr << "usage: mathexpr-eval [options] <expression> <input> <output>\n"
+                 "\n"
+                 "Evaluates the expression for every row of the input, a CSV file or a column file, the variables\n"
+                 "being read from the columns of the same name, and writes the results one per line to the output\n"
+                 "(\"-\" for stdout)\n"
+                 "\n"
+                 "options:\n"
+                 "  -t, --threads <n>       number of threads, defaults to the number of cores\n"
+                 "  -c, --chunk-size <mb>   size of the input parsed at once by each thread, defaults to 4\n"
+                 "  -d, --delimiter <c>     column delimiter of CSV files, defaults to ','\n"
+                 "  -v, --verbose           print the compilation steps\n";
+}
+
+bool parse_size(const char* str, size_t& value) noexcept
+{
+    const char* end = str + std::strlen(str);
+    const auto [ptr, ec] = std::from_chars(str, end, value);
+
+    return ec == std::errc() && ptr == end && value > 0;
+}
+
+bool parse_options(int argc, char** argv, Options& options) noexcept
+{
+    std::vector<const char*> positionals;
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        const bool has_value = i + 1 < argc;
+
+        if((arg == "-t" || arg == "--threads") && has_value)
+        {
+            if(!parse_size(argv[++i], options.num_threads))
+                return false;
+        }
+        else if((arg == "-c" || arg == "--chunk-size") && has_value)
+        {
+            if(!parse_size(argv[++i], options.chunk_size))
+                return false;
+
+            options.chunk_size *= 1024 * 1024;
+        }
+        else if((arg == "-d" || arg == "--delimiter") && has_value)
+        {
+            const std::string_view delimiter = argv[++i];
+
+            if(delimiter.size() != 1 || delimiter[0] == '\n')
+                return false;
+
+            options.delimiter = delimiter[0];
+        }
+        else if(arg == "-v" || arg == "--verbose")
+        {
+            options.verbose = true;
+        }
+        else if(arg.size() > 1 && arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            positionals.push_back(argv[i]);
+        }
+    }
+
+    if(positionals.size() != 3)
+        return false;
+
+    options.expression = positionals[0];
+    options.input = positionals[1];
+    options.output = positionals[2];
+
+    if(options.num_threads == 0)
+        options.num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    return true;
+}
+
+inline bool is_blank(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* Returns the offset just after the next line feed from offset, or size if there is none */
+size_t find_next_line(const char* data, size_t size, size_t offset) noexcept
+{
+    const void* lf = std::memchr(data + offset, '\n', size - offset);
+
+    return lf == nullptr ? size : static_cast<size_t>(static_cast<const char*>(lf) - data) + 1;
+}
+
+/*
+    Maps the columns of the header to the slots of the variables, INVALID_VARIABLE_SLOT for the
+    columns the expression does not use
+*/
+bool parse_header(std::string_view header,
+                  char delimiter,
+                  const mathexpr::VariableLayout& variables,
+                  std::vector<size_t>& column_slots) noexcept
+{
+    std::vector<bool> found(variables.size(), false);
+
+    while(true)
+    {
+        const size_t delimiter_pos = header.find(delimiter);
+
+        std::string_view name = header.substr(0, delimiter_pos);
+
+        while(!name.empty() && is_blank(name.front()))
+            name.remove_prefix(1);
+
+        while(!name.empty() && is_blank(name.back()))
+            name.remove_suffix(1);
+
+        const size_t slot = variables.get_slot(name);
+
+        if(slot != mathexpr::INVALID_VARIABLE_SLOT)
+        {
+            if(found[slot])
+            {
+                mathexpr::log_error("Column \"{}\" appears several times in the input", name);
+                return false;
+            }
+
+            found[slot] = true;
+        }
+
+        column_slots.push_back(slot);
+
+        if(delimiter_pos == std::string_view::npos)
+            break;
+
+        header.remove_prefix(delimiter_pos + 1);
+    }
+
+    /* Only the columns up to the last one used are parsed */
+    while(!column_slots.empty() && column_slots.back() == mathexpr::INVALID_VARIABLE_SLOT)
+        column_slots.pop_back();
+
+    for(size_t slot = 0; slot < variables.size(); slot++)
+    {
+        if(!found[slot])
+        {
+            mathexpr::log_error("Variable \"{}\" has no matching column in the input", variables.get_name(slot));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Evaluates the columns of a chunk and formats the results */
+void evaluate_chunk(const mathexpr::Expr& expr, Chunk& chunk) noexcept
+{
+    chunk.outputs.resize(chunk.num_rows);
+
+    if(!expr.evaluate_batch(chunk.column_ptrs, chunk.outputs))
+    {
+        chunk.error_offset = chunk.begin;
+        chunk.text.clear();
+        return;
+    }
+
+    chunk.text.resize(chunk.num_rows * MAX_FORMATTED_VALUE_SIZE);
+
+    char* text = chunk.text.data();
+
+    for(const double output : chunk.outputs)
+    {
+        text = std::to_chars(text, text + MAX_FORMATTED_VALUE_SIZE - 1, output).ptr;
+        *text++ = '\n';
+    }
+
+    chunk.text.resize(static_cast<size_t>(text - chunk.text.data()));
+}
+
+/* Parses the rows of a chunk of a CSV file, evaluates them and formats the results */
+void process_csv_chunk(const mathexpr::Expr& expr,
+                       const char* data,
+                       const std::vector<size_t>& column_slots,
+                       char delimiter,
+                       Chunk& chunk) noexcept
+{
+    for(auto& column : chunk.columns)
+        column.clear();
+
+    chunk.num_rows = 0;
+    chunk.error_offset = INVALID_ERROR_OFFSET;
+
+    size_t line = chunk.begin;
+
+    while(line < chunk.end)
+    {
+        const size_t next_line = find_next_line(data, chunk.end, line);
+
+        const char* ptr = data + line;
+        const char* line_end = data + next_line;
+
+        while(line_end > ptr && (line_end[-1] == '\n' || line_end[-1] == '\r'))
+            line_end--;
+
+        /* Empty lines, usually the one after the last line feed, are skipped */
+        if(ptr == line_end)
+        {
+            line = next_line;
+            continue;
+        }
+
+        for(size_t column = 0; column < column_slots.size(); column++)
+        {
+            const void* delimiter_ptr = std::memchr(ptr, delimiter, static_cast<size_t>(line_end - ptr));
+            const char* field_end = delimiter_ptr == nullptr ? line_end : static_cast<const char*>(delimiter_ptr);
+
+            const size_t slot = column_slots[column];
+
+            if(slot != mathexpr::INVALID_VARIABLE_SLOT)
+            {
+                while(ptr < field_end && is_blank(*ptr))
+                    ptr++;
+
+                /* std::from_chars does not accept an explicit plus sign */
+                if(ptr < field_end && *ptr == '+')
+                    ptr++;
+
+                double value;
+                const auto [value_end, ec] = std::from_chars(ptr, field_end, value);
+
+                ptr = value_end;
+
+                while(ptr < field_end && is_blank(*ptr))
+                    ptr++;
+
+                if(ec != std::errc() || ptr != field_end)
+                {
+                    chunk.error_offset = line;
+                    return;
+                }
+
+                chunk.columns[slot].push_back(value);
+            }
+
+            if(delimiter_ptr == nullptr && column + 1 < column_slots.size())
+            {
+                chunk.error_offset = line;
+                return;
+            }
+
+            ptr = field_end + 1;
+        }
+
+        chunk.num_rows++;
+        line = next_line;
+    }
+
+    for(size_t slot = 0; slot < chunk.columns.size(); slot++)
+        chunk.column_ptrs[slot] = chunk.columns[slot].data();
+
+    evaluate_chunk(expr, chunk);
+}
+
+/* Evaluates the rows of a chunk of a column file in place */
+void process_column_file_chunk(const mathexpr::Expr& expr,
+                               const std::vector<const double*>& columns,
+                               Chunk& chunk) noexcept
+{
+    for(size_t slot = 0; slot < columns.size(); slot++)
+        chunk.column_ptrs[slot] = columns[slot] + chunk.begin;
+
+    chunk.num_rows = chunk.end - chunk.begin;
+    chunk.error_offset = INVALID_ERROR_OFFSET;
+
+    evaluate_chunk(expr, chunk);
+}
+
+/* Processes the chunks in parallel, the first one on the calling thread */
+void process_chunks(std::span<Chunk> chunks, const std::function<void(Chunk&)>& process) noexcept
+{
+    std::vector<std::thread> threads;
+    threads.reserve(chunks.size());
+
+    for(size_t i = 1; i < chunks.size(); i++)
+        threads.emplace_back(process, std::ref(chunks[i]));
+
+    process(chunks[0]);
+
+    for(std::thread& thread : threads)
+        thread.join();
+}
+
+/* Writes the results of the chunks in order */
+bool write_chunks(std::span<const Chunk> chunks, FILE* output, const Options& options, size_t& num_rows) noexcept
+{
+    for(const Chunk& chunk : chunks)
+    {
+        if(std::fwrite(chunk.text.data(), 1, chunk.text.size(), output) != chunk.text.size())
+        {
+            mathexpr::log_error("Error while writing to output file \"{}\"", options.output);
+            return false;
+        }
+
+        num_rows += chunk.num_rows;
+    }
+
+    return true;
+}
+
+bool evaluate_csv(const mathexpr::Expr& expr,
+                  const Options& options,
+                  FILE* output,
+                  size_t& num_rows,
+                  size_t& num_bytes) noexcept
+{
+    mathexpr::MappedFile input;
+
+    if(!input.open(options.input))
+        return false;
+
+    const char* data = reinterpret_cast<const char*>(input.data());
+    const size_t size = input.size();
+
+    if(size == 0)
+    {
+        mathexpr::log_error("Input file \"{}\" is empty, it needs at least a header", options.input);
+        return false;
+    }
+
+    const size_t header_end = find_next_line(data, size, 0);
+
+    std::vector<size_t> column_slots;
+
+    if(!parse_header(std::string_view(data, header_end),
+                     options.delimiter,
+                     expr.get_variable_layout(),
+                     column_slots))
+    {
+        return false;
+    }
+
+    std::vector<Chunk> chunks(options.num_threads);
+
+    for(Chunk& chunk : chunks)
+    {
+        chunk.columns.resize(expr.get_variable_layout().size());
+        chunk.column_ptrs.resize(expr.get_variable_layout().size());
+    }
+
+    auto process = [&](Chunk& chunk) { process_csv_chunk(expr, data, column_slots, options.delimiter, chunk); };
+
+    size_t window_begin = header_end;
+
+    while(window_begin < size)
+    {
+        /* Splits the window into chunks ending on line boundaries, long lines only grow their chunk */
+        size_t num_chunks = 0;
+        size_t chunk_begin = window_begin;
+
+        while(num_chunks < chunks.size() && chunk_begin < size)
+        {
+            const size_t chunk_end = chunk_begin + options.chunk_size >= size
+                                         ? size
+                                         : find_next_line(data, size, chunk_begin + options.chunk_size - 1);
+
+            chunks[num_chunks].begin = chunk_begin;
+            chunks[num_chunks].end = chunk_end;
+
+            num_chunks++;
+            chunk_begin = chunk_end;
+        }
+
+        const std::span<Chunk> window(chunks.data(), num_chunks);
+
+        process_chunks(window, process);
+
+        for(const Chunk& chunk : window)
+        {
+            if(chunk.error_offset != INVALID_ERROR_OFFSET)
+            {
+                const size_t line = std::count(data, data + chunk.error_offset, '\n') + 1;
+
+                mathexpr::log_error("Invalid row at line {} of input file \"{}\"", line, options.input);
+
+                return false;
+            }
+        }
+
+        if(!write_chunks(window, output, options, num_rows))
+            return false;
+
+        input.release(window_begin, chunk_begin);
+
+        window_begin = chunk_begin;
+    }
+
+    num_bytes = size - header_end;
+
+    return true;
+}
+
+bool evaluate_column_file(const mathexpr::Expr& expr,
+                          const Options& options,
+                          FILE* output,
+                          size_t& num_rows,
+                          size_t& num_bytes) noexcept
+{
+    mathexpr::ColumnFile input;
+
+    if(!input.open(options.input))
+        return false;
+
+    std::vector<const double*> columns;
+
+    if(!input.bind(expr.get_variable_layout(), columns))
+        return false;
+
+    std::vector<Chunk> chunks(options.num_threads);
+
+    for(Chunk& chunk : chunks)
+        chunk.column_ptrs.resize(columns.size());
+
+    auto process = [&](Chunk& chunk) { process_column_file_chunk(expr, columns, chunk); };
+
+    const size_t rows_per_chunk = std::max(options.chunk_size / (std::max(columns.size(), size_t(1)) * sizeof(double)),
+                                           size_t(1));
+
+    const size_t size = static_cast<size_t>(input.get_num_rows());
+
+    size_t window_begin = 0;
+
+    while(window_begin < size)
+    {
+        size_t num_chunks = 0;
+        size_t chunk_begin = window_begin;
+
+        while(num_chunks < chunks.size() && chunk_begin < size)
+        {
+            chunks[num_chunks].begin = chunk_begin;
+            chunks[num_chunks].end = std::min(chunk_begin + rows_per_chunk, size);
+
+            chunk_begin = chunks[num_chunks].end;
+            num_chunks++;
+        }
+
+        const std::span<Chunk> window(chunks.data(), num_chunks);
+
+        process_chunks(window, process);
+
+        for(const Chunk& chunk : window)
+        {
+            if(chunk.error_offset != INVALID_ERROR_OFFSET)
+                return false;
+        }
+
+        if(!write_chunks(window, output, options, num_rows))
+            return false;
+
+        input.release_rows(window_begin, chunk_begin);
+
+        window_begin = chunk_begin;
+    }
+
+    num_bytes = size * columns.size() * sizeof(double);
+
+    return true;
+}
+
+/* Returns true if the file starts with the magic of a column file, only its first bytes are read */
+bool is_column_file(const char* path) noexcept
+{
+    FILE* file = std::fopen(path, "rb");
+
+    if(file == nullptr)
+        return false;
+
+    std::byte magic[sizeof(mathexpr::COLUMN_FILE_MAGIC)];
+
+    const size_t size = std::fread(magic, 1, sizeof(magic), file);
+
+    std::fclose(file);
+
+    return mathexpr::ColumnFile::has_magic(magic, size);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if(!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    mathexpr::set_log_level(options.verbose ? mathexpr::LogLevel::Debug : mathexpr::LogLevel::Error);
+
+    mathexpr::Expr expr(options.expression);
+
+    if(!expr.compile(options.verbose ? mathexpr::ExprPrintFlags_PrintAll : 0))
+    {
+        mathexpr::log_error("Error while compiling expression \"{}\"", options.expression);
+        return 1;
+    }
+
+    FILE* output = std::strcmp(options.output, "-") == 0 ? stdout : std::fopen(options.output, "wb");
+
+    if(output == nullptr)
+    {
+        mathexpr::log_error("Cannot open output file \"{}\"", options.output);
+        return 1;
+    }
+
+    size_t num_rows = 0;
+    size_t num_bytes = 0;
+
+    const auto start = Clock::now();
+
+    bool success = is_column_file(options.input) ? evaluate_column_file(expr, options, output, num_rows, num_bytes)
+                                                 : evaluate_csv(expr, options, output, num_rows, num_bytes);
+
+    if(std::fflush(output) != 0)
+        success = false;
+
+    if(output != stdout)
+        std::fclose(output);
+
+    if(!success)
+        return 1;
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cerr << std::format("Evaluated {} rows in {:.3f} s: {:.0f} rows/s, {:.1f} MB/s\n",
+                             num_rows,
+                             seconds,
+                             static_cast<double>(num_rows) / seconds,
+                             static_cast<double>(num_bytes) / (seconds * 1024.0 * 1024.0));
+
+    return 0;
+}